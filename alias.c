@@ -414,3 +414,22 @@ char *cmdConstructor(char *command) {
     /* Return command by default if no other conditions are met */
     return (command);
 }
+
+
+/**
+ * lookupAlias - Find the value of a defined alias.
+ * @name: The alias name.
+ *
+ * Return: A pointer to the value inside definedalias, or NULL if @name is
+ * not an alias.
+ */
+char *lookupAlias(const char *name) {
+    size_t i, len = strlen(name);
+
+    for (i = 0; definedalias != NULL && definedalias[i] != NULL; i++) {
+        if (strncmp(definedalias[i], name, len) == 0 && definedalias[i][len] == '=') {
+            return (definedalias[i] + len + 1);
+        }
+    }
+    return (NULL);
+}
@@ -0,0 +1,569 @@
+#include "main.h"
+#include <limits.h>
+
+#define ARITH_MAX_DEPTH 64
+
+/**
+ * struct arith_state - Cursor over an arithmetic expression.
+ * @expr: The whole expression (for error messages).
+ * @pos: Current parse position.
+ * @noeval: Non-zero while parsing a branch that must not have side effects.
+ * @error: Set to the first error message encountered.
+ * @depth: Recursion depth, guards against self-referencing variables.
+ */
+typedef struct arith_state
+{
+const char *expr;
+const char *pos;
+int noeval;
+const char *error;
+int depth;
+} arith_state;
+
+static long arith_comma(arith_state *st);
+static long arith_assign(arith_state *st);
+static long arith_unary(arith_state *st);
+
+
+/**
+ * arith_skip - Skip blanks in the expression.
+ * @st: Parser state.
+ */
+static void arith_skip(arith_state *st)
+{
+    while (*st->pos == ' ' || *st->pos == '\t' || *st->pos == '\n') {
+        st->pos++;
+    }
+}
+
+/**
+ * arith_fail - Record an error, keeping the first one.
+ * @st: Parser state.
+ * @message: Description of the error.
+ *
+ * Return: Always 0, so callers can return its result as a value.
+ */
+static long arith_fail(arith_state *st, const char *message)
+{
+    if (st->error == NULL) {
+        st->error = message;
+    }
+    return (0);
+}
+
+/**
+ * arith_accept - Consume @op if it is next and is not part of a longer operator.
+ * @st: Parser state.
+ * @op: Operator text.
+ *
+ * Return: 1 if consumed, 0 otherwise.
+ */
+static int arith_accept(arith_state *st, const char *op)
+{
+    size_t len = strlen(op);
+    char next;
+
+    arith_skip(st);
+    if (strncmp(st->pos, op, len) != 0) {
+        return (0);
+    }
+    next = st->pos[len];
+    /* "<" must not eat "<<" or "<=", "&" must not eat "&&" or "&=" ... */
+    if (len == 1 && strchr("<>!&|^+-*/%", op[0]) != NULL
+        && (next == '=' || (next == op[0] && strchr("&|<>+-", next) != NULL))) {
+        return (0);
+    }
+    if (len == 2 && next == '=' && (op[0] == op[1]) && (op[0] == '<' || op[0] == '>')) {
+        return (0);
+    }
+    st->pos += len;
+    return (1);
+}
+
+/**
+ * arith_wrap - Convert the result of unsigned arithmetic back to a long.
+ * @value: The result, modulo 2^N.
+ *
+ * Sums, products, negations and left shifts are done on unsigned long,
+ * where overflow wraps instead of being undefined, as in other shells.
+ *
+ * Return: The two's complement value.
+ */
+static long arith_wrap(unsigned long value)
+{
+    if (value <= (unsigned long)LONG_MAX) {
+        return ((long)value);
+    }
+    return (-(long)(~value) - 1);
+}
+
+/**
+ * arith_value_of - Convert a variable's value to a number.
+ * @st: Parser state.
+ * @name: Variable name.
+ * @len: Length of the name.
+ *
+ * Unset and empty variables are 0, plain constants are converted directly
+ * with the rules of arith_number (so 010 is 8 and 0x10 is 16) and anything
+ * else is evaluated as an expression of its own.
+ *
+ * Return: The numeric value.
+ */
+static long arith_value_of(arith_state *st, const char *name, size_t len)
+{
+    char *value = var_lookup_n(name, len), *end;
+    arith_state sub;
+    long result;
+
+    if (value == NULL || *value == '\0') {
+        return (0);
+    }
+    errno = 0;
+    result = strtol(value, &end, 0);
+    if (end != value && *end == '\0' && errno != ERANGE) {
+        return (result);
+    }
+    if (st->depth >= ARITH_MAX_DEPTH) {
+        return (arith_fail(st, "expression recursion level exceeded"));
+    }
+    sub.expr = value;
+    sub.pos = value;
+    sub.noeval = st->noeval;
+    sub.error = NULL;
+    sub.depth = st->depth + 1;
+    result = arith_comma(&sub);
+    arith_skip(&sub);
+    if (sub.error == NULL && *sub.pos != '\0') {
+        sub.error = "syntax error";
+    }
+    if (sub.error != NULL) {
+        return (arith_fail(st, sub.error));
+    }
+    return (result);
+}
+
+/**
+ * arith_store - Store a number into a variable unless side effects are off.
+ * @st: Parser state.
+ * @name: Variable name.
+ * @len: Length of the name.
+ * @value: Value to store.
+ *
+ * Return: @value.
+ */
+static long arith_store(arith_state *st, const char *name, size_t len, long value)
+{
+    char buffer[256];
+
+    if (st->noeval || st->error != NULL) {
+        return (value);
+    }
+    if (len >= sizeof(buffer)) {
+        return (arith_fail(st, "variable name too long"));
+    }
+    memcpy(buffer, name, len);
+    buffer[len] = '\0';
+    if (var_set_number(buffer, value) != 0) {
+        return (arith_fail(st, "cannot assign"));
+    }
+    return (value);
+}
+
+/**
+ * arith_name - Scan a variable name at the current position.
+ * @st: Parser state.
+ * @len: Receives the name's length.
+ *
+ * Return: Start of the name, or NULL if there is no name here.
+ */
+static const char *arith_name(arith_state *st, size_t *len)
+{
+    const char *start;
+
+    arith_skip(st);
+    start = st->pos;
+    if (*start == '$' && (isalpha((unsigned char)start[1]) || start[1] == '_')) {
+        start++;
+    }
+    if (!isalpha((unsigned char)*start) && *start != '_') {
+        return (NULL);
+    }
+    *len = 0;
+    while (isalnum((unsigned char)start[*len]) || start[*len] == '_') {
+        (*len)++;
+    }
+    return (start);
+}
+
+/**
+ * arith_number - Parse a decimal, octal (0NN) or hexadecimal (0xNN) constant.
+ * @st: Parser state.
+ *
+ * Return: The constant's value.
+ */
+static long arith_number(arith_state *st)
+{
+    char *end;
+    long value;
+
+    errno = 0;
+    value = strtol(st->pos, &end, 0);
+    if (errno == ERANGE) {
+        arith_fail(st, "number out of range");
+    }
+    if (isalnum((unsigned char)*end) || *end == '_') {
+        return (arith_fail(st, "invalid number"));
+    }
+    st->pos = end;
+    return (value);
+}
+
+/**
+ * arith_primary - Parse a constant, variable, parenthesised expression or
+ * postfix increment/decrement.
+ * @st: Parser state.
+ *
+ * Return: The value.
+ */
+static long arith_primary(arith_state *st)
+{
+    const char *name;
+    size_t len;
+    long value;
+
+    arith_skip(st);
+    if (*st->pos == '(') {
+        st->pos++;
+        value = arith_comma(st);
+        if (!arith_accept(st, ")")) {
+            return (arith_fail(st, "missing ')'"));
+        }
+        return (value);
+    }
+    if (isdigit((unsigned char)*st->pos)) {
+        return (arith_number(st));
+    }
+    name = arith_name(st, &len);
+    if (name == NULL) {
+        return (arith_fail(st, *st->pos ? "syntax error" : "expecting primary"));
+    }
+    st->pos = name + len;
+    value = arith_value_of(st, name, len);
+    arith_skip(st);
+    if (strncmp(st->pos, "++", 2) == 0) {
+        st->pos += 2;
+        arith_store(st, name, len, arith_wrap((unsigned long)value + 1));
+    } else if (strncmp(st->pos, "--", 2) == 0) {
+        st->pos += 2;
+        arith_store(st, name, len, arith_wrap((unsigned long)value - 1));
+    }
+    return (value);
+}
+
+/**
+ * arith_unary - Parse unary operators, including prefix ++ and --.
+ * @st: Parser state.
+ *
+ * Return: The value.
+ */
+static long arith_unary(arith_state *st)
+{
+    const char *name;
+    size_t len;
+    int increment;
+
+    arith_skip(st);
+    if (strncmp(st->pos, "++", 2) == 0 || strncmp(st->pos, "--", 2) == 0) {
+        increment = (*st->pos == '+') ? 1 : -1;
+        st->pos += 2;
+        name = arith_name(st, &len);
+        if (name == NULL) {
+            return (arith_fail(st, "increment requires a variable"));
+        }
+        st->pos = name + len;
+        return (arith_store(st, name, len,
+                            arith_wrap((unsigned long)arith_value_of(st, name, len) + increment)));
+    }
+    if (arith_accept(st, "!")) {
+        return (!arith_unary(st));
+    }
+    if (arith_accept(st, "~")) {
+        return (~arith_unary(st));
+    }
+    if (arith_accept(st, "-")) {
+        return (arith_wrap(-(unsigned long)arith_unary(st)));
+    }
+    if (arith_accept(st, "+")) {
+        return (arith_unary(st));
+    }
+    return (arith_primary(st));
+}
+
+/*
+ * Binary operators from loosest to tightest binding (C precedence), with
+ * && and || handled separately because they short-circuit.
+ */
+static const char *binary_levels[][5] = {
+    {"|", NULL},
+    {"^", NULL},
+    {"&", NULL},
+    {"==", "!=", NULL},
+    {"<=", ">=", "<", ">", NULL},
+    {"<<", ">>", NULL},
+    {"+", "-", NULL},
+    {"*", "/", "%", NULL}
+};
+
+#define BINARY_LEVELS ((int)(sizeof(binary_levels) / sizeof(binary_levels[0])))
+
+/**
+ * arith_apply - Apply a binary operator.
+ * @st: Parser state.
+ * @op: Operator text.
+ * @left: Left operand.
+ * @right: Right operand.
+ *
+ * Return: The result.
+ */
+static long arith_apply(arith_state *st, const char *op, long left, long right)
+{
+    switch (op[0]) {
+    case '|': return (left | right);
+    case '^': return (left ^ right);
+    case '&': return (left & right);
+    case '=': return (left == right);
+    case '!': return (left != right);
+    case '+': return (arith_wrap((unsigned long)left + (unsigned long)right));
+    case '-': return (arith_wrap((unsigned long)left - (unsigned long)right));
+    case '*': return (arith_wrap((unsigned long)left * (unsigned long)right));
+    case '<':
+        if (op[1] == '<') {
+            return (arith_wrap((unsigned long)left << (right & 63)));
+        }
+        return (op[1] == '=' ? left <= right : left < right);
+    case '>':
+        if (op[1] == '>') {
+            return (left >> (right & 63));
+        }
+        return (op[1] == '=' ? left >= right : left > right);
+    default:
+        break;
+    }
+    /* Division and remainder */
+    if (right == 0) {
+        if (st->noeval) {
+            return (0);
+        }
+        return (arith_fail(st, "division by zero"));
+    }
+    if (right == -1) {
+        return (op[0] == '/' ? arith_wrap(-(unsigned long)left) : 0);
+    }
+    return (op[0] == '/' ? left / right : left % right);
+}
+
+/**
+ * arith_binary - Parse a left-associative binary operator level.
+ * @st: Parser state.
+ * @level: Index into binary_levels.
+ *
+ * Return: The value.
+ */
+static long arith_binary(arith_state *st, int level)
+{
+    long left, right;
+    const char *op;
+    int i, matched;
+
+    if (level >= BINARY_LEVELS) {
+        return (arith_unary(st));
+    }
+    left = arith_binary(st, level + 1);
+    do {
+        matched = 0;
+        for (i = 0; (op = binary_levels[level][i]) != NULL; i++) {
+            if (arith_accept(st, op)) {
+                right = arith_binary(st, level + 1);
+                left = arith_apply(st, op, left, right);
+                matched = 1;
+                break;
+            }
+        }
+    } while (matched && st->error == NULL);
+    return (left);
+}
+
+/**
+ * arith_logand - Parse && with short-circuit evaluation.
+ * @st: Parser state.
+ *
+ * Return: The value.
+ */
+static long arith_logand(arith_state *st)
+{
+    long left = arith_binary(st, 0);
+    long right;
+
+    while (arith_accept(st, "&&")) {
+        if (!left) {
+            st->noeval++;
+        }
+        right = arith_binary(st, 0);
+        if (!left) {
+            st->noeval--;
+        }
+        left = left && right;
+    }
+    return (left);
+}
+
+/**
+ * arith_logor - Parse || with short-circuit evaluation.
+ * @st: Parser state.
+ *
+ * Return: The value.
+ */
+static long arith_logor(arith_state *st)
+{
+    long left = arith_logand(st);
+    long right;
+
+    while (arith_accept(st, "||")) {
+        if (left) {
+            st->noeval++;
+        }
+        right = arith_logand(st);
+        if (left) {
+            st->noeval--;
+        }
+        left = left || right;
+    }
+    return (left);
+}
+
+/**
+ * arith_ternary - Parse the conditional operator.
+ * @st: Parser state.
+ *
+ * Return: The value.
+ */
+static long arith_ternary(arith_state *st)
+{
+    long condition = arith_logor(st);
+    long when_true, when_false;
+
+    if (!arith_accept(st, "?")) {
+        return (condition);
+    }
+    if (!condition) {
+        st->noeval++;
+    }
+    when_true = arith_comma(st);
+    if (!condition) {
+        st->noeval--;
+    }
+    if (!arith_accept(st, ":")) {
+        return (arith_fail(st, "expecting ':'"));
+    }
+    if (condition) {
+        st->noeval++;
+    }
+    when_false = arith_ternary(st);
+    if (condition) {
+        st->noeval--;
+    }
+    return (condition ? when_true : when_false);
+}
+
+/* Assignment operators; the binary operator is the text before '=' */
+static const char *assign_ops[] = {
+    "<<=", ">>=", "*=", "/=", "%=", "+=", "-=", "&=", "^=", "|=", "=", NULL
+};
+
+/**
+ * arith_assign - Parse a (right-associative) assignment or a conditional.
+ * @st: Parser state.
+ *
+ * Return: The value.
+ */
+static long arith_assign(arith_state *st)
+{
+    const char *start, *name, *op;
+    char binop[3];
+    size_t len, oplen;
+    long value;
+    int i;
+
+    start = st->pos;
+    name = arith_name(st, &len);
+    if (name != NULL) {
+        st->pos = name + len;
+        arith_skip(st);
+        for (i = 0; (op = assign_ops[i]) != NULL; i++) {
+            oplen = strlen(op);
+            if (strncmp(st->pos, op, oplen) == 0 && !(oplen == 1 && st->pos[1] == '=')) {
+                st->pos += oplen;
+                value = arith_assign(st);
+                if (oplen > 1) {
+                    memcpy(binop, op, oplen - 1);
+                    binop[oplen - 1] = '\0';
+                    value = arith_apply(st, binop, arith_value_of(st, name, len), value);
+                }
+                return (arith_store(st, name, len, value));
+            }
+        }
+    }
+    st->pos = start;
+    return (arith_ternary(st));
+}
+
+/**
+ * arith_comma - Parse a comma separated sequence of expressions.
+ * @st: Parser state.
+ *
+ * Return: The value of the last expression.
+ */
+static long arith_comma(arith_state *st)
+{
+    long value = arith_assign(st);
+
+    while (st->error == NULL && arith_accept(st, ",")) {
+        value = arith_assign(st);
+    }
+    return (value);
+}
+
+
+/**
+ * arith_eval - Evaluate the body of an arithmetic expansion $((...)).
+ * @expr: The expression text.
+ * @result: Receives the value on success.
+ *
+ * Integers are C longs; operators and their precedence follow C, including
+ * assignment operators, pre/post increment and short-circuiting && || ?:.
+ * Variables are read from and written to the shell variable store.
+ *
+ * Return: 0 on success, -1 after printing an error message.
+ */
+int arith_eval(const char *expr, long *result)
+{
+    arith_state st;
+
+    st.expr = expr;
+    st.pos = expr;
+    st.noeval = 0;
+    st.error = NULL;
+    st.depth = 0;
+
+    arith_skip(&st);
+    *result = (*st.pos == '\0') ? 0 : arith_comma(&st);
+    arith_skip(&st);
+    if (st.error == NULL && *st.pos != '\0') {
+        st.error = "syntax error";
+    }
+    if (st.error != NULL) {
+        shell_error("arithmetic expression: %s: \"%s\"", st.error, expr);
+        return (-1);
+    }
+    return (0);
+}
@@ -0,0 +1,973 @@
+#include "main.h"
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#define HSHC_MAGIC "HSHC"
+#define HSHC_VERSION 2
+/* Larger scripts are streamed as usual rather than compiled up front */
+#define HSHC_MAX_SCRIPT (16 * 1024 * 1024)
+/* Cache files not used for this long are removed when a new one is stored */
+#define HSHC_MAX_AGE (30L * 24 * 60 * 60)
+/* At most this many are kept; the least recently used go first */
+#define HSHC_MAX_FILES 256
+
+/**
+ * struct hshc_header - Start of a .hshc file, followed by the script's
+ * absolute path and then the serialized commands.
+ * @magic: HSHC_MAGIC.
+ * @version: HSHC_VERSION; bumped whenever the node layout changes.
+ * @path_len: Length of the script path that follows the header.
+ * @commands: Number of top-level commands in the payload.
+ * @mtime_sec: Modification time of the script (seconds).
+ * @mtime_nsec: Modification time of the script (nanoseconds).
+ * @size: Size of the script in bytes.
+ * @hash: FNV-1a hash of the script text.
+ * @payload_len: Length of the payload in bytes.
+ * @payload_hash: FNV-1a hash of the payload, to reject damaged files.
+ */
+typedef struct hshc_header
+{
+char magic[4];
+uint32_t version;
+uint32_t path_len;
+uint32_t commands;
+uint64_t mtime_sec;
+uint64_t mtime_nsec;
+uint64_t size;
+uint64_t hash;
+uint64_t payload_len;
+uint64_t payload_hash;
+} hshc_header;
+
+/**
+ * struct hshc_reader - Cursor over a serialized payload.
+ * @p: Next byte to read.
+ * @end: End of the payload.
+ */
+typedef struct hshc_reader
+{
+const unsigned char *p;
+const unsigned char *end;
+} hshc_reader;
+
+
+/**
+ * fnv1a64 - Hash a block of bytes.
+ * @data: The bytes.
+ * @len: Their number.
+ *
+ * Return: The 64-bit FNV-1a hash.
+ */
+static uint64_t fnv1a64(const void *data, size_t len)
+{
+    const unsigned char *p = data;
+    uint64_t hash = 14695981039346656037UL;
+
+    while (len-- > 0) {
+        hash = (hash ^ *p++) * 1099511628211UL;
+    }
+    return (hash);
+}
+
+
+/**
+ * put_u32 - Append a 32-bit number to a payload.
+ * @sb: The payload.
+ * @value: The number.
+ *
+ * Return: 0 on success, -1 on allocation failure.
+ */
+static int put_u32(string_buffer *sb, uint32_t value)
+{
+    return (sbuf_addn(sb, (const char *)&value, sizeof(value)));
+}
+
+
+/**
+ * put_str - Append a string (NULL allowed) to a payload.
+ * @sb: The payload.
+ * @str: The string.
+ *
+ * Return: 0 on success, -1 on allocation failure.
+ */
+static int put_str(string_buffer *sb, const char *str)
+{
+    size_t len;
+
+    if (str == NULL) {
+        return (put_u32(sb, 0));
+    }
+    len = strlen(str);
+    if (put_u32(sb, len + 1) != 0) {
+        return (-1);
+    }
+    return (sbuf_addn(sb, str, len));
+}
+
+
+/**
+ * put_vec - Append a NULL terminated word list (NULL allowed) to a payload.
+ * @sb: The payload.
+ * @vec: The words.
+ *
+ * Return: 0 on success, -1 on allocation failure.
+ */
+static int put_vec(string_buffer *sb, char **vec)
+{
+    uint32_t count = 0;
+
+    if (vec == NULL) {
+        return (put_u32(sb, 0));
+    }
+    while (vec[count] != NULL) {
+        count++;
+    }
+    if (put_u32(sb, count + 1) != 0) {
+        return (-1);
+    }
+    for (; *vec != NULL; vec++) {
+        if (put_str(sb, *vec) != 0) {
+            return (-1);
+        }
+    }
+    return (0);
+}
+
+
+/**
+ * put_node - Append a syntax tree to a payload, in pre-order.
+ * @sb: The payload.
+ * @node: The tree (NULL allowed).
+ *
+ * Return: 0 on success, -1 on allocation failure.
+ */
+static int put_node(string_buffer *sb, ast_node *node)
+{
+    redirect *r;
+    case_item *item;
+    uint32_t count;
+
+    if (node == NULL) {
+        return (put_u32(sb, 0));
+    }
+    if (put_u32(sb, node->kind + 1) != 0 || put_u32(sb, node->lineno) != 0
+        || put_vec(sb, node->words) != 0 || put_vec(sb, node->assigns) != 0) {
+        return (-1);
+    }
+    for (count = 0, r = node->redirs; r != NULL; r = r->next) {
+        count++;
+    }
+    if (put_u32(sb, count) != 0) {
+        return (-1);
+    }
+    for (r = node->redirs; r != NULL; r = r->next) {
+        if (put_u32(sb, r->fd) != 0 || put_u32(sb, r->kind) != 0
+            || put_u32(sb, r->quoted) != 0 || put_str(sb, r->word) != 0
+            || put_str(sb, r->body) != 0) {
+            return (-1);
+        }
+    }
+    if (put_node(sb, node->left) != 0 || put_node(sb, node->right) != 0
+        || put_node(sb, node->alt) != 0 || put_str(sb, node->name) != 0) {
+        return (-1);
+    }
+    for (count = 0, item = node->cases; item != NULL; item = item->next) {
+        count++;
+    }
+    if (put_u32(sb, count) != 0) {
+        return (-1);
+    }
+    for (item = node->cases; item != NULL; item = item->next) {
+        if (put_vec(sb, item->patterns) != 0 || put_node(sb, item->body) != 0) {
+            return (-1);
+        }
+    }
+    return (0);
+}
+
+
+/**
+ * get_u32 - Read a 32-bit number from a payload.
+ * @rd: The reader.
+ * @value: Where to store the number.
+ *
+ * Return: 0 on success, -1 if the payload is truncated.
+ */
+static int get_u32(hshc_reader *rd, uint32_t *value)
+{
+    if ((size_t)(rd->end - rd->p) < sizeof(*value)) {
+        return (-1);
+    }
+    memcpy(value, rd->p, sizeof(*value));
+    rd->p += sizeof(*value);
+    return (0);
+}
+
+
+/**
+ * get_str - Read a string written by put_str.
+ * @rd: The reader.
+ * @str: Where to store the string (malloc'd, or NULL).
+ *
+ * Return: 0 on success, -1 on error.
+ */
+static int get_str(hshc_reader *rd, char **str)
+{
+    uint32_t len;
+
+    *str = NULL;
+    if (get_u32(rd, &len) != 0) {
+        return (-1);
+    }
+    if (len == 0) {
+        return (0);
+    }
+    if ((size_t)(rd->end - rd->p) < len - 1) {
+        return (-1);
+    }
+    *str = malloc(len);
+    if (*str == NULL) {
+        perror("malloc");
+        return (-1);
+    }
+    memcpy(*str, rd->p, len - 1);
+    (*str)[len - 1] = '\0';
+    rd->p += len - 1;
+    return (0);
+}
+
+
+/**
+ * get_vec - Read a word list written by put_vec.
+ * @rd: The reader.
+ * @vec: Where to store the list (malloc'd, or NULL).
+ *
+ * Return: 0 on success, -1 on error.
+ */
+static int get_vec(hshc_reader *rd, char ***vec)
+{
+    uint32_t count, i;
+
+    *vec = NULL;
+    if (get_u32(rd, &count) != 0) {
+        return (-1);
+    }
+    if (count == 0) {
+        return (0);
+    }
+    if (count - 1 > (size_t)(rd->end - rd->p) / sizeof(uint32_t)) {
+        return (-1);
+    }
+    *vec = calloc(count, sizeof(char *));
+    if (*vec == NULL) {
+        perror("calloc");
+        return (-1);
+    }
+    for (i = 0; i < count - 1; i++) {
+        if (get_str(rd, &(*vec)[i]) != 0) {
+            return (-1);
+        }
+    }
+    return (0);
+}
+
+
+/**
+ * get_node - Rebuild a syntax tree written by put_node.
+ * @rd: The reader.
+ * @out: Where to store the tree (NULL for an empty operand).
+ *
+ * On error the partial tree is still stored in @out for ast_free.
+ *
+ * Return: 0 on success, -1 on error.
+ */
+static int get_node(hshc_reader *rd, ast_node **out)
+{
+    ast_node *node;
+    redirect **rtail;
+    case_item **ctail;
+    uint32_t kind, value, count;
+
+    *out = NULL;
+    if (get_u32(rd, &kind) != 0) {
+        return (-1);
+    }
+    if (kind == 0) {
+        return (0);
+    }
+    node = calloc(1, sizeof(*node));
+    if (node == NULL) {
+        perror("calloc");
+        return (-1);
+    }
+    *out = node;
+    node->kind = kind - 1;
+    if (get_u32(rd, &value) != 0 || get_vec(rd, &node->words) != 0
+        || get_vec(rd, &node->assigns) != 0 || get_u32(rd, &count) != 0) {
+        return (-1);
+    }
+    node->lineno = value;
+    for (rtail = &node->redirs; count > 0; count--) {
+        *rtail = calloc(1, sizeof(**rtail));
+        if (*rtail == NULL) {
+            perror("calloc");
+            return (-1);
+        }
+        if (get_u32(rd, &value) != 0) {
+            return (-1);
+        }
+        (*rtail)->fd = value;
+        if (get_u32(rd, &value) != 0) {
+            return (-1);
+        }
+        (*rtail)->kind = value;
+        if (get_u32(rd, &value) != 0) {
+            return (-1);
+        }
+        (*rtail)->quoted = value;
+        if (get_str(rd, &(*rtail)->word) != 0 || get_str(rd, &(*rtail)->body) != 0) {
+            return (-1);
+        }
+        rtail = &(*rtail)->next;
+    }
+    if (get_node(rd, &node->left) != 0 || get_node(rd, &node->right) != 0
+        || get_node(rd, &node->alt) != 0 || get_str(rd, &node->name) != 0
+        || get_u32(rd, &count) != 0) {
+        return (-1);
+    }
+    for (ctail = &node->cases; count > 0; count--) {
+        *ctail = calloc(1, sizeof(**ctail));
+        if (*ctail == NULL) {
+            perror("calloc");
+            return (-1);
+        }
+        if (get_vec(rd, &(*ctail)->patterns) != 0
+            || get_node(rd, &(*ctail)->body) != 0) {
+            return (-1);
+        }
+        ctail = &(*ctail)->next;
+    }
+    return (0);
+}
+
+
+/**
+ * parse_depends_on_run - Check whether a tree runs a command that can
+ * define aliases: alias itself, or . and source (the file may).
+ * @node: The tree.
+ *
+ * Aliases are expanded while parsing, so such a script has to be parsed
+ * one command at a time, after the previous one ran.
+ *
+ * Return: 1 if it does, 0 otherwise.
+ */
+static int parse_depends_on_run(ast_node *node)
+{
+    case_item *item;
+    char *name;
+
+    if (node == NULL) {
+        return (0);
+    }
+    if (node->kind == NODE_SIMPLE && node->words != NULL && node->words[0] != NULL) {
+        name = node->words[0];
+        if (strcmp(name, "alias") == 0 || strcmp(name, ".") == 0
+            || strcmp(name, "source") == 0) {
+            return (1);
+        }
+    }
+    for (item = node->cases; item != NULL; item = item->next) {
+        if (parse_depends_on_run(item->body)) {
+            return (1);
+        }
+    }
+    return (parse_depends_on_run(node->left) || parse_depends_on_run(node->right)
+            || parse_depends_on_run(node->alt));
+}
+
+
+/**
+ * compile_source - Parse a whole source into a payload.
+ * @src: The input.
+ * @sb: The payload to fill (initialised by the caller), or NULL to only
+ * parse.
+ * @commands: Where to store the number of top-level commands.
+ *
+ * Return: 0 on success, -1 on a syntax error, a script that may define
+ * aliases, or allocation failure.
+ */
+static int compile_source(input_source *src, string_buffer *sb, uint32_t *commands)
+{
+    parser ps;
+    ast_node *tree;
+    int status, result = 0;
+
+    *commands = 0;
+    parser_init(&ps, src);
+    for (;;) {
+        tree = parse_command(&ps, &status);
+        if (status == PARSE_EOF) {
+            break;
+        }
+        if (status == PARSE_EMPTY) {
+            continue;
+        }
+        if (status == PARSE_ERROR || parse_depends_on_run(tree)
+            || (sb != NULL && put_node(sb, tree) != 0)) {
+            ast_free(tree);
+            result = -1;
+            break;
+        }
+        ast_free(tree);
+        (*commands)++;
+    }
+    parser_free(&ps);
+    return (result);
+}
+
+
+/**
+ * cache_file - Work out where the compiled form of a script lives.
+ * @script: Path of the script.
+ * @key: Where to store the script's absolute path (malloc'd).
+ *
+ * Caches live in $XDG_CACHE_HOME/hsh (default ~/.cache/hsh), one file per
+ * script, named after a hash of its absolute path. Nothing is cached when
+ * the base directory ($XDG_CACHE_HOME or $HOME) does not exist: the shell
+ * only ever creates the directories below it.
+ *
+ * Return: The cache file path (malloc'd), or NULL if there is none.
+ */
+static char *cache_file(const char *script, char **key)
+{
+    char *base = getenv("XDG_CACHE_HOME"), *path;
+    const char *suffix = "/hsh";
+    struct stat st;
+    size_t len;
+
+    *key = realpath(script, NULL);
+    if (*key == NULL) {
+        return (NULL);
+    }
+    if (base == NULL || *base == '\0') {
+        base = getenv("HOME");
+        suffix = "/.cache/hsh";
+    }
+    if (base == NULL || *base == '\0' || stat(base, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        free(*key);
+        *key = NULL;
+        return (NULL);
+    }
+    len = strlen(base) + strlen(suffix) + 24;
+    path = malloc(len);
+    if (path == NULL) {
+        perror("malloc");
+        free(*key);
+        *key = NULL;
+        return (NULL);
+    }
+    snprintf(path, len, "%s%s/%016lx.hshc", base, suffix,
+             (unsigned long)fnv1a64(*key, strlen(*key)));
+    return (path);
+}
+
+
+/**
+ * make_parents - Create the missing directories leading to a file.
+ * @path: The file path (temporarily modified).
+ *
+ * Only used on cache paths, whose base directory cache_file found: just
+ * hsh (and .cache when under $HOME) can be missing.
+ */
+static void make_parents(char *path)
+{
+    char *slash;
+
+    for (slash = strchr(path + 1, '/'); slash != NULL; slash = strchr(slash + 1, '/')) {
+        *slash = '\0';
+        mkdir(path, 0700);
+        *slash = '/';
+    }
+}
+
+
+/**
+ * struct hshc_entry - A file of the cache directory, for pruning.
+ * @name: The file name (malloc'd).
+ * @used: When it was last read (access time).
+ */
+typedef struct hshc_entry
+{
+char *name;
+time_t used;
+} hshc_entry;
+
+
+/**
+ * entry_compare - qsort comparison putting recently used files first.
+ * @a: The first entry.
+ * @b: The second.
+ *
+ * Return: Negative, zero or positive.
+ */
+static int entry_compare(const void *a, const void *b)
+{
+    time_t x = ((const hshc_entry *)a)->used, y = ((const hshc_entry *)b)->used;
+
+    return ((x < y) - (x > y));
+}
+
+
+/**
+ * cache_prune - Make room in the cache directory before a file is added.
+ * @dir: Descriptor of the directory; closed.
+ *
+ * Files unused for HSHC_MAX_AGE go, as do temporary files left by a run
+ * that died while storing. The rest is trimmed to HSHC_MAX_FILES - 1 by
+ * access time, which relatime mounts keep to within a day. Only runs on
+ * a cache miss, so hits never pay for it.
+ */
+static void cache_prune(int dir)
+{
+    hshc_entry *entries = NULL, *grown;
+    size_t count = 0, cap = 0, i;
+    time_t now = time(NULL);
+    struct dirent *de;
+    struct stat st;
+    DIR *d;
+
+    d = fdopendir(dir);
+    if (d == NULL) {
+        close(dir);
+        return;
+    }
+    while ((de = readdir(d)) != NULL) {
+        if (strstr(de->d_name, ".hshc") == NULL
+            || fstatat(dirfd(d), de->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0
+            || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        if (now - st.st_atime > HSHC_MAX_AGE
+            || (strstr(de->d_name, ".hshc.") != NULL && now - st.st_mtime > 60 * 60)) {
+            unlinkat(dirfd(d), de->d_name, 0);
+            continue;
+        }
+        if (strstr(de->d_name, ".hshc.") != NULL) {
+            continue;
+        }
+        if (count == cap) {
+            cap = cap ? cap * 2 : 64;
+            grown = realloc(entries, cap * sizeof(*entries));
+            if (grown == NULL) {
+                break;
+            }
+            entries = grown;
+        }
+        entries[count].name = stringdup(de->d_name);
+        entries[count].used = st.st_atime;
+        count += (entries[count].name != NULL);
+    }
+    if (count >= HSHC_MAX_FILES) {
+        qsort(entries, count, sizeof(*entries), entry_compare);
+    }
+    for (i = 0; i < count; i++) {
+        if (i >= HSHC_MAX_FILES - 1) {
+            unlinkat(dirfd(d), entries[i].name, 0);
+        }
+        free(entries[i].name);
+    }
+    free(entries);
+    closedir(d);
+}
+
+
+/**
+ * cache_store - Write a compiled script, replacing any older version.
+ * @cache: Path of the cache file.
+ * @head: The header.
+ * @key: Absolute path of the script.
+ * @payload: The serialized commands.
+ *
+ * The file is written under a temporary name and renamed into place, so
+ * a concurrent run never sees it half written.
+ *
+ * Return: 0 on success, -1 on error.
+ */
+static int cache_store(char *cache, hshc_header *head, const char *key,
+                       const char *payload)
+{
+    char *temp;
+    size_t len = strlen(cache) + 24;
+    int fd, ok;
+
+    temp = malloc(len);
+    if (temp == NULL) {
+        perror("malloc");
+        return (-1);
+    }
+    snprintf(temp, len, "%s.%ld", cache, (long)getpid());
+    make_parents(temp);
+    *strrchr(temp, '/') = '\0';
+    fd = open(temp, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        cache_prune(fd);
+    }
+    snprintf(temp, len, "%s.%ld", cache, (long)getpid());
+    fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        free(temp);
+        return (-1);
+    }
+    ok = write(fd, head, sizeof(*head)) == (ssize_t)sizeof(*head)
+         && write(fd, key, head->path_len) == (ssize_t)head->path_len
+         && write(fd, payload, head->payload_len) == (ssize_t)head->payload_len;
+    if (close(fd) != 0 || !ok || rename(temp, cache) != 0) {
+        unlink(temp);
+        free(temp);
+        return (-1);
+    }
+    free(temp);
+    return (0);
+}
+
+
+/**
+ * cache_map - Map a cache file if it matches the script.
+ * @cache: Path of the cache file.
+ * @head: The expected header; only the script fields are compared.
+ * @key: Absolute path of the script.
+ * @size: Where to store the size of the mapping.
+ *
+ * Return: The mapping, or NULL on a miss.
+ */
+static char *cache_map(const char *cache, const hshc_header *head, const char *key,
+                       size_t *size)
+{
+    const hshc_header *found;
+    struct stat st;
+    char *map;
+    int fd;
+
+    fd = open(cache, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return (NULL);
+    }
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(*found)) {
+        close(fd);
+        return (NULL);
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return (NULL);
+    }
+    *size = st.st_size;
+    found = (const hshc_header *)map;
+    if (memcmp(found->magic, HSHC_MAGIC, 4) != 0 || found->version != HSHC_VERSION
+        || found->mtime_sec != head->mtime_sec || found->mtime_nsec != head->mtime_nsec
+        || found->size != head->size || found->hash != head->hash
+        || found->path_len != head->path_len
+        || sizeof(*found) + found->path_len + found->payload_len != *size
+        || memcmp(map + sizeof(*found), key, head->path_len) != 0
+        || fnv1a64(map + *size - found->payload_len, found->payload_len)
+           != found->payload_hash) {
+        munmap(map, *size);
+        return (NULL);
+    }
+    return (map);
+}
+
+
+/**
+ * script_header - Fill in the script fields of a cache header.
+ * @head: The header.
+ * @path: Path of the script.
+ * @src: The script, read whole by source_open_file.
+ * @key: Absolute path of the script.
+ *
+ * Return: 0 on success, -1 if the script cannot be cached.
+ */
+static int script_header(hshc_header *head, const char *path, input_source *src,
+                         const char *key)
+{
+    struct stat st;
+
+    if (!src->whole || src->len > HSHC_MAX_SCRIPT || stat(path, &st) != 0) {
+        return (-1);
+    }
+    memset(head, 0, sizeof(*head));
+    memcpy(head->magic, HSHC_MAGIC, 4);
+    head->version = HSHC_VERSION;
+    head->path_len = strlen(key);
+    head->mtime_sec = st.st_mtim.tv_sec;
+    head->mtime_nsec = st.st_mtim.tv_nsec;
+    head->size = src->len;
+    head->hash = fnv1a64(src->buf, src->len);
+    return (0);
+}
+
+
+/**
+ * run_payload - Run the commands of a compiled script.
+ * @payload: The serialized commands.
+ * @len: Length of the payload.
+ * @commands: Number of top-level commands.
+ *
+ * Commands are rebuilt one at a time, just before they run.
+ *
+ * Return: The exit status of the last command.
+ */
+static int run_payload(const char *payload, size_t len, uint32_t commands)
+{
+    hshc_reader rd;
+    ast_node *tree;
+
+    rd.p = (const unsigned char *)payload;
+    rd.end = rd.p + len;
+    for (; commands > 0; commands--) {
+        if (get_node(&rd, &tree) != 0) {
+            ast_free(tree);
+            break;
+        }
+        if (run_tree(tree, 0)) {
+            break;
+        }
+    }
+    return (last_exit_status);
+}
+
+
+/**
+ * compile_script - Compile a script read whole and store it in the cache.
+ * @src: The script; rewound afterwards.
+ * @head: Header with the script fields filled in; completed here.
+ * @cache: Path of the cache file.
+ * @key: Absolute path of the script.
+ * @sb: Receives the payload (initialised here).
+ *
+ * Return: 0 on success, -1 if the script cannot be compiled.
+ */
+static int compile_script(input_source *src, hshc_header *head, char *cache,
+                          const char *key, string_buffer *sb)
+{
+    uint32_t commands;
+    int result;
+
+    sbuf_init(sb);
+    result = compile_source(src, sb, &commands);
+    src->pos = 0;
+    src->lineno = 1;
+    if (result != 0) {
+        return (-1);
+    }
+    head->commands = commands;
+    head->payload_len = sb->len;
+    head->payload_hash = fnv1a64(sb->data, sb->len);
+    cache_store(cache, head, key, sb->data);
+    return (0);
+}
+
+
+/**
+ * script_cache_run - Run a script from its compiled form.
+ * @src: The script, opened with source_open_file.
+ * @path: Path of the script.
+ * @status: Where to store the exit status.
+ *
+ * A cache hit skips lexing and parsing altogether. On a miss the script is
+ * compiled and cached first, with syntax errors silenced: such scripts are
+ * left to run_source, which reports them at the right point of the run.
+ * Nothing is cached while aliases are defined, since trees are parsed
+ * without them.
+ *
+ * Return: 0 if the script was run, -1 if it must be run from source.
+ */
+int script_cache_run(input_source *src, const char *path, int *status)
+{
+    hshc_header head, *found;
+    string_buffer sb;
+    char *cache, *key, *map;
+    size_t size;
+    int saved_err, null, result = -1;
+
+    if (definedalias != NULL && definedalias[0] != NULL) {
+        return (-1);
+    }
+    cache = cache_file(path, &key);
+    if (cache == NULL) {
+        return (-1);
+    }
+    if (script_header(&head, path, src, key) == 0) {
+        map = cache_map(cache, &head, key, &size);
+        if (map != NULL) {
+            found = (hshc_header *)map;
+            *status = run_payload(map + size - found->payload_len,
+                                  found->payload_len, found->commands);
+            munmap(map, size);
+            result = 0;
+        } else {
+            saved_err = dup(STDERR_FILENO);
+            null = open("/dev/null", O_WRONLY);
+            if (saved_err >= 0 && null >= 0) {
+                dup2(null, STDERR_FILENO);
+                close(null);
+                result = compile_script(src, &head, cache, key, &sb);
+                dup2(saved_err, STDERR_FILENO);
+                close(saved_err);
+                if (result == 0) {
+                    *status = run_payload(sb.data, sb.len, head.commands);
+                }
+                sbuf_free(&sb);
+            } else {
+                close(null);
+                close(saved_err);
+            }
+        }
+    }
+    free(cache);
+    free(key);
+    return (result);
+}
+
+
+/**
+ * script_compile - Compile scripts into the cache: hsh --compile file...
+ * @paths: NULL terminated list of scripts.
+ *
+ * Return: 0 if every script was compiled, 1 otherwise.
+ */
+int script_compile(char **paths)
+{
+    input_source src;
+    hshc_header head;
+    string_buffer sb;
+    char *cache, *key;
+    int status = 0;
+
+    for (; *paths != NULL; paths++) {
+        if (source_open_file(&src, *paths) != 0) {
+            shell_error("Can't open %s", *paths);
+            status = 1;
+            continue;
+        }
+        cache = cache_file(*paths, &key);
+        if (cache == NULL || script_header(&head, *paths, &src, key) != 0
+            || compile_script(&src, &head, cache, key, &sb) != 0) {
+            shell_error("%s: cannot compile", *paths);
+            status = 1;
+        } else {
+            sbuf_free(&sb);
+        }
+        free(cache);
+        free(key);
+        source_free(&src);
+    }
+    return (status);
+}
+
+
+/**
+ * elapsed_ms - Milliseconds between two monotonic clock readings.
+ * @start: The earlier reading.
+ * @end: The later reading.
+ *
+ * Return: The difference.
+ */
+static double elapsed_ms(const struct timespec *start, const struct timespec *end)
+{
+    return ((end->tv_sec - start->tv_sec) * 1e3 + (end->tv_nsec - start->tv_nsec) / 1e6);
+}
+
+
+/**
+ * load_payload - Rebuild and discard every command of a payload.
+ * @payload: The serialized commands.
+ * @len: Its length.
+ * @commands: Number of top-level commands.
+ */
+static void load_payload(const char *payload, size_t len, uint32_t commands)
+{
+    hshc_reader rd;
+    ast_node *tree;
+
+    rd.p = (const unsigned char *)payload;
+    rd.end = rd.p + len;
+    for (; commands > 0; commands--) {
+        get_node(&rd, &tree);
+        ast_free(tree);
+    }
+}
+
+
+/**
+ * script_cache_bench - Compare parsing a script with loading it from the
+ * cache: hsh --cache-bench file [rounds]
+ * @path: Path of the script.
+ * @rounds: Number of timed runs of each.
+ *
+ * Nothing is executed; both sides stop once the syntax trees are built.
+ *
+ * Return: 0 on success, 1 if the script cannot be compiled.
+ */
+int script_cache_bench(const char *path, int rounds)
+{
+    struct timespec start, end;
+    input_source src;
+    hshc_header head, *found;
+    uint32_t commands;
+    char *cache, *key, *map, *paths[2];
+    size_t size;
+    double cold, warm;
+    int i;
+
+    if (rounds < 1) {
+        rounds = 1;
+    }
+    paths[0] = (char *)path;
+    paths[1] = NULL;
+    if (script_compile(paths) != 0) {
+        return (1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < rounds; i++) {
+        if (source_open_file(&src, path) != 0) {
+            return (1);
+        }
+        compile_source(&src, NULL, &commands);
+        source_free(&src);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    cold = elapsed_ms(&start, &end) / rounds;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < rounds; i++) {
+        if (source_open_file(&src, path) != 0) {
+            return (1);
+        }
+        cache = cache_file(path, &key);
+        map = NULL;
+        if (cache != NULL && script_header(&head, path, &src, key) == 0) {
+            map = cache_map(cache, &head, key, &size);
+        }
+        if (map == NULL) {
+            shell_error("%s: cache miss", path);
+            return (1);
+        }
+        found = (hshc_header *)map;
+        load_payload(map + size - found->payload_len, found->payload_len,
+                     found->commands);
+        munmap(map, size);
+        free(cache);
+        free(key);
+        source_free(&src);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    warm = elapsed_ms(&start, &end) / rounds;
+
+    printf("cold parse: %d runs, %.3f ms/run\n", rounds, cold);
+    printf("cache hit:  %d runs, %.3f ms/run (%.1fx)\n", rounds, warm,
+           warm > 0 ? cold / warm : 0.0);
+    return (0);
+}
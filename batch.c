@@ -0,0 +1,306 @@
+#define _GNU_SOURCE
+#include "main.h"
+#include <sys/mman.h>
+
+/* Upper bound on -j, keeping the captured outputs within the fd limit */
+#define BATCH_MAX_JOBS 256
+
+/**
+ * struct batch_job - One line of a batch file.
+ * @offset: Start of the command in the file.
+ * @len: Length of the command.
+ * @lineno: Line number of the command.
+ * @pid: Process running it, or 0 once reaped.
+ * @out: Captured standard output, or -1.
+ * @err: Captured standard error, or -1.
+ * @status: Exit status, valid once @done is set.
+ * @done: Non-zero when the process has finished.
+ */
+typedef struct batch_job
+{
+size_t offset;
+size_t len;
+int lineno;
+pid_t pid;
+int out;
+int err;
+int status;
+int done;
+} batch_job;
+
+
+/**
+ * capture_open - Create an in-memory file to collect a job's output.
+ *
+ * Return: A read-write descriptor, or -1 on error.
+ */
+static int capture_open(void)
+{
+    int fd = memfd_create("hsh-batch", MFD_CLOEXEC);
+
+    if (fd == -1) {
+        fd = open("/tmp", O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    }
+    return (fd);
+}
+
+
+/**
+ * capture_flush - Copy captured output to its destination and close it.
+ * @fd: The capture file.
+ * @dest: Descriptor to write to.
+ */
+static void capture_flush(int fd, int dest)
+{
+    char buffer[65536];
+    ssize_t count;
+
+    if (lseek(fd, 0, SEEK_SET) == 0) {
+        while ((count = read(fd, buffer, sizeof(buffer))) > 0) {
+            write_all(dest, buffer, count);
+        }
+    }
+    close(fd);
+}
+
+
+/**
+ * batch_split - Find the commands of a batch file, one per line.
+ * @text: The file contents.
+ * @len: Their length.
+ * @count: Where to store the number of commands.
+ *
+ * Blank lines and comment lines are skipped.
+ *
+ * Return: The jobs (malloc'd), or NULL on allocation failure.
+ */
+static batch_job *batch_split(const char *text, size_t len, size_t *count)
+{
+    batch_job *jobs = NULL, *grown;
+    size_t pos = 0, start, cap = 0;
+    const char *nl;
+    int lineno = 0;
+
+    *count = 0;
+    while (pos < len) {
+        nl = memchr(text + pos, '\n', len - pos);
+        start = pos;
+        pos = (nl != NULL) ? (size_t)(nl - text) + 1 : len;
+        lineno++;
+        while (start < pos && (text[start] == ' ' || text[start] == '\t')) {
+            start++;
+        }
+        if (start == pos || text[start] == '\n' || text[start] == '#') {
+            continue;
+        }
+        if (*count == cap) {
+            cap = cap ? cap * 2 : 256;
+            grown = realloc(jobs, cap * sizeof(*jobs));
+            if (grown == NULL) {
+                perror("realloc");
+                free(jobs);
+                return (NULL);
+            }
+            jobs = grown;
+        }
+        jobs[*count].offset = start;
+        jobs[*count].len = pos - start;
+        jobs[*count].lineno = lineno;
+        jobs[*count].pid = 0;
+        jobs[*count].out = -1;
+        jobs[*count].err = -1;
+        jobs[*count].status = 0;
+        jobs[*count].done = 0;
+        (*count)++;
+    }
+    if (jobs == NULL) {
+        jobs = malloc(sizeof(*jobs));
+        if (jobs == NULL) {
+            perror("malloc");
+        }
+    }
+    return (jobs);
+}
+
+
+/**
+ * batch_start - Start one job in a child shell with its output captured.
+ * @job: The job.
+ * @text: The batch file contents.
+ *
+ * Return: 0 on success, -1 on error (the job is then marked failed).
+ */
+static int batch_start(batch_job *job, const char *text)
+{
+    input_source src;
+    char *command;
+    int null;
+
+    job->out = capture_open();
+    job->err = capture_open();
+    if (job->out == -1 || job->err == -1) {
+        perror("memfd_create");
+        return (-1);
+    }
+    job->pid = fork();
+    if (job->pid == 0) {
+        null = open("/dev/null", O_RDONLY);
+        if (null > 0) {
+            dup2(null, STDIN_FILENO);
+            close(null);
+        }
+        dup2(job->out, STDOUT_FILENO);
+        dup2(job->err, STDERR_FILENO);
+        out_retarget();
+        command = strndup(text + job->offset, job->len);
+        if (command == NULL) {
+            _exit(2);
+        }
+        source_init_string(&src, command);
+        src.lineno = job->lineno;
+        out_exit(run_source(&src, EXEC_NOFORK));
+    }
+    if (job->pid == -1) {
+        perror("fork");
+        job->pid = 0;
+        return (-1);
+    }
+    return (0);
+}
+
+
+/**
+ * batch_reap - Wait for any running job and record its status.
+ * @jobs: All jobs.
+ * @started: Number of jobs started so far.
+ */
+static void batch_reap(batch_job *jobs, size_t started)
+{
+    pid_t pid;
+    size_t i;
+    int status;
+
+    do {
+        pid = waitpid(-1, &status, 0);
+    } while (pid == -1 && errno == EINTR);
+    if (pid <= 0) {
+        return;
+    }
+    for (i = 0; i < started; i++) {
+        if (jobs[i].pid == pid) {
+            jobs[i].pid = 0;
+            jobs[i].done = 1;
+            jobs[i].status = WIFEXITED(status) ? WEXITSTATUS(status)
+                             : 128 + WTERMSIG(status);
+            return;
+        }
+    }
+}
+
+
+/**
+ * batch_summary - Report the failed commands of a batch on stderr.
+ * @jobs: All jobs.
+ * @count: Number of jobs.
+ * @text: The batch file contents.
+ *
+ * Return: 0 if every command succeeded, 123 otherwise (as xargs does).
+ */
+static int batch_summary(batch_job *jobs, size_t count, const char *text)
+{
+    size_t i, failed = 0;
+    int len;
+
+    for (i = 0; i < count; i++) {
+        if (jobs[i].status == 0) {
+            continue;
+        }
+        failed++;
+        len = (int)jobs[i].len;
+        if (len > 0 && text[jobs[i].offset + len - 1] == '\n') {
+            len--;
+        }
+        fprintf(stderr, "%s: line %d: exit %d: %.*s\n", shell_name,
+                jobs[i].lineno, jobs[i].status, len, text + jobs[i].offset);
+    }
+    fprintf(stderr, "%s: %lu commands, %lu succeeded, %lu failed\n", shell_name,
+            (unsigned long)count, (unsigned long)(count - failed), (unsigned long)failed);
+    return (failed > 0 ? 123 : 0);
+}
+
+
+/**
+ * batch_run - Run each line of a file as an independent command, at most
+ * N at a time: hsh -j N file
+ * @jobs_arg: N, the number of concurrent children, as given on the command
+ * line; parsed here and rejected unless it is from 1 to BATCH_MAX_JOBS.
+ * @path: The batch file.
+ *
+ * Outputs are captured per command and written in input order, stdout to
+ * stdout and stderr to stderr, as soon as every earlier command has
+ * finished. No more than 2 * N commands are in flight or waiting
+ * to be printed, which bounds the open capture files.
+ *
+ * Return: 0 if every command succeeded, 123 if some failed, 2 on error.
+ */
+int batch_run(const char *jobs_arg, char *path)
+{
+    input_source src;
+    batch_job *jobs;
+    size_t count, started = 0, running = 0, printed = 0;
+    long jobs_max;
+    char *end;
+    int status;
+
+    errno = 0;
+    jobs_max = strtol(jobs_arg, &end, 10);
+    if (*jobs_arg == '\0' || *end != '\0' || errno == ERANGE
+        || jobs_max < 1 || jobs_max > BATCH_MAX_JOBS) {
+        shell_error("-j: Illegal number: %s (1 to %d)", jobs_arg, BATCH_MAX_JOBS);
+        return (2);
+    }
+    if (source_open_file(&src, path) != 0) {
+        shell_error("Can't open %s", path);
+        return (2);
+    }
+    while (src.refill != NULL && src.refill(&src)) {
+    }
+    jobs = batch_split(src.buf, src.len, &count);
+    if (jobs == NULL) {
+        source_free(&src);
+        return (2);
+    }
+    shell_name = path;
+    fflush(stdout);
+
+    while (printed < count) {
+        while (started < count && running < (size_t)jobs_max
+               && started - printed < 2 * (size_t)jobs_max) {
+            if (batch_start(&jobs[started], src.buf) == 0) {
+                running++;
+            } else {
+                jobs[started].done = 1;
+                jobs[started].status = 2;
+            }
+            started++;
+        }
+        while (printed < started && jobs[printed].done) {
+            if (jobs[printed].out != -1) {
+                capture_flush(jobs[printed].out, STDOUT_FILENO);
+            }
+            if (jobs[printed].err != -1) {
+                capture_flush(jobs[printed].err, STDERR_FILENO);
+            }
+            printed++;
+        }
+        if (printed < count && running > 0) {
+            batch_reap(jobs, started);
+            running--;
+        }
+    }
+
+    status = batch_summary(jobs, count, src.buf);
+    free(jobs);
+    source_free(&src);
+    return (status);
+}
@@ -1,62 +1,5 @@
 #include "main.h"
-
-/**
- * execute_exit - Execute the built-in exit command.
- * plus arguments for the built-in exit
- * exit status, where status is an integer used to
- * exit the shell.
- *
- * @input: The input command.
- */
-void execute_exit(char *input) {
-char *trimmed_input = input;
-size_t input_length = 0;
-int status = 0;
-
-/* Trim leading and trailing spaces */
-while (*trimmed_input == ' ' || *trimmed_input == '\t') {
-trimmed_input++;
-}
-
-input_length = strlen(trimmed_input);
-
-while (input_length > 0 && (trimmed_input[input_length - 1] == ' ' || trimmed_input[input_length - 1] == '\t')) {
-input_length--;
-}
-
-trimmed_input[input_length] = '\0';
-
-/* Check if the trimmed input is "exit" */
-if (strcmp(trimmed_input, "exit") == 0) {
-free(input);
-exit(0); /* Exit the shell with status 0 */
-} else if (strncmp(trimmed_input, "exit ", 5) == 0) {
-/* Check if the trimmed input starts with "exit " */
-
-/* If yes, extract the status and exit with that status */
-if (is_integer(trimmed_input + 5)) {
-status = atoi(trimmed_input + 5);
-if (status >= 0) {
-free(input);
-exit(status);
-} else {
-write(STDERR_FILENO, "./hsh: 1: exit: Illegal number: ", 32);
-write(STDERR_FILENO, trimmed_input + 5, strlen(trimmed_input + 5));
-write(STDERR_FILENO, "\n", 1);
-free(input);
-exit(2); /* Exit with status 2 for an invalid exit command */
-}
-}
-} else {
-/* The input is not a valid exit command */
-write(STDERR_FILENO, "Invalid command: ", 17);
-write(STDERR_FILENO, trimmed_input, strlen(trimmed_input));
-write(STDERR_FILENO, "\n", 1);
-free(input);
-exit(2); /* Exit with status 2 for an invalid command */
-}
-}
-
+#include <time.h>
 
 /**
  * execute_env - Execute the built-in env command.
@@ -94,8 +37,8 @@ sorted_env[env_count] = NULL;
 /* Print the sorted environment variables */
 for (i = 0; i < env_count; i++)
 {
-write(STDOUT_FILENO, sorted_env[i], stringlen(sorted_env[i]));
-write(STDOUT_FILENO, "\n", 1);
+out_puts(sorted_env[i]);
+out_write("\n", 1);
 }
 
 /* Free allocated memory */
@@ -103,148 +46,753 @@ free(sorted_env);
 }
 
 
+/**
+ * builtin_exit - Leave the shell: exit [status].
+ * @argv: Argument vector.
+ *
+ * Return: 2 if the status is not a number (the shell keeps running only
+ * when interactive).
+ */
+static int builtin_exit(char **argv)
+{
+    if (argv[1] == NULL) {
+        exit(last_exit_status);
+    }
+    if (!is_integer(argv[1]) || argv[1][0] == '-') {
+        shell_error("exit: Illegal number: %s", argv[1]);
+        if (!isInteractiveMode()) {
+            exit(2);
+        }
+        return (2);
+    }
+    exit(atoi(argv[1]) & 0xff);
+}
+
 
 /**
-* execute_separator - Execute commands separated by ';'.
-*
-* @input: The input commands.
-*/
-void execute_separator(char *input)
+ * builtin_env - Print the environment.
+ * @argv: Argument vector (unused).
+ *
+ * Return: 0.
+ */
+static int builtin_env(char **argv)
 {
-char *command = stringtok(input, ";\n");
-while (command != NULL)
+    (void)argv;
+    execute_env();
+    return (0);
+}
+
+
+/**
+ * builtin_setenv - setenv NAME VALUE and unsetenv NAME.
+ * @argv: Argument vector.
+ *
+ * Return: 0.
+ */
+static int builtin_setenv(char **argv)
 {
-get_system(command);
-command = stringtok(NULL, ";\n");
+    char *input = concatTokens(argv, " ");
+
+    if (input != NULL) {
+        process_env_command(input);
+        free(input);
+    }
+    return (0);
 }
+
+
+/**
+ * builtin_alias - Define or print aliases: alias [name[=value]...].
+ * @argv: Argument vector.
+ *
+ * Return: 0, or 1 if a named alias does not exist.
+ */
+static int builtin_alias(char **argv)
+{
+    string_buffer sb;
+    char *definition, *equal, *value;
+    int i, status = 0;
+
+    for (i = 0; argv[1] == NULL && definedalias != NULL && definedalias[i] != NULL; i++) {
+        equal = strchr(definedalias[i], '=');
+        sbuf_init(&sb);
+        sbuf_addn(&sb, definedalias[i], equal - definedalias[i] + 1);
+        sbuf_addc(&sb, '\'');
+        sbuf_adds(&sb, equal + 1);
+        sbuf_adds(&sb, "'\n");
+        out_write(sb.data, sb.len);
+        sbuf_free(&sb);
+    }
+    for (i = 1; argv[i] != NULL; i++) {
+        equal = strchr(argv[i], '=');
+        sbuf_init(&sb);
+        if (equal != NULL) {
+            /* addAlias takes the definition in its written form */
+            sbuf_adds(&sb, "alias ");
+            sbuf_addn(&sb, argv[i], equal - argv[i] + 1);
+            sbuf_addc(&sb, '\'');
+            sbuf_adds(&sb, equal + 1);
+            sbuf_addc(&sb, '\'');
+            definition = sbuf_finish(&sb);
+            addAlias(definition);
+            free(definition);
+            continue;
+        }
+        value = lookupAlias(argv[i]);
+        if (value == NULL) {
+            shell_error("alias: %s not found", argv[i]);
+            status = 1;
+            continue;
+        }
+        sbuf_adds(&sb, argv[i]);
+        sbuf_adds(&sb, "='");
+        sbuf_adds(&sb, value);
+        sbuf_adds(&sb, "'\n");
+        out_write(sb.data, sb.len);
+        sbuf_free(&sb);
+    }
+    return (status);
 }
 
 
 /**
-* execute_logical_operators - Execute commands with logical operators.
-*
-* @command: The input commands.
-**/
+ * builtin_export - Export variables: export name[=value]...
+ * @argv: Argument vector.
+ *
+ * Return: 0, or 2 on a bad variable name.
+ */
+static int builtin_export(char **argv)
+{
+    char *name, *equal;
+    int i;
 
-void execute_logical_operator(char *command) {
-    char *token;
-    char *delimiter = "&&";
-    int result = 1;
-    char *trimmed_token;
-    char *end;
-    int execution_status;
-    char *or_token;
-    char *second_command;
-    int or_execution_status;
+    for (i = 1; argv[i] != NULL; i++) {
+        name = stringdup(argv[i]);
+        if (name == NULL) {
+            return (2);
+        }
+        equal = strchr(name, '=');
+        if (equal != NULL) {
+            *equal = '\0';
+        }
+        if (var_export(name, equal != NULL ? equal + 1 : NULL) != 0) {
+            shell_error("export: %s: bad variable name", name);
+            free(name);
+            return (2);
+        }
+        free(name);
+    }
+    return (0);
+}
 
-    /* Tokenize the command based on delimiters && */
-    token = strtok(command, delimiter);
 
-    while (token != NULL) {
-        /* Remove leading and trailing white spaces */
-        trimmed_token = token;
-        while (*trimmed_token == ' ') {
-            ++trimmed_token;
+/**
+ * builtin_unset - Remove variables or functions: unset [-fv] name...
+ * @argv: Argument vector.
+ *
+ * Return: 0.
+ */
+static int builtin_unset(char **argv)
+{
+    int i = 1, functions = 0;
+
+    for (; argv[i] != NULL && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        if (strcmp(argv[i], "--") == 0) {
+            i++;
+            break;
+        }
+        if (strcmp(argv[i], "-f") == 0) {
+            functions = 1;
+        } else if (strcmp(argv[i], "-v") == 0) {
+            functions = 0;
+        } else {
+            shell_error("unset: Illegal option %s", argv[i]);
+            return (2);
+        }
+    }
+    for (; argv[i] != NULL; i++) {
+        if (functions) {
+            func_unset(argv[i]);
+        } else {
+            var_unset(argv[i]);
         }
+    }
+    return (0);
+}
+
+
+/**
+ * builtin_local - Make variables local to the running function:
+ * local name[=value]...
+ * @argv: Argument vector.
+ *
+ * Return: 0 on success, 2 outside a function or on a bad name.
+ */
+static int builtin_local(char **argv)
+{
+    int i;
+    char *eq, *name;
 
-        end = trimmed_token + strlen(trimmed_token) - 1;
-        while (end > trimmed_token && *end == ' ') {
-            *end-- = '\0';
+    if (func_depth == 0) {
+        shell_error("local: not in a function");
+        return (2);
+    }
+    for (i = 1; argv[i] != NULL; i++) {
+        eq = strchr(argv[i], '=');
+        name = eq ? strndup(argv[i], eq - argv[i]) : strdup(argv[i]);
+        if (name == NULL) {
+            perror("malloc");
+            return (2);
+        }
+        if (!is_valid_name(name, strlen(name))) {
+            shell_error("local: %s: bad variable name", name);
+            free(name);
+            return (2);
         }
+        if (var_make_local(name) != 0 || (eq && var_set(name, eq + 1) != 0)) {
+            free(name);
+            return (2);
+        }
+        free(name);
+    }
+    return (0);
+}
 
-        /* Check for || in the trimmed token and skip it */
-        if (strstr(trimmed_token, "||") != NULL) {
-            token = strtok(NULL, delimiter);
-            continue;
+
+/**
+ * builtin_return - Leave the running function or sourced script: return [n]
+ * @argv: Argument vector.
+ *
+ * Return: n, or the status of the last command.
+ */
+static int builtin_return(char **argv)
+{
+    int status = last_exit_status;
+
+    if (argv[1] != NULL) {
+        if (!is_integer(argv[1])) {
+            shell_error("return: Illegal number: %s", argv[1]);
+            return (2);
         }
+        status = atoi(argv[1]) & 0xff;
+    }
+    pending_return = 1;
+    return (status);
+}
 
-        execution_status = get_system(trimmed_token);
-        if (execution_status == -1) {
-            if (isInteractiveMode() && errno == ENOENT) {
-                free(command);
-                exit(2);
-            }
-        } else if (execution_status != 0) {
-            result = 0;
+
+/**
+ * builtin_shift - Drop leading positional parameters: shift [n]
+ * @argv: Argument vector.
+ *
+ * Return: 0 on success, 2 if n is invalid or too large.
+ */
+static int builtin_shift(char **argv)
+{
+    int count = 1;
+
+    if (argv[1] != NULL) {
+        count = is_integer(argv[1]) ? atoi(argv[1]) : -1;
+        if (count < 0) {
+            shell_error("shift: Illegal number: %s", argv[1]);
+            return (2);
         }
+    }
+    if (count > positional_count) {
+        shell_error("shift: can't shift that many");
+        return (2);
+    }
+    positional_params += count;
+    positional_count -= count;
+    return (0);
+}
 
-        token = strtok(NULL, delimiter);
+
+/**
+ * loop_count - Parse the optional level argument of break and continue.
+ * @argv: Argument vector.
+ *
+ * Return: The number of loops to leave, at most the current depth; 0 on error.
+ */
+static int loop_count(char **argv)
+{
+    int count = 1;
+
+    if (argv[1] != NULL) {
+        count = is_integer(argv[1]) ? atoi(argv[1]) : 0;
+        if (count <= 0) {
+            shell_error("%s: Illegal number: %s", argv[0], argv[1]);
+            return (0);
+        }
     }
+    return (count > loop_depth ? loop_depth : count);
+}
 
-    if (!result) {
-        /* If any command failed, execute the second part after || */
-        or_token = strstr(command, "||");
-        if (or_token != NULL) {
-            second_command = or_token + 2; /* Skip the || */
-            /* Remove leading and trailing white spaces */
-            while (*second_command == ' ') {
-                ++second_command;
-            }
-            or_execution_status = get_system(second_command);
-            if (or_execution_status == -1) {
-                if (isInteractiveMode() && errno == ENOENT) {
-                    free(command);
-                    exit(2);
+
+/**
+ * builtin_break - Leave the innermost (or n-th) enclosing loop.
+ * @argv: Argument vector.
+ *
+ * Return: 0.
+ */
+static int builtin_break(char **argv)
+{
+    pending_break = loop_count(argv);
+    return (0);
+}
+
+
+/**
+ * builtin_continue - Start the next iteration of the innermost (or n-th)
+ * enclosing loop.
+ * @argv: Argument vector.
+ *
+ * Return: 0.
+ */
+static int builtin_continue(char **argv)
+{
+    pending_continue = loop_count(argv);
+    return (0);
+}
+
+
+/**
+ * builtin_source - Run a file's commands in the current shell:
+ * . file [args...] (also spelled source)
+ * @argv: Argument vector.
+ *
+ * A name without a slash is looked up in PATH, then in the current
+ * directory. Arguments, if any, replace the positional parameters while
+ * the file runs. A return in the file ends it.
+ *
+ * Return: The status of the last command run, 2 if the file can't be read.
+ */
+static int builtin_source(char **argv)
+{
+    input_source src;
+    char *path, **saved_params = positional_params;
+    int status, saved_count = positional_count, saved_lineno = shell_lineno;
+
+    if (argv[1] == NULL) {
+        shell_error("%s: filename argument required", argv[0]);
+        return (2);
+    }
+    path = (strchr(argv[1], '/') == NULL) ? search_path(argv[1], R_OK) : NULL;
+    if (source_open_file(&src, path != NULL ? path : argv[1]) != 0) {
+        shell_error("%s: cannot open %s", argv[0], argv[1]);
+        free(path);
+        return (2);
+    }
+    if (argv[2] != NULL) {
+        positional_params = argv + 2;
+        positional_count = 0;
+        while (argv[positional_count + 2] != NULL) {
+            positional_count++;
+        }
+    }
+    last_exit_status = 0;
+    if (script_cache_run(&src, path != NULL ? path : argv[1], &status) != 0) {
+        status = run_source(&src, 0);
+    }
+    source_free(&src);
+    free(path);
+    if (argv[2] != NULL) {
+        positional_params = saved_params;
+        positional_count = saved_count;
+    }
+    shell_lineno = saved_lineno;
+    return (status);
+}
+
+
+/**
+ * builtin_history - List the command history: history [n]
+ * @argv: Argument vector.
+ *
+ * Return: 0, or 2 on a bad count.
+ */
+static int builtin_history(char **argv)
+{
+    size_t count = history_count(), first = 0, len, i;
+    const char *text;
+
+    if (argv[1] != NULL) {
+        if (!is_integer(argv[1])) {
+            shell_error("history: Illegal number: %s", argv[1]);
+            return (2);
+        }
+        len = strtoul(argv[1], NULL, 10);
+        first = (len < count) ? count - len : 0;
+    }
+    for (i = first; i < count; i++) {
+        text = history_get(i, &len);
+        out_printf("%5lu  %.*s\n", (unsigned long)i + 1, (int)len, text);
+    }
+    return (0);
+}
+
+
+/**
+ * builtin_colon - The null command, also true.
+ * @argv: Argument vector (unused).
+ *
+ * Return: 0.
+ */
+static int builtin_colon(char **argv)
+{
+    (void)argv;
+    return (0);
+}
+
+
+/**
+ * builtin_false - Fail: false
+ * @argv: Argument vector (unused).
+ *
+ * Return: 1.
+ */
+static int builtin_false(char **argv)
+{
+    (void)argv;
+    return (1);
+}
+
+
+/**
+ * builtin_sleep - Wait: sleep number[smhd]...
+ * @argv: Argument vector.
+ *
+ * As GNU sleep: the numbers may have fractions and a unit suffix (seconds
+ * by default), and several are added up. Like it, strtod's hex forms
+ * (0x10) and "inf" are accepted, and NaN is not. Running inside the shell
+ * spares polling loops a fork and exec per round.
+ *
+ * Return: 0, or 1 on an invalid interval.
+ */
+static int builtin_sleep(char **argv)
+{
+    struct timespec left;
+    double total = 0, value;
+    char *end;
+    int i;
+
+    if (argv[1] == NULL) {
+        shell_error("sleep: missing operand");
+        return (1);
+    }
+    for (i = 1; argv[i] != NULL; i++) {
+        value = strtod(argv[i], &end);
+        if (end == argv[i] || value != value || value < 0 || (end[0] != '\0' && (end[1] != '\0'
+                                                               || strchr("smhd", end[0]) == NULL))) {
+            shell_error("sleep: invalid time interval '%s'", argv[i]);
+            return (1);
+        }
+        total += value * (end[0] == 'm' ? 60 : end[0] == 'h' ? 3600 : end[0] == 'd' ? 86400 : 1);
+    }
+    out_flush();
+    if (total > 1e9) {
+        total = 1e9;
+    }
+    left.tv_sec = (time_t)total;
+    left.tv_nsec = (long)((total - left.tv_sec) * 1e9);
+    while (nanosleep(&left, &left) != 0 && errno == EINTR) {
+    }
+    return (0);
+}
+
+
+static int builtin_enable(char **argv);
+
+static builtin_entry builtin_table[] = {
+    {"exit", builtin_exit, 1},
+    {"env", builtin_env, 0},
+    {"cd", builtin_cd, 0},
+    {"setenv", builtin_setenv, 0},
+    {"unsetenv", builtin_setenv, 0},
+    {"alias", builtin_alias, 0},
+    {"export", builtin_export, 1},
+    {"unset", builtin_unset, 1},
+    {"break", builtin_break, 1},
+    {"continue", builtin_continue, 1},
+    {":", builtin_colon, 1},
+    {".", builtin_source, 1},
+    {"source", builtin_source, 1},
+    {"history", builtin_history, 0},
+    {"return", builtin_return, 1},
+    {"shift", builtin_shift, 1},
+    {"local", builtin_local, 0},
+    {"echo", builtin_echo, 0},
+    {"printf", builtin_printf, 0},
+    {"test", builtin_test, 0},
+    {"[", builtin_test, 0},
+    {"read", builtin_read, 0},
+    {"pushd", builtin_pushd, 0},
+    {"popd", builtin_popd, 0},
+    {"dirs", builtin_dirs, 0},
+    {"true", builtin_colon, 0},
+    {"false", builtin_false, 0},
+    {"pwd", builtin_pwd, 0},
+    {"sleep", builtin_sleep, 0},
+    {"enable", builtin_enable, 0},
+    {NULL, NULL, 0}
+};
+
+/* Generated by tools/builtin_hash.c from builtin_table; do not edit */
+#define BUILTIN_COUNT 30
+#define BUILTIN_HASH_SEED 2166141697u
+#define BUILTIN_HASH_BITS 6
+#define BUILTIN_NAMES_HASH 3949936859u
+static const unsigned char builtin_slots[64] = {
+    0, 0, 0, 1, 10, 23, 0, 0, 0, 17, 3, 0, 28, 0, 25, 0,
+    9, 18, 0, 0, 0, 24, 16, 26, 0, 0, 0, 0, 27, 0, 5, 0,
+    13, 12, 2, 0, 0, 30, 0, 0, 0, 0, 20, 4, 15, 0, 0, 6,
+    0, 0, 21, 0, 7, 0, 29, 0, 0, 22, 8, 19, 0, 11, 0, 14
+};
+/* End of generated code */
+
+/* Builtins turned off with enable -n, by table position */
+static unsigned char builtin_disabled[BUILTIN_COUNT];
+
+/* A table edited without running tools/builtin_hash.c fails to compile */
+typedef char builtin_slots_current[(sizeof(builtin_table) / sizeof(builtin_table[0])
+                                    == BUILTIN_COUNT + 1) ? 1 : -1];
+
+/* 0 until the names are checked, then 1 if they match builtin_slots, -1 if not */
+static int builtin_names_ok;
+
+
+/**
+ * builtin_names_hash - Hash the names of builtin_table in order, as
+ * tools/builtin_hash.c does for BUILTIN_NAMES_HASH.
+ *
+ * Return: FNV-1a of the names, each with its terminating NUL.
+ */
+static unsigned int builtin_names_hash(void)
+{
+    unsigned int h = 2166136261u;
+    const char *p;
+    int i;
+
+    for (i = 0; builtin_table[i].name != NULL; i++) {
+        p = builtin_table[i].name;
+        do {
+            h = (h ^ (unsigned char)*p) * 16777619u;
+        } while (*p++ != '\0');
+    }
+    return (h);
+}
+
+
+/**
+ * builtin_check - Make sure builtin_slots was generated from this table.
+ *
+ * The size is checked at compile time; a name renamed or moved without
+ * running the generator is caught here, on the first lookup, and lookups
+ * then walk the table instead.
+ */
+static void builtin_check(void)
+{
+    builtin_names_ok = 1;
+    if (builtin_names_hash() != BUILTIN_NAMES_HASH) {
+        shell_error("builtin table out of date; run tools/builtin_hash.c");
+        builtin_names_ok = -1;
+    }
+}
+
+
+/**
+ * builtin_hash - Find the slot of a command name in builtin_slots.
+ * @name: The command name.
+ *
+ * FNV-1a with a seed chosen so that no two builtins share a slot.
+ *
+ * Return: The slot.
+ */
+static unsigned int builtin_hash(const char *name)
+{
+    unsigned int h = BUILTIN_HASH_SEED;
+
+    while (*name != '\0') {
+        h = (h ^ (unsigned char)*name++) * 16777619u;
+    }
+    return ((h ^ (h >> 15)) & ((1u << BUILTIN_HASH_BITS) - 1));
+}
+
+
+/**
+ * builtin_index - Find a command name in builtin_table, enabled or not.
+ * @name: The command name.
+ *
+ * One hash and one comparison, whatever the size of the table; the table
+ * is walked instead if builtin_check found builtin_slots out of date.
+ *
+ * Return: The index of the entry, or -1 if @name is not a builtin.
+ */
+static int builtin_index(const char *name)
+{
+    unsigned int slot;
+
+    if (builtin_names_ok <= 0) {
+        if (builtin_names_ok == 0) {
+            builtin_check();
+        }
+        if (builtin_names_ok < 0) {
+            for (slot = 0; builtin_table[slot].name != NULL; slot++) {
+                if (strcmp(builtin_table[slot].name, name) == 0) {
+                    break;
                 }
             }
+            slot = (builtin_table[slot].name != NULL) ? slot + 1 : 0;
         }
     }
+    if (builtin_names_ok > 0) {
+        slot = builtin_slots[builtin_hash(name)];
+    }
+    if (slot != 0 && strcmp(builtin_table[slot - 1].name, name) == 0) {
+        return ((int)slot - 1);
+    }
+    return (-1);
 }
 
 
+/**
+ * find_builtin - Look up a command implemented by the shell.
+ * @name: The command name.
+ *
+ * Return: The table entry, or NULL if @name is not a builtin or was
+ * disabled with enable -n.
+ */
+builtin_entry *find_builtin(const char *name)
+{
+    int index = builtin_index(name);
 
+    if (index < 0 || builtin_disabled[index]) {
+        return (NULL);
+    }
+    return (&builtin_table[index]);
+}
 
 
 /**
- * execute_with_variable_replacement - Execute a command with variable replacement
- * @command: The command to execute
+ * dispatch_scan - Look up a builtin by walking the table, for comparison.
+ * @name: The command name.
  *
- * Return: 0 on successful execution, 1 on failure.
-**/
-int execute_with_variable_replacement(char *command) {
-    FILE *status_file;
-    char *position;
-    char *buffer;
-    size_t buffer_size = 1024;
-    int exit_status;
+ * Return: The table entry, or NULL if @name is not a builtin.
+ */
+static builtin_entry *dispatch_scan(const char *name)
+{
+    int i;
 
-    buffer = (char *)malloc(buffer_size * sizeof(char));
-    if (buffer == NULL) {
-        fprintf(stderr, "Memory allocation failed\n");
-        return (1); /* Return an error value indicating failure */
+    for (i = 0; builtin_table[i].name != NULL; i++) {
+        if (stringcmp(builtin_table[i].name, name) == 0) {
+            return (&builtin_table[i]);
+        }
     }
+    return (NULL);
+}
 
-    /* Replace $$ with the process id */
-    while ((position = strstr(command, "$$")) != NULL) {
-        *position = '\0';
-        snprintf(buffer, buffer_size, "%s%d%s", command, getpid(), position + 2);
-        strcpy(command, buffer);
-    }
 
-    /* Replace $? with the exit status of the last command */
-    while ((position = strstr(command, "$?")) != NULL) {
-        *position = '\0';
-        system("echo $? > .hsh_status");
-        status_file = fopen(".hsh_status", "r");
-        fscanf(status_file, "%d", &exit_status);
-        fclose(status_file);
-        snprintf(buffer, buffer_size, "%s%d%s", command, exit_status, position + 2);
-        strcpy(command, buffer);
+/**
+ * dispatch_time - Time lookups of every builtin and a few other commands.
+ * @lookup: The lookup function.
+ * @rounds: Number of passes over the names.
+ *
+ * Return: Nanoseconds per lookup.
+ */
+static double dispatch_time(builtin_entry *(*lookup)(const char *), long rounds)
+{
+    static const char *const others[] = {"ls", "cat", "grep", "sed", "git", "make",
+                                         "cp", "printenv", NULL};
+    volatile size_t found = 0;
+    struct timespec start, end;
+    long round, lookups = 0;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (round = 0; round < rounds; round++) {
+        for (i = 0; builtin_table[i].name != NULL; i++) {
+            found += (lookup(builtin_table[i].name) != NULL);
+        }
+        for (i = 0; others[i] != NULL; i++) {
+            found += (lookup(others[i]) != NULL);
+        }
+        lookups += i + BUILTIN_COUNT;
     }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / lookups);
+}
 
-    /* Replace $PATH with the actual PATH environment variable */
-    while ((position = strstr(command, "$PATH")) != NULL) {
-        *position = '\0';
-        snprintf(buffer, buffer_size, "%s%s%s", command, getenv("PATH"), position + 5);
-        strcpy(command, buffer);
+
+/**
+ * dispatch_bench - Measure the cost of recognising a command word:
+ * hsh --dispatch-bench [rounds]
+ * @rounds: Number of passes over the names.
+ *
+ * Return: 0.
+ */
+int dispatch_bench(long rounds)
+{
+    if (rounds < 1) {
+        rounds = 1;
     }
+    printf("%-12s %.1f ns/lookup\n", "perfect hash", dispatch_time(find_builtin, rounds));
+    printf("%-12s %.1f ns/lookup\n", "table scan", dispatch_time(dispatch_scan, rounds));
+    return (0);
+}
+
+
+/**
+ * builtin_enable - Turn builtins off or back on: enable [-n] [name...]
+ * @argv: Argument vector.
+ *
+ * With -n the named builtins are disabled, so the command is looked up in
+ * PATH as if the shell did not implement it: the policy switch for
+ * scripts that need the external true, false, pwd, sleep and so on.
+ * Without names, the enabled builtins (or with -n the disabled ones) are
+ * listed as enable commands.
+ *
+ * Return: 0, or 1 if a name is not a builtin.
+ */
+static int builtin_enable(char **argv)
+{
+    unsigned int slot;
+    int off = 0, status = 0, i = 1, index;
 
-    /* Execute the command */
-    if (system(command) == -1) {
-        free(buffer);
-        return (1); /* Return an error value indicating failure */
+    if (argv[1] != NULL && strcmp(argv[1], "-n") == 0) {
+        off = 1;
+        i++;
+    }
+    if (argv[i] == NULL) {
+        for (slot = 0; slot < BUILTIN_COUNT; slot++) {
+            if (builtin_disabled[slot] == off) {
+                out_printf("enable %s%s\n", off ? "-n " : "", builtin_table[slot].name);
+            }
+        }
+        return (0);
+    }
+    for (; argv[i] != NULL; i++) {
+        index = builtin_index(argv[i]);
+        if (index < 0) {
+            shell_error("enable: %s: not a shell builtin", argv[i]);
+            status = 1;
+            continue;
+        }
+        builtin_disabled[index] = (unsigned char)off;
     }
+    return (status);
+}
 
-    free(buffer); /* Free the dynamically allocated memory */
-    return (0); /* Return 0 on successful execution */
+
+/**
+ * builtin_name - Get the name of a builtin, for completion.
+ * @index: Position in the builtin table.
+ *
+ * Return: The name, or NULL past the end of the table.
+ */
+const char *builtin_name(size_t index)
+{
+    if (index >= sizeof(builtin_table) / sizeof(builtin_table[0])) {
+        return (NULL);
+    }
+    return (builtin_table[index].name);
 }
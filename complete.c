@@ -0,0 +1,524 @@
+#include "main.h"
+#include <dirent.h>
+#include <limits.h>
+
+/* Characters escaped with a backslash when completing an unquoted word */
+#define COMPLETE_SPECIAL " \t\n\\'\"`$&|;<>()*?[]#{}!"
+
+/**
+ * struct name_list - A sorted set of names, searched by prefix.
+ * @text: Each name preceded by its d_type byte and followed by a NUL,
+ * back to back in one allocation.
+ * @offsets: Offset of each name in @text while the list is built.
+ * @cap: Allocated size of @offsets.
+ * @names: Pointers to the names in @text, sorted and without duplicates.
+ * @count: Number of names.
+ */
+typedef struct name_list
+{
+string_buffer text;
+size_t *offsets;
+size_t cap;
+char **names;
+size_t count;
+} name_list;
+
+/* Command names, rebuilt when PATH or one of its directories changes */
+static name_list commands;
+static unsigned long commands_stamp;
+
+/* Entries of the directory completed last, reread when it changes */
+static name_list files;
+static char *files_dir;
+static struct stat files_stat;
+
+/* Words after which a command name is expected */
+static const char *const command_words[] = {
+    "if", "then", "else", "elif", "while", "until", "do", "!", "{", "time", NULL
+};
+
+
+/**
+ * names_reset - Empty a name list.
+ * @list: The list.
+ */
+static void names_reset(name_list *list)
+{
+    sbuf_free(&list->text);
+    sbuf_init(&list->text);
+    free(list->offsets);
+    free(list->names);
+    list->offsets = NULL;
+    list->names = NULL;
+    list->cap = 0;
+    list->count = 0;
+}
+
+
+/**
+ * names_add - Add a name to a list being built.
+ * @list: The list.
+ * @name: The name.
+ * @type: Its d_type.
+ *
+ * Return: 0 on success, -1 on allocation failure.
+ */
+static int names_add(name_list *list, const char *name, unsigned char type)
+{
+    size_t *grown;
+
+    if (list->count == list->cap) {
+        list->cap = list->cap ? list->cap * 2 : 256;
+        grown = realloc(list->offsets, list->cap * sizeof(size_t));
+        if (grown == NULL) {
+            perror("realloc");
+            return (-1);
+        }
+        list->offsets = grown;
+    }
+    if (sbuf_addc(&list->text, (char)type) != 0) {
+        return (-1);
+    }
+    list->offsets[list->count++] = list->text.len;
+    if (sbuf_adds(&list->text, name) != 0 || sbuf_addc(&list->text, '\0') != 0) {
+        return (-1);
+    }
+    return (0);
+}
+
+
+/**
+ * names_compare - qsort comparison of two names.
+ * @a: The first name.
+ * @b: The second name.
+ *
+ * Return: As strcmp.
+ */
+static int names_compare(const void *a, const void *b)
+{
+    return (strcmp(*(char *const *)a, *(char *const *)b));
+}
+
+
+/**
+ * names_finish - Sort a built list and drop duplicate names.
+ * @list: The list.
+ *
+ * Return: 0 on success, -1 on allocation failure (the list is emptied).
+ */
+static int names_finish(name_list *list)
+{
+    size_t i, kept = 0;
+
+    list->names = malloc((list->count + 1) * sizeof(char *));
+    if (list->names == NULL) {
+        perror("malloc");
+        names_reset(list);
+        return (-1);
+    }
+    for (i = 0; i < list->count; i++) {
+        list->names[i] = list->text.data + list->offsets[i];
+    }
+    free(list->offsets);
+    list->offsets = NULL;
+    list->cap = 0;
+    qsort(list->names, list->count, sizeof(char *), names_compare);
+    for (i = 0; i < list->count; i++) {
+        if (kept == 0 || strcmp(list->names[kept - 1], list->names[i]) != 0) {
+            list->names[kept++] = list->names[i];
+        }
+    }
+    list->count = kept;
+    return (0);
+}
+
+
+/**
+ * names_range - Find the names starting with a prefix.
+ * @list: The list.
+ * @prefix: The prefix.
+ * @len: Its length.
+ * @first: Where to store the index of the first match.
+ *
+ * Return: The number of matches, which are consecutive in the list.
+ */
+static size_t names_range(name_list *list, const char *prefix, size_t len, size_t *first)
+{
+    size_t lo = 0, hi = list->count, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (strncmp(list->names[mid], prefix, len) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *first = lo;
+    hi = list->count;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (strncmp(list->names[mid], prefix, len) == 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo - *first);
+}
+
+
+/**
+ * path_next - Get the next directory of PATH.
+ * @path: Read position in PATH, advanced past the directory.
+ * @dir: Where to store the directory (PATH_MAX bytes).
+ *
+ * Return: 1 if a directory was stored, 0 at the end of PATH.
+ */
+static int path_next(const char **path, char *dir)
+{
+    const char *end;
+    size_t len;
+
+    if (*path == NULL) {
+        return (0);
+    }
+    end = strchr(*path, ':');
+    len = (end != NULL) ? (size_t)(end - *path) : strlen(*path);
+    if (len == 0) {
+        strcpy(dir, ".");
+    } else {
+        if (len >= PATH_MAX) {
+            len = PATH_MAX - 1;
+        }
+        memcpy(dir, *path, len);
+        dir[len] = '\0';
+    }
+    *path = (end != NULL) ? end + 1 : NULL;
+    return (1);
+}
+
+
+/**
+ * stamp_mix - Fold bytes into a change stamp (FNV-1a).
+ * @stamp: The stamp so far.
+ * @data: The bytes.
+ * @len: Their number.
+ *
+ * Return: The new stamp.
+ */
+static unsigned long stamp_mix(unsigned long stamp, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+
+    while (len-- > 0) {
+        stamp = (stamp ^ *p++) * 16777619UL;
+    }
+    return (stamp);
+}
+
+
+/**
+ * commands_refresh - Bring the command name list up to date.
+ *
+ * The list holds the builtins, the reserved words and every non-directory
+ * in the PATH directories. It is rebuilt only when PATH is set to another
+ * value or a directory in it is modified, which a handful of stat calls
+ * detect on each completion.
+ */
+static void commands_refresh(void)
+{
+    const char *path = var_lookup("PATH"), *p;
+    unsigned long stamp = 2166136261UL;
+    char dir[PATH_MAX];
+    struct dirent *entry;
+    struct stat st;
+    DIR *handle;
+    size_t i;
+
+    p = path;
+    while (path_next(&p, dir)) {
+        stamp = stamp_mix(stamp, dir, strlen(dir) + 1);
+        if (stat(dir, &st) == 0) {
+            stamp = stamp_mix(stamp, &st.st_dev, sizeof(st.st_dev));
+            stamp = stamp_mix(stamp, &st.st_ino, sizeof(st.st_ino));
+            stamp = stamp_mix(stamp, &st.st_mtim, sizeof(st.st_mtim));
+        }
+    }
+    if (commands.names != NULL && stamp == commands_stamp) {
+        return;
+    }
+
+    names_reset(&commands);
+    for (i = 0; builtin_name(i) != NULL; i++) {
+        names_add(&commands, builtin_name(i), DT_UNKNOWN);
+    }
+    for (i = 0; prefixes[i] != NULL; i++) {
+        names_add(&commands, prefixes[i], DT_UNKNOWN);
+    }
+    p = path;
+    while (path_next(&p, dir)) {
+        handle = opendir(dir);
+        if (handle == NULL) {
+            continue;
+        }
+        while ((entry = readdir(handle)) != NULL) {
+            if (entry->d_name[0] != '.' && entry->d_type != DT_DIR) {
+                names_add(&commands, entry->d_name, entry->d_type);
+            }
+        }
+        closedir(handle);
+    }
+    if (names_finish(&commands) == 0) {
+        commands_stamp = stamp;
+    }
+}
+
+
+/**
+ * files_load - Make the file list hold the entries of a directory.
+ * @dir: The directory.
+ *
+ * The entries are read once and kept, sorted, until the directory is
+ * modified, so repeated completion in a large directory costs one stat
+ * and a binary search.
+ *
+ * Return: 0 on success, -1 if the directory cannot be read.
+ */
+static int files_load(const char *dir)
+{
+    struct dirent *entry;
+    struct stat st;
+    DIR *handle;
+
+    if (stat(dir, &st) != 0) {
+        return (-1);
+    }
+    if (files.names != NULL && strcmp(files_dir, dir) == 0 && st.st_dev == files_stat.st_dev
+        && st.st_ino == files_stat.st_ino
+        && st.st_mtim.tv_sec == files_stat.st_mtim.tv_sec
+        && st.st_mtim.tv_nsec == files_stat.st_mtim.tv_nsec) {
+        return (0);
+    }
+    names_reset(&files);
+    free(files_dir);
+    files_dir = strdup(dir);
+    handle = opendir(dir);
+    if (files_dir == NULL || handle == NULL) {
+        if (handle != NULL) {
+            closedir(handle);
+        }
+        return (-1);
+    }
+    while ((entry = readdir(handle)) != NULL) {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+            names_add(&files, entry->d_name, entry->d_type);
+        }
+    }
+    closedir(handle);
+    files_stat = st;
+    return (names_finish(&files));
+}
+
+
+/**
+ * command_word - Check whether a word leaves a command name expected next.
+ * @word: The word.
+ * @len: Its length.
+ *
+ * Return: 1 for reserved words such as "then" and for assignments.
+ */
+static int command_word(const char *word, size_t len)
+{
+    size_t i;
+
+    for (i = 0; command_words[i] != NULL; i++) {
+        if (strlen(command_words[i]) == len && strncmp(command_words[i], word, len) == 0) {
+            return (1);
+        }
+    }
+    for (i = 0; i < len && (word[i] == '_' || isalnum((unsigned char)word[i])); i++) {
+    }
+    return (i > 0 && i < len && word[i] == '=' && !isdigit((unsigned char)word[0]));
+}
+
+
+/**
+ * complete_word - Find the word before the cursor and its context.
+ * @line: The line.
+ * @pos: The cursor offset.
+ * @word: Where to store the word with its quoting removed.
+ * @quote: Where to store the quote left open in the word, or 0.
+ *
+ * Return: 1 if a command name is expected, 0 for a file name.
+ */
+static int complete_word(const char *line, size_t pos, string_buffer *word, char *quote)
+{
+    size_t i, start = 0;
+    int command = 1, redirect = 0;
+    char q = 0, c;
+
+    for (i = 0; i < pos; i++) {
+        c = line[i];
+        if (q == '\'') {
+            q = (c == '\'') ? 0 : q;
+        } else if (q == '"') {
+            if (c == '\\') {
+                i++;
+            } else if (c == '"') {
+                q = 0;
+            }
+        } else if (c == '\\') {
+            i++;
+        } else if (c == '\'' || c == '"') {
+            q = c;
+        } else if (strchr(" \t\n;&|()<>", c) != NULL) {
+            if (i > start && !redirect) {
+                command = command && command_word(line + start, i - start);
+            }
+            if (i > start) {
+                redirect = 0;
+            }
+            if (c == '<' || c == '>') {
+                redirect = 1;
+            } else if (c != ' ' && c != '\t') {
+                command = 1;
+            }
+            start = i + 1;
+        }
+    }
+
+    *quote = 0;
+    for (i = start; i < pos; i++) {
+        c = line[i];
+        if (*quote == '\'' && c != '\'') {
+            sbuf_addc(word, c);
+        } else if (c == *quote) {
+            *quote = 0;
+        } else if (*quote == 0 && (c == '\'' || c == '"')) {
+            *quote = c;
+        } else if (c == '\\' && i + 1 < pos && (*quote == 0 || strchr("\\\"$`", line[i + 1]))) {
+            sbuf_addc(word, line[++i]);
+        } else {
+            sbuf_addc(word, c);
+        }
+    }
+    return (command && !redirect);
+}
+
+
+/**
+ * complete_find - List the completions of the word before the cursor.
+ * @line: The line.
+ * @pos: The cursor offset.
+ * @comp: Where to store the completions.
+ *
+ * A word in command position without a slash is completed from the
+ * command names, anything else from the files of its directory. The
+ * names stored in @comp stay valid until the next call.
+ *
+ * Return: 0 on success, -1 if the word cannot be completed.
+ */
+int complete_find(const char *line, size_t pos, completion *comp)
+{
+    string_buffer word, dir;
+    const char *base, *home;
+    name_list *list = &commands;
+    size_t first;
+    int command;
+
+    memset(comp, 0, sizeof(*comp));
+    sbuf_init(&word);
+    sbuf_init(&dir);
+    if (sbuf_reserve(&word, 0) != 0) {
+        return (-1);
+    }
+    command = complete_word(line, pos, &word, &comp->quote);
+    if (word.data[0] == '$') {
+        sbuf_free(&word);
+        return (-1);
+    }
+    base = strrchr(word.data, '/');
+    if (command && base == NULL) {
+        commands_refresh();
+        base = word.data;
+    } else {
+        home = var_lookup("HOME");
+        if (base == NULL) {
+            sbuf_adds(&dir, ".");
+            base = word.data;
+        } else {
+            if (word.data[0] == '~' && word.data[1] == '/' && home != NULL) {
+                sbuf_adds(&dir, home);
+                sbuf_addn(&dir, word.data + 1, base + 1 - (word.data + 1));
+            } else {
+                sbuf_addn(&dir, word.data, base + 1 - word.data);
+            }
+            base++;
+        }
+        if (dir.data == NULL || files_load(dir.data) != 0) {
+            sbuf_free(&word);
+            sbuf_free(&dir);
+            return (-1);
+        }
+        list = &files;
+        comp->dir = files_dir;
+    }
+    comp->typed = strlen(base);
+    comp->count = names_range(list, base, comp->typed, &first);
+    comp->names = list->names + first;
+    sbuf_free(&word);
+    sbuf_free(&dir);
+    return (0);
+}
+
+
+/**
+ * complete_is_dir - Check whether a completion names a directory.
+ * @comp: The completions.
+ * @index: Which one.
+ *
+ * Entries the directory listing did not type (symbolic links, some file
+ * systems) are looked up once and the answer kept in the list.
+ *
+ * Return: 1 for a directory, 0 otherwise.
+ */
+int complete_is_dir(const completion *comp, size_t index)
+{
+    unsigned char *type = (unsigned char *)comp->names[index] - 1;
+    char path[PATH_MAX];
+    struct stat st;
+
+    if (comp->dir == NULL) {
+        return (0);
+    }
+    if (*type == DT_LNK || *type == DT_UNKNOWN) {
+        *type = DT_REG;
+        if ((size_t)snprintf(path, sizeof(path), "%s/%s", comp->dir, comp->names[index])
+            < sizeof(path) && stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+            *type = DT_DIR;
+        }
+    }
+    return (*type == DT_DIR);
+}
+
+
+/**
+ * complete_escape - Append completed text quoted to fit the word.
+ * @sb: Where to append.
+ * @text: The text.
+ * @len: Its length.
+ * @quote: The quote open in the word, or 0.
+ */
+void complete_escape(string_buffer *sb, const char *text, size_t len, char quote)
+{
+    const char *special = (quote == 0) ? COMPLETE_SPECIAL : "\\\"$`";
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if (quote != '\'' && strchr(special, text[i]) != NULL) {
+            sbuf_addc(sb, '\\');
+        }
+        sbuf_addc(sb, text[i]);
+    }
+}
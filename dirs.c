@@ -0,0 +1,549 @@
+#include "main.h"
+
+/* Stack descriptors are kept at or above this, clear of redirections */
+#define DIR_FD_MIN 10
+
+/* Options of dirs */
+#define DIRS_LONG 1
+#define DIRS_LINES 2
+#define DIRS_NUMBERED 4
+
+/**
+ * struct dir_entry - A directory saved by pushd.
+ * @path: Its logical path (malloc'd).
+ * @fd: An O_DIRECTORY descriptor for it, or -1 if it could not be opened.
+ */
+typedef struct dir_entry
+{
+char *path;
+int fd;
+} dir_entry;
+
+/**
+ * struct dir_state - The working directory as the shell tracks it.
+ * @cwd: The logical path (malloc'd), NULL until first needed. It keeps
+ * the symbolic links the user went through, and is what PWD holds.
+ * @stack: Directories saved by pushd; the last one is the top.
+ * @count: Number of them.
+ * @cap: Allocated entries.
+ *
+ * Returning to a saved directory is an fchdir on its descriptor, so the
+ * path is neither resolved again nor asked back from getcwd.
+ */
+typedef struct dir_state
+{
+char *cwd;
+dir_entry *stack;
+size_t count;
+size_t cap;
+} dir_state;
+
+static dir_state dirs;
+
+
+/**
+ * dir_logical - Get the logical working directory.
+ *
+ * An inherited $PWD is kept if it really names the current directory;
+ * otherwise getcwd is asked, once.
+ *
+ * Return: The path, or NULL if it is unknown.
+ */
+const char *dir_logical(void)
+{
+    const char *pwd = getenv("PWD");
+    struct stat here, there;
+
+    if (dirs.cwd == NULL) {
+        if (pwd != NULL && *pwd == '/' && stat(pwd, &there) == 0 && stat(".", &here) == 0
+            && here.st_dev == there.st_dev && here.st_ino == there.st_ino) {
+            dirs.cwd = stringdup(pwd);
+        } else {
+            dirs.cwd = getcwd(NULL, 0);
+        }
+    }
+    return (dirs.cwd);
+}
+
+
+/**
+ * dir_join - Make the logical path of a directory.
+ * @base: The logical working directory (may be NULL).
+ * @path: The directory as given to cd.
+ *
+ * "." and empty components are dropped and ".." removes the component
+ * before it, without looking at the file system, as cd -L does.
+ *
+ * Return: The absolute path (malloc'd), or NULL if it cannot be made.
+ */
+static char *dir_join(const char *base, const char *path)
+{
+    const char *parts[2], *p, *end;
+    string_buffer sb;
+    char *slash;
+    size_t len;
+    int k;
+
+    if (*path != '/' && base == NULL) {
+        return (NULL);
+    }
+    parts[0] = (*path == '/') ? "" : base;
+    parts[1] = path;
+    sbuf_init(&sb);
+    for (k = 0; k < 2; k++) {
+        for (p = parts[k]; *p != '\0'; p = end) {
+            p += strspn(p, "/");
+            end = p + strcspn(p, "/");
+            len = end - p;
+            if (len == 0 || (len == 1 && p[0] == '.')) {
+                continue;
+            }
+            if (len == 2 && p[0] == '.' && p[1] == '.') {
+                slash = (sb.data != NULL) ? strrchr(sb.data, '/') : NULL;
+                if (slash != NULL) {
+                    sb.len = slash - sb.data;
+                    *slash = '\0';
+                }
+                continue;
+            }
+            if (sbuf_addc(&sb, '/') != 0 || sbuf_addn(&sb, p, len) != 0) {
+                sbuf_free(&sb);
+                return (NULL);
+            }
+        }
+    }
+    if (sb.len == 0 && sbuf_addc(&sb, '/') != 0) {
+        sbuf_free(&sb);
+        return (NULL);
+    }
+    return (sbuf_finish(&sb));
+}
+
+
+/**
+ * dir_open - Open a directory for a later fchdir.
+ * @path: The directory.
+ *
+ * Return: A close-on-exec descriptor at or above DIR_FD_MIN, or -1.
+ */
+static int dir_open(const char *path)
+{
+    int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC), high;
+
+    if (fd < 0 || fd >= DIR_FD_MIN) {
+        return (fd);
+    }
+    high = fcntl(fd, F_DUPFD_CLOEXEC, DIR_FD_MIN);
+    close(fd);
+    return (high);
+}
+
+
+/**
+ * dir_set - Record a new working directory in PWD, OLDPWD and the prompt.
+ * @cwd: Its logical path (malloc'd; the state takes it over).
+ */
+static void dir_set(char *cwd)
+{
+    if (dirs.cwd != NULL) {
+        var_export("OLDPWD", dirs.cwd);
+        free(dirs.cwd);
+    }
+    dirs.cwd = cwd;
+    var_export("PWD", cwd);
+    prompt_chdir(cwd);
+}
+
+
+/**
+ * dir_change - Change to a directory named by the user.
+ * @path: The directory.
+ * @physical: Non-zero for cd -P: follow symbolic links now.
+ *
+ * The logical path is tried first; if it does not lead anywhere (a
+ * directory on it was removed or renamed), @path is used as it is. Only
+ * then, or with -P, is getcwd needed.
+ *
+ * Return: 0 on success, -1 on failure (errno set).
+ */
+static int dir_change(const char *path, int physical)
+{
+    char *target = physical ? NULL : dir_join(dir_logical(), path);
+
+    if (target != NULL && chdir(target) == 0) {
+        dir_set(target);
+        return (0);
+    }
+    free(target);
+    if (chdir(path) != 0) {
+        return (-1);
+    }
+    target = getcwd(NULL, 0);
+    if (target == NULL) {
+        target = dir_join(dir_logical(), path);
+    }
+    if (target != NULL) {
+        dir_set(target);
+    }
+    return (0);
+}
+
+
+/**
+ * dir_enter - Change to a saved directory.
+ * @entry: The directory; its path is taken over by the state.
+ * @name: The builtin, for messages.
+ *
+ * Return: 0 on success, -1 on failure (the entry is left as it was).
+ */
+static int dir_enter(dir_entry *entry, const char *name)
+{
+    if ((entry->fd >= 0) ? fchdir(entry->fd) : chdir(entry->path)) {
+        shell_error("%s: can't cd to %s", name, entry->path);
+        return (-1);
+    }
+    dir_set(entry->path);
+    entry->path = NULL;
+    if (entry->fd >= 0) {
+        close(entry->fd);
+        entry->fd = -1;
+    }
+    return (0);
+}
+
+
+/**
+ * dir_push - Add a directory to the top of the stack.
+ * @path: Its logical path (malloc'd; the stack takes it over).
+ * @fd: Its descriptor, or -1.
+ *
+ * Return: 0 on success, -1 on allocation failure (@path and @fd released).
+ */
+static int dir_push(char *path, int fd)
+{
+    dir_entry *grown;
+
+    if (path != NULL && dirs.count == dirs.cap) {
+        grown = realloc(dirs.stack, (dirs.cap * 2 + 8) * sizeof(dir_entry));
+        if (grown != NULL) {
+            dirs.stack = grown;
+            dirs.cap = dirs.cap * 2 + 8;
+        }
+    }
+    if (path == NULL || dirs.count == dirs.cap) {
+        perror("malloc");
+        free(path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return (-1);
+    }
+    dirs.stack[dirs.count].path = path;
+    dirs.stack[dirs.count].fd = fd;
+    dirs.count++;
+    return (0);
+}
+
+
+/**
+ * dir_position - Convert a +N or -N argument to a stack position.
+ * @name: The builtin, for messages.
+ * @arg: The argument.
+ * @position: Receives the position: 0 is the working directory, 1 the top
+ * of the stack, and so on.
+ *
+ * Return: 1 if @arg has that form, 0 if not, -1 if out of range (reported).
+ */
+static int dir_position(const char *name, const char *arg, size_t *position)
+{
+    char *end;
+    long n;
+
+    if ((arg[0] != '+' && arg[0] != '-') || !isdigit((unsigned char)arg[1])) {
+        return (0);
+    }
+    n = strtol(arg + 1, &end, 10);
+    if (*end != '\0') {
+        return (0);
+    }
+    if (n < 0 || (size_t)n > dirs.count) {
+        shell_error("%s: %s: directory stack index out of range", name, arg);
+        return (-1);
+    }
+    *position = (arg[0] == '+') ? (size_t)n : dirs.count - n;
+    return (1);
+}
+
+
+/**
+ * dir_print - Write one directory of the stack.
+ * @path: Its path.
+ * @flags: DIRS_LONG to not shorten $HOME to ~.
+ */
+static void dir_print(const char *path, int flags)
+{
+    const char *home = var_lookup("HOME");
+    size_t len = (home != NULL) ? strlen(home) : 0;
+
+    if (!(flags & DIRS_LONG) && len > 1 && strncmp(path, home, len) == 0
+        && (path[len] == '/' || path[len] == '\0')) {
+        out_write("~", 1);
+        path += len;
+    }
+    out_puts(path);
+}
+
+
+/**
+ * dir_list - Write the working directory and the stack.
+ * @flags: DIRS_LONG, DIRS_LINES and DIRS_NUMBERED.
+ *
+ * Return: 0.
+ */
+static int dir_list(int flags)
+{
+    const char *cwd = dir_logical();
+    size_t i;
+
+    for (i = 0; i <= dirs.count; i++) {
+        if (flags & DIRS_NUMBERED) {
+            out_printf("%2lu  ", (unsigned long)i);
+        }
+        dir_print(i == 0 ? (cwd != NULL ? cwd : ".") : dirs.stack[dirs.count - i].path, flags);
+        out_write((flags & (DIRS_LINES | DIRS_NUMBERED)) || i == dirs.count ? "\n" : " ", 1);
+    }
+    return (0);
+}
+
+
+/**
+ * builtin_cd - Change directory: cd [-L | -P] [dir | -]
+ * @argv: Argument vector.
+ *
+ * Without a directory cd goes to $HOME; "cd -" goes to $OLDPWD and writes
+ * its name. PWD and OLDPWD are set from the logical paths.
+ *
+ * Return: 0 on success, 2 on failure.
+ */
+int builtin_cd(char **argv)
+{
+    const char *path;
+    int physical = 0, i;
+
+    for (i = 1; argv[i] != NULL && (strcmp(argv[i], "-L") == 0 || strcmp(argv[i], "-P") == 0);
+         i++) {
+        physical = (argv[i][1] == 'P');
+    }
+    path = argv[i];
+    if (path == NULL || strcmp(path, "-") == 0) {
+        path = var_lookup(path == NULL ? "HOME" : "OLDPWD");
+        if (path == NULL) {
+            shell_error("cd: %s not set", argv[i] == NULL ? "HOME" : "OLDPWD");
+            return (2);
+        }
+    }
+    if (dir_change(path, physical) != 0) {
+        shell_error("cd: can't cd to %s", path);
+        return (2);
+    }
+    if (argv[i] != NULL && strcmp(argv[i], "-") == 0) {
+        out_printf("%s\n", dir_logical());
+    }
+    return (0);
+}
+
+
+/**
+ * builtin_pwd - Write the working directory: pwd [-L | -P]
+ * @argv: Argument vector.
+ *
+ * The logical path the shell tracks is written without asking the system;
+ * -P resolves symbolic links with getcwd.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+int builtin_pwd(char **argv)
+{
+    char *physical = NULL;
+    const char *cwd;
+    int resolve = 0, i;
+
+    for (i = 1; argv[i] != NULL; i++) {
+        if (strcmp(argv[i], "-L") != 0 && strcmp(argv[i], "-P") != 0) {
+            shell_error("pwd: %s: invalid option", argv[i]);
+            return (1);
+        }
+        resolve = (argv[i][1] == 'P');
+    }
+    cwd = resolve ? (physical = getcwd(NULL, 0)) : dir_logical();
+    if (cwd == NULL) {
+        shell_error("pwd: %s", strerror(errno));
+        return (1);
+    }
+    out_printf("%s\n", cwd);
+    free(physical);
+    return (0);
+}
+
+
+/**
+ * builtin_pushd - Save the working directory and change to another:
+ * pushd [dir | +N | -N]
+ * @argv: Argument vector.
+ *
+ * Without an argument the top two directories are exchanged; +N and -N
+ * rotate the stack so that entry N comes to the top. The stack is
+ * written afterwards.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+int builtin_pushd(char **argv)
+{
+    dir_entry *rotated, here;
+    size_t position = 1, i, n = dirs.count + 1;
+    int form = (argv[1] != NULL) ? dir_position("pushd", argv[1], &position) : 1;
+
+    if (form < 0) {
+        return (1);
+    }
+    if (form == 1 && argv[1] == NULL && dirs.count == 0) {
+        shell_error("pushd: no other directory");
+        return (1);
+    }
+    if (form == 1 && position == 0) {
+        return (dir_list(0));
+    }
+    here.path = (dir_logical() != NULL) ? stringdup(dir_logical()) : NULL;
+    here.fd = dir_open(".");
+    if (form == 0) {
+        /* pushd dir */
+        if (dir_change(argv[1], 0) != 0) {
+            shell_error("pushd: can't cd to %s", argv[1]);
+            free(here.path);
+            if (here.fd >= 0) {
+                close(here.fd);
+            }
+            return (1);
+        }
+        dir_push(here.path, here.fd);
+        return (dir_list(0));
+    }
+    if (argv[1] == NULL && here.path != NULL) {
+        /* Exchange the top two */
+        if (dir_enter(&dirs.stack[dirs.count - 1], "pushd") != 0) {
+            free(here.path);
+            if (here.fd >= 0) {
+                close(here.fd);
+            }
+            return (1);
+        }
+        dirs.stack[dirs.count - 1] = here;
+        return (dir_list(0));
+    }
+    rotated = malloc(n * sizeof(dir_entry));
+    if (rotated == NULL || here.path == NULL) {
+        free(rotated);
+        free(here.path);
+        if (here.fd >= 0) {
+            close(here.fd);
+        }
+        return (1);
+    }
+    /* Positions 0..n-1, turned so that the chosen one comes first */
+    for (i = 0; i < n; i++) {
+        rotated[i] = (i == 0) ? here : dirs.stack[dirs.count - i];
+    }
+    if (dir_enter(&rotated[position], "pushd") != 0) {
+        free(here.path);
+        if (here.fd >= 0) {
+            close(here.fd);
+        }
+        free(rotated);
+        return (1);
+    }
+    for (i = 1; i < n; i++) {
+        dirs.stack[n - 1 - i] = rotated[(position + i) % n];
+    }
+    free(rotated);
+    return (dir_list(0));
+}
+
+
+/**
+ * builtin_popd - Remove a directory from the stack: popd [+N | -N]
+ * @argv: Argument vector.
+ *
+ * Without an argument (or with +0) the working directory is dropped and
+ * the top of the stack becomes it. The stack is written afterwards.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+int builtin_popd(char **argv)
+{
+    size_t position = 0, i;
+    dir_entry *entry;
+    int form = (argv[1] != NULL) ? dir_position("popd", argv[1], &position) : 1;
+
+    if (form == 0) {
+        shell_error("popd: %s: invalid argument", argv[1]);
+    }
+    if (form <= 0) {
+        return (1);
+    }
+    if (dirs.count == 0) {
+        shell_error("popd: directory stack empty");
+        return (1);
+    }
+    /* Dropping the working directory means going to the top */
+    entry = &dirs.stack[dirs.count - (position == 0 ? 1 : position)];
+    if (position == 0 && dir_enter(entry, "popd") != 0) {
+        return (1);
+    }
+    free(entry->path);
+    if (entry->fd >= 0) {
+        close(entry->fd);
+    }
+    for (i = entry - dirs.stack; i + 1 < dirs.count; i++) {
+        dirs.stack[i] = dirs.stack[i + 1];
+    }
+    dirs.count--;
+    return (dir_list(0));
+}
+
+
+/**
+ * builtin_dirs - Write or clear the directory stack: dirs [-clpv]
+ * @argv: Argument vector.
+ *
+ * Return: 0 on success, 1 on an invalid option.
+ */
+int builtin_dirs(char **argv)
+{
+    const char *p;
+    int flags = 0, i;
+
+    for (i = 1; argv[i] != NULL; i++) {
+        if (argv[i][0] != '-' || argv[i][1] == '\0') {
+            shell_error("dirs: %s: invalid argument", argv[i]);
+            return (1);
+        }
+        for (p = argv[i] + 1; *p != '\0'; p++) {
+            if (*p == 'c') {
+                while (dirs.count > 0) {
+                    dirs.count--;
+                    free(dirs.stack[dirs.count].path);
+                    if (dirs.stack[dirs.count].fd >= 0) {
+                        close(dirs.stack[dirs.count].fd);
+                    }
+                }
+                return (0);
+            }
+            if (strchr("lpv", *p) == NULL) {
+                shell_error("dirs: -%c: invalid option", *p);
+                return (1);
+            }
+            flags |= (*p == 'l') ? DIRS_LONG : (*p == 'p') ? DIRS_LINES : DIRS_NUMBERED;
+        }
+    }
+    return (dir_list(flags));
+}
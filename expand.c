@@ -0,0 +1,920 @@
+#include "main.h"
+
+
+/**
+ * find_arith_end - Find the "))" closing an arithmetic expansion.
+ * @start: First character after "$((".
+ *
+ * Return: Pointer to the first ')' of the closing "))", or NULL.
+ */
+static const char *find_arith_end(const char *start)
+{
+    int depth = 0;
+    const char *p;
+
+    for (p = start; *p != '\0'; p++) {
+        if (*p == '(') {
+            depth++;
+        } else if (*p == ')') {
+            if (depth == 0) {
+                return (p[1] == ')' ? p : NULL);
+            }
+            depth--;
+        }
+    }
+    return (NULL);
+}
+
+
+/**
+ * expand_arithmetic - Expand and evaluate the body of $((...)).
+ * @sb: Output buffer the decimal result is appended to.
+ * @body: Start of the expression.
+ * @len: Length of the expression.
+ *
+ * Parameter expansions inside the expression are expanded first, as POSIX
+ * requires; plain variable names are resolved by the evaluator itself.
+ *
+ * Return: 0 on success, -1 on error.
+ */
+static int expand_arithmetic(string_buffer *sb, const char *body, size_t len)
+{
+    char *raw, *expanded;
+    char digits[32];
+    long value;
+    int status;
+
+    raw = malloc(len + 1);
+    if (raw == NULL) {
+        perror("malloc");
+        return (-1);
+    }
+    memcpy(raw, body, len);
+    raw[len] = '\0';
+
+    expanded = expand_command(raw);
+    free(raw);
+    if (expanded == NULL) {
+        return (-1);
+    }
+    status = arith_eval(expanded, &value);
+    free(expanded);
+    if (status != 0) {
+        return (-1);
+    }
+    snprintf(digits, sizeof(digits), "%ld", value);
+    return (sbuf_adds(sb, digits));
+}
+
+
+/**
+ * find_closing - Find the bracket that closes a $( or ${ construct.
+ * @start: First character after the opening bracket.
+ * @open: Opening bracket character.
+ * @close: Closing bracket character.
+ *
+ * Quoted text and backslash escapes inside the construct are skipped.
+ *
+ * Return: Pointer to the closing bracket, or NULL.
+ */
+static const char *find_closing(const char *start, char open, char close)
+{
+    const char *p;
+    int depth = 1;
+    char quote = '\0';
+
+    for (p = start; *p != '\0'; p++) {
+        if (quote) {
+            if (*p == '\\' && quote != '\'' && p[1] != '\0') {
+                p++;
+            } else if (*p == quote) {
+                quote = '\0';
+            }
+        } else if (*p == '\\' && p[1] != '\0') {
+            p++;
+        } else if (*p == '\'' || *p == '"' || *p == '`') {
+            quote = *p;
+        } else if (*p == open) {
+            depth++;
+        } else if (*p == close && --depth == 0) {
+            return (p);
+        }
+    }
+    return (NULL);
+}
+
+
+/**
+ * copy_text - Duplicate @len bytes of @text as a string.
+ * @text: Start of the text.
+ * @len: Number of bytes.
+ *
+ * Return: The string, or NULL on allocation failure.
+ */
+static char *copy_text(const char *text, size_t len)
+{
+    char *copy = malloc(len + 1);
+
+    if (copy == NULL) {
+        perror("malloc");
+        return (NULL);
+    }
+    memcpy(copy, text, len);
+    copy[len] = '\0';
+    return (copy);
+}
+
+
+/**
+ * substitute - Append the output of a command substitution.
+ * @sb: Output buffer.
+ * @text: Start of the commands.
+ * @len: Length of the commands.
+ *
+ * Return: 0 on success, -1 on error.
+ */
+static int substitute(string_buffer *sb, const char *text, size_t len)
+{
+    char *commands = copy_text(text, len), *output;
+    int status;
+
+    if (commands == NULL) {
+        return (-1);
+    }
+    output = command_substitute(commands);
+    free(commands);
+    if (output == NULL) {
+        return (-1);
+    }
+    status = sbuf_adds(sb, output);
+    free(output);
+    return (status);
+}
+
+
+/**
+ * remove_pattern - Append a value with a matching prefix or suffix removed.
+ * @sb: Output buffer.
+ * @value: The parameter value.
+ * @pattern: Pattern to remove (backslash escaped).
+ * @suffix: Non-zero for % and %%, zero for # and ##.
+ * @longest: Non-zero for %% and ##.
+ *
+ * Return: 0 on success, -1 on allocation failure.
+ */
+static int remove_pattern(string_buffer *sb, const char *value, const char *pattern,
+    int suffix, int longest)
+{
+    size_t len = strlen(value), i, step;
+    char *copy, saved;
+    int status;
+
+    for (step = 0; step <= len; step++) {
+        if (suffix) {
+            i = longest ? step : len - step;
+            if (glob_match(pattern, value + i)) {
+                return (sbuf_addn(sb, value, i));
+            }
+            continue;
+        }
+        i = longest ? len - step : step;
+        copy = (char *)value;
+        saved = copy[i];
+        copy[i] = '\0';
+        status = glob_match(pattern, copy);
+        copy[i] = saved;
+        if (status) {
+            return (sbuf_adds(sb, value + i));
+        }
+    }
+    return (sbuf_adds(sb, value));
+}
+
+
+/**
+ * param_name_length - Measure the parameter name at the start of a string.
+ * @name: Text following "$" or "${".
+ *
+ * Return: Length of a special parameter (one of ? $ # @ * or a digit run)
+ * or of a variable name; 0 if there is none.
+ */
+static size_t param_name_length(const char *name)
+{
+    size_t len = 0;
+
+    if (*name != '\0' && strchr("?$#@*", *name) != NULL) {
+        return (1);
+    }
+    if (isdigit((unsigned char)*name)) {
+        while (isdigit((unsigned char)name[len])) {
+            len++;
+        }
+        return (len);
+    }
+    while (isalnum((unsigned char)name[len]) || name[len] == '_') {
+        len++;
+    }
+    return (len);
+}
+
+
+/**
+ * param_value - Append the value of a parameter.
+ * @sb: Output buffer.
+ * @name: Start of the parameter name.
+ * @len: Length of the name.
+ *
+ * $@ and $* are joined with the first character of IFS (a space when IFS
+ * is unset); $0 is the name of the shell or script.
+ *
+ * Return: 1 if the parameter is set, 0 if it is unset, -1 on error.
+ */
+static int param_value(string_buffer *sb, const char *name, size_t len)
+{
+    const char *value = NULL, *ifs;
+    char digits[32];
+    long index = 0;
+    size_t i;
+
+    if (len == 1 && (*name == '@' || *name == '*')) {
+        ifs = var_lookup("IFS");
+        for (i = 0; i < (size_t)positional_count; i++) {
+            if (i > 0 && (ifs == NULL || *ifs != '\0')) {
+                sbuf_addc(sb, ifs != NULL ? *ifs : ' ');
+            }
+            sbuf_adds(sb, positional_params[i]);
+        }
+        return (positional_count > 0);
+    }
+    if (len == 1 && (*name == '?' || *name == '$' || *name == '#')) {
+        snprintf(digits, sizeof(digits), "%d", *name == '?' ? last_exit_status
+            : *name == '$' ? (int)getpid() : positional_count);
+        value = digits;
+    } else if (isdigit((unsigned char)*name)) {
+        for (i = 0; i < len && index < 100000; i++) {
+            index = index * 10 + (name[i] - '0');
+        }
+        if (index == 0) {
+            value = shell_name;
+        } else if (index <= positional_count) {
+            value = positional_params[index - 1];
+        }
+    } else {
+        value = var_lookup_n(name, len);
+    }
+    if (value == NULL) {
+        return (0);
+    }
+    return (sbuf_adds(sb, value) == 0 ? 1 : -1);
+}
+
+
+/**
+ * expand_braced - Expand ${...}, including the POSIX operators.
+ * @sb: Output buffer.
+ * @open: Points at the '{'.
+ * @end: Receives the first character after the closing '}'.
+ *
+ * Supported: ${name}, ${#name}, ${name:-word}, ${name:=word},
+ * ${name:+word}, ${name:?word} (and the forms without a colon), and
+ * ${name#pattern}, ${name##pattern}, ${name%pattern}, ${name%%pattern}.
+ *
+ * Return: 0 on success, -1 on error.
+ */
+static int expand_braced(string_buffer *sb, const char *open, const char **end)
+{
+    const char *close = find_closing(open + 1, '{', '}');
+    const char *name = open + 1, *op, *value;
+    char *word, *expanded = NULL, *name_copy, digits[32];
+    string_buffer current;
+    size_t len;
+    int length = 0, colon = 0, status = 0, unset;
+
+    if (close == NULL) {
+        shell_error("Syntax error: Missing '}'");
+        return (-1);
+    }
+    *end = close + 1;
+    if (*name == '#' && name + 1 < close) {
+        length = 1;
+        name++;
+    }
+    len = param_name_length(name);
+    op = name + len;
+    if (len == 0 || op > close || (length && op != close)) {
+        shell_error("Bad substitution");
+        return (-1);
+    }
+
+    name_copy = copy_text(name, len);
+    if (name_copy == NULL) {
+        return (-1);
+    }
+    sbuf_init(&current);
+    sbuf_reserve(&current, 0);
+    status = param_value(&current, name, len);
+    value = (status == 1) ? current.data : NULL;
+    status = (status < 0) ? -1 : 0;
+
+    if (length || op == close) {
+        if (length) {
+            snprintf(digits, sizeof(digits), "%lu", (unsigned long)(value ? strlen(value) : 0));
+        }
+        status = (status == 0) ? sbuf_adds(sb, length ? digits : value) : -1;
+        sbuf_free(&current);
+        free(name_copy);
+        return (status);
+    }
+    if (*op == ':') {
+        colon = 1;
+        op++;
+    }
+    if (*op == '\0' || strchr("-=+?#%", *op) == NULL || (colon && strchr("-=+?", *op) == NULL)) {
+        sbuf_free(&current);
+        free(name_copy);
+        shell_error("Bad substitution");
+        return (-1);
+    }
+    unset = (value == NULL || (colon && *value == '\0'));
+    if ((op[0] == '#' || op[0] == '%') && op[1] == op[0]) {
+        word = copy_text(op + 2, close - op - 2);
+    } else {
+        word = copy_text(op + 1, close - op - 1);
+    }
+    if (word == NULL) {
+        sbuf_free(&current);
+        free(name_copy);
+        return (-1);
+    }
+
+    switch (*op) {
+    case '-':
+    case '=':
+        if (!unset) {
+            status = sbuf_adds(sb, value);
+            break;
+        }
+        expanded = expand_word_string(word);
+        if (expanded == NULL) {
+            status = -1;
+        } else if (*op == '=' && (!is_valid_name(name, len) || var_set(name_copy, expanded) != 0)) {
+            shell_error("%s: bad variable name", name_copy);
+            status = -1;
+        } else {
+            status = sbuf_adds(sb, expanded);
+        }
+        break;
+    case '+':
+        if (!unset) {
+            expanded = expand_word_string(word);
+            status = (expanded == NULL) ? -1 : sbuf_adds(sb, expanded);
+        }
+        break;
+    case '?':
+        if (!unset) {
+            status = sbuf_adds(sb, value);
+            break;
+        }
+        expanded = expand_word_string(word);
+        shell_error("%s: %s", name_copy, (expanded != NULL && *expanded != '\0')
+            ? expanded : "parameter not set");
+        status = -1;
+        break;
+    default:
+        expanded = expand_pattern(word);
+        status = (expanded == NULL) ? -1 : remove_pattern(sb, value != NULL ? value : "",
+            expanded, *op == '%', op[1] == *op);
+        break;
+    }
+    free(expanded);
+    free(word);
+    free(name_copy);
+    sbuf_free(&current);
+    return (status);
+}
+
+
+/**
+ * expand_dollar - Expand the $ construct starting at @p.
+ * @sb: Output buffer.
+ * @p: Points at the '$'.
+ * @end: Receives the first character after the construct.
+ *
+ * Return: 0 on success, -1 on error.
+ */
+static int expand_dollar(string_buffer *sb, const char *p, const char **end)
+{
+    const char *name = p + 1, *close;
+    size_t len;
+
+    if (strncmp(p, "$((", 3) == 0 && (close = find_arith_end(p + 3)) != NULL) {
+        *end = close + 2;
+        return (expand_arithmetic(sb, p + 3, close - (p + 3)));
+    }
+    if (*name == '(') {
+        close = find_closing(name + 1, '(', ')');
+        if (close == NULL) {
+            shell_error("Syntax error: Missing ')'");
+            return (-1);
+        }
+        *end = close + 1;
+        return (substitute(sb, name + 1, close - name - 1));
+    }
+    if (*name == '{') {
+        return (expand_braced(sb, name, end));
+    }
+    /* Only one digit belongs to $1...$9; ${10} needs braces */
+    len = isdigit((unsigned char)*name) ? 1 : param_name_length(name);
+    if (len == 0) {
+        /* Not a parameter: keep the dollar sign literally */
+        *end = p + 1;
+        return (sbuf_addc(sb, '$'));
+    }
+    *end = name + len;
+    return (param_value(sb, name, len) < 0 ? -1 : 0);
+}
+
+
+/**
+ * expand_backquote - Expand an old style `command` substitution.
+ * @sb: Output buffer.
+ * @p: Points at the opening backquote.
+ * @end: Receives the first character after the closing backquote.
+ *
+ * Inside backquotes a backslash only escapes $, ` and itself.
+ *
+ * Return: 0 on success, -1 on error.
+ */
+static int expand_backquote(string_buffer *sb, const char *p, const char **end)
+{
+    string_buffer commands;
+    int status;
+
+    sbuf_init(&commands);
+    sbuf_reserve(&commands, 0);
+    for (p++; *p != '\0' && *p != '`'; p++) {
+        if (*p == '\\' && p[1] != '\0' && strchr("$`\\", p[1]) != NULL) {
+            p++;
+        }
+        sbuf_addc(&commands, *p);
+    }
+    *end = (*p == '`') ? p + 1 : p;
+    status = substitute(sb, commands.data, commands.len);
+    sbuf_free(&commands);
+    return (status);
+}
+
+
+/**
+ * expand_text - Expand parameters and arithmetic in a piece of text.
+ * @text: The text.
+ * @heredoc: Non-zero for here-document bodies, where quotes are ordinary
+ * characters and a backslash only escapes $, ` and itself.
+ *
+ * Return: A newly allocated expanded string, or NULL on error.
+ */
+static char *expand_text(const char *text, int heredoc)
+{
+    string_buffer sb;
+    const char *p = text, *end;
+    int in_single = 0, status = 0;
+
+    sbuf_init(&sb);
+    while (*p != '\0' && status == 0) {
+        if (*p == '\'' && !heredoc) {
+            in_single = !in_single;
+        } else if (*p == '\\' && heredoc && p[1] != '\0' && strchr("$`\\", p[1]) != NULL) {
+            status = sbuf_addc(&sb, p[1]);
+            p += 2;
+            continue;
+        } else if (*p == '\\' && !in_single && !heredoc && p[1] != '\0') {
+            status = sbuf_addn(&sb, p, 2);
+            p += 2;
+            continue;
+        } else if (*p == '$' && !in_single) {
+            status = expand_dollar(&sb, p, &end);
+            p = end;
+            continue;
+        } else if (*p == '`' && !in_single) {
+            status = expand_backquote(&sb, p, &end);
+            p = end;
+            continue;
+        }
+        status = sbuf_addc(&sb, *p);
+        p++;
+    }
+    if (status != 0) {
+        sbuf_free(&sb);
+        return (NULL);
+    }
+    return (sbuf_finish(&sb));
+}
+
+
+/**
+ * expand_command - Perform parameter and arithmetic expansion on a command.
+ * @command: The command line.
+ *
+ * $name, ${name}, $?, $$ and $((expression)) are replaced in place, except
+ * inside single quotes. Quotes themselves are kept, so the result can still
+ * be handed to a command interpreter.
+ *
+ * Return: A newly allocated expanded command, or NULL on error.
+ */
+char *expand_command(const char *command)
+{
+    return (expand_text(command, 0));
+}
+
+
+/**
+ * expand_heredoc - Expand the body of an unquoted here-document.
+ * @body: The body text.
+ *
+ * Return: A newly allocated expanded body, or NULL on error.
+ */
+char *expand_heredoc(const char *body)
+{
+    return (expand_text(body, 1));
+}
+
+
+/* How expand_word_into treats its results */
+#define EXPAND_FIELDS 0
+#define EXPAND_STRING 1
+#define EXPAND_PATTERN 2
+
+/**
+ * struct field_list - Fields produced while expanding words.
+ * @fields: Finished fields, in pattern form (quoted glob characters escaped).
+ * @globbed: For each field, non-zero if it has unquoted glob characters.
+ * @count: Number of finished fields.
+ * @cap: Allocated slots.
+ * @cur: The field being built.
+ * @active: Non-zero once @cur must produce a field, even an empty one.
+ * @glob: Non-zero if @cur has unquoted glob characters.
+ * @mode: EXPAND_FIELDS, EXPAND_STRING or EXPAND_PATTERN.
+ */
+typedef struct field_list
+{
+char **fields;
+char *globbed;
+size_t count;
+size_t cap;
+string_buffer cur;
+int active;
+int glob;
+int mode;
+} field_list;
+
+
+/**
+ * field_addc - Append a character to the current field.
+ * @fl: The field list.
+ * @c: The character.
+ * @quoted: Non-zero if the character came from quoted text.
+ *
+ * Pattern characters are kept backslash escaped unless they are active,
+ * so that globbing and quote removal can still tell them apart.
+ *
+ * Return: 0 on success, -1 on allocation failure.
+ */
+static int field_addc(field_list *fl, char c, int quoted)
+{
+    fl->active = 1;
+    if (fl->mode == EXPAND_STRING) {
+        return (sbuf_addc(&fl->cur, c));
+    }
+    if (c == '\\' || ((c == '*' || c == '?' || c == '[' || c == ']') && quoted)) {
+        sbuf_addc(&fl->cur, '\\');
+    } else if (c == '*' || c == '?' || c == '[') {
+        fl->glob = 1;
+    }
+    return (sbuf_addc(&fl->cur, c));
+}
+
+
+/**
+ * field_end - Finish the current field, if there is one.
+ * @fl: The field list.
+ *
+ * Return: 0 on success, -1 on allocation failure.
+ */
+static int field_end(field_list *fl)
+{
+    char **fields;
+    char *globbed;
+
+    if (!fl->active) {
+        return (0);
+    }
+    if (fl->count + 2 > fl->cap) {
+        fl->cap = fl->cap ? fl->cap * 2 : 8;
+        fields = realloc(fl->fields, fl->cap * sizeof(char *));
+        globbed = realloc(fl->globbed, fl->cap);
+        if (fields != NULL) {
+            fl->fields = fields;
+        }
+        if (globbed != NULL) {
+            fl->globbed = globbed;
+        }
+        if (fields == NULL || globbed == NULL) {
+            perror("realloc");
+            return (-1);
+        }
+    }
+    sbuf_reserve(&fl->cur, 0);
+    fl->globbed[fl->count] = (char)fl->glob;
+    fl->fields[fl->count++] = sbuf_finish(&fl->cur);
+    fl->fields[fl->count] = NULL;
+    fl->active = 0;
+    fl->glob = 0;
+    return (0);
+}
+
+
+/**
+ * field_add_value - Append the result of an expansion.
+ * @fl: The field list.
+ * @value: The expanded text.
+ * @quoted: Non-zero inside double quotes.
+ *
+ * Unquoted results are split into fields at IFS characters: runs of IFS
+ * whitespace separate fields, every other IFS character ends one.
+ *
+ * Return: 0 on success, -1 on allocation failure.
+ */
+static int field_add_value(field_list *fl, const char *value, int quoted)
+{
+    const char *ifs;
+
+    if (quoted || fl->mode != EXPAND_FIELDS) {
+        fl->active |= quoted;
+        for (; *value != '\0'; value++) {
+            if (field_addc(fl, *value, quoted) != 0) {
+                return (-1);
+            }
+        }
+        return (0);
+    }
+    ifs = var_lookup("IFS");
+    if (ifs == NULL) {
+        ifs = " \t\n";
+    }
+    for (; *value != '\0'; value++) {
+        if (strchr(ifs, *value) == NULL) {
+            if (field_addc(fl, *value, 0) != 0) {
+                return (-1);
+            }
+        } else if (*value != ' ' && *value != '\t' && *value != '\n') {
+            fl->active = 1;
+            if (field_end(fl) != 0) {
+                return (-1);
+            }
+        } else if (field_end(fl) != 0) {
+            return (-1);
+        }
+    }
+    return (0);
+}
+
+
+/**
+ * field_add_params - Expand a double quoted "$@": one field per parameter.
+ * @fl: The field list.
+ *
+ * Return: 0 on success, -1 on allocation failure.
+ */
+static int field_add_params(field_list *fl)
+{
+    int i;
+
+    for (i = 0; i < positional_count; i++) {
+        if (i > 0 && field_end(fl) != 0) {
+            return (-1);
+        }
+        fl->active = 1;
+        if (field_add_value(fl, positional_params[i], 1) != 0) {
+            return (-1);
+        }
+    }
+    return (0);
+}
+
+
+/**
+ * expand_word_into - Expand one word and add its text to a field list.
+ * @fl: The field list.
+ * @word: The raw word, as written (quotes included).
+ *
+ * Performs tilde, parameter, command and arithmetic expansion and quote
+ * removal. The last field is left open for the caller to end.
+ *
+ * Return: 0 on success, -1 on error.
+ */
+static int expand_word_into(field_list *fl, const char *word)
+{
+    const char *p = word, *end, *close;
+    string_buffer value;
+    int dq = 0, status = 0, quote_active = 0, empty_at = 0;
+    size_t quote_mark = 0;
+
+    if (*p == '~' && (p[1] == '\0' || p[1] == '/') && fl->mode != EXPAND_PATTERN) {
+        status = field_add_value(fl, var_lookup("HOME") != NULL ? var_lookup("HOME") : "~", 1);
+        p++;
+    }
+    while (*p != '\0' && status == 0) {
+        if (*p == '\'' && !dq) {
+            close = strchr(p + 1, '\'');
+            if (close == NULL) {
+                close = p + strlen(p);
+            }
+            fl->active = 1;
+            for (p++; p < close && status == 0; p++) {
+                status = field_addc(fl, *p, 1);
+            }
+            p = (*close != '\0') ? close + 1 : close;
+        } else if (*p == '"') {
+            dq = !dq;
+            if (dq) {
+                quote_mark = fl->cur.len;
+                quote_active = fl->active;
+                empty_at = 0;
+            }
+            fl->active = 1;
+            /* "$@" without parameters produces no field at all */
+            if (!dq && empty_at && fl->cur.len == quote_mark) {
+                fl->active = quote_active;
+            }
+            p++;
+        } else if (dq && fl->mode == EXPAND_FIELDS
+                   && (strncmp(p, "$@", 2) == 0 || strncmp(p, "${@}", 4) == 0)) {
+            empty_at = (positional_count == 0);
+            status = field_add_params(fl);
+            p += (p[1] == '@') ? 2 : 4;
+        } else if (*p == '\\' && p[1] != '\0' && (!dq || strchr("$`\"\\\n", p[1]) != NULL)) {
+            status = field_addc(fl, p[1], 1);
+            p += 2;
+        } else if (*p == '$' || *p == '`') {
+            sbuf_init(&value);
+            sbuf_reserve(&value, 0);
+            status = (*p == '$') ? expand_dollar(&value, p, &end) : expand_backquote(&value, p, &end);
+            if (status == 0) {
+                if (*p == '$' && end == p + 1) {
+                    status = field_addc(fl, '$', dq);
+                } else {
+                    status = field_add_value(fl, value.data, dq);
+                }
+            }
+            sbuf_free(&value);
+            p = end;
+        } else {
+            status = field_addc(fl, *p, dq);
+            p++;
+        }
+    }
+    return (status);
+}
+
+
+/**
+ * field_list_free - Release a field list.
+ * @fl: The field list.
+ */
+static void field_list_free(field_list *fl)
+{
+    size_t i;
+
+    for (i = 0; i < fl->count; i++) {
+        free(fl->fields[i]);
+    }
+    free(fl->fields);
+    free(fl->globbed);
+    sbuf_free(&fl->cur);
+}
+
+
+/**
+ * expand_single - Expand a word into exactly one string.
+ * @word: The raw word.
+ * @mode: EXPAND_STRING or EXPAND_PATTERN.
+ *
+ * Return: The result (malloc'd), or NULL on error.
+ */
+static char *expand_single(const char *word, int mode)
+{
+    field_list fl;
+
+    memset(&fl, 0, sizeof(fl));
+    fl.mode = mode;
+    if (expand_word_into(&fl, word) != 0) {
+        field_list_free(&fl);
+        return (NULL);
+    }
+    sbuf_reserve(&fl.cur, 0);
+    return (sbuf_finish(&fl.cur));
+}
+
+
+/**
+ * expand_word_string - Expand a word without field splitting or globbing.
+ * @word: The raw word, e.g. the value of an assignment.
+ *
+ * Return: The expanded, unquoted string (malloc'd), or NULL on error.
+ */
+char *expand_word_string(const char *word)
+{
+    return (expand_single(word, EXPAND_STRING));
+}
+
+
+/**
+ * expand_pattern - Expand a word for use as a pattern (case, ${x#...}).
+ * @word: The raw word.
+ *
+ * Return: The pattern, quoted characters backslash escaped (malloc'd), or
+ * NULL on error.
+ */
+char *expand_pattern(const char *word)
+{
+    return (expand_single(word, EXPAND_PATTERN));
+}
+
+
+/**
+ * expand_words - Expand the words of a command into an argument vector.
+ * @words: NULL terminated raw words (may be NULL).
+ *
+ * Each word goes through the expansions, field splitting, pathname
+ * expansion and quote removal. Directory scans are shared between the
+ * words of the command.
+ *
+ * Return: A NULL terminated vector (malloc'd), or NULL on error.
+ */
+char **expand_words(char **words)
+{
+    field_list fl;
+    glob_cache cache;
+    char **argv = NULL, **matches, **grown;
+    size_t count = 0, i, j;
+    int status = 0;
+
+    memset(&fl, 0, sizeof(fl));
+    fl.mode = EXPAND_FIELDS;
+    for (i = 0; words != NULL && words[i] != NULL && status == 0; i++) {
+        status = expand_word_into(&fl, words[i]);
+        if (status == 0) {
+            status = field_end(&fl);
+        }
+    }
+    if (status != 0) {
+        field_list_free(&fl);
+        return (NULL);
+    }
+
+    cache.dirs = NULL;
+    argv = malloc((fl.count + 1) * sizeof(char *));
+    for (i = 0; argv != NULL && i < fl.count; i++) {
+        matches = fl.globbed[i] ? glob_expand(fl.fields[i], &cache) : NULL;
+        if (matches == NULL) {
+            argv[count++] = unescape_pattern(fl.fields[i], strlen(fl.fields[i]));
+            continue;
+        }
+        j = 0;
+        while (matches[j] != NULL) {
+            j++;
+        }
+        grown = realloc(argv, (count + j + fl.count - i) * sizeof(char *));
+        if (grown == NULL) {
+            free_words(matches);
+            continue;
+        }
+        argv = grown;
+        memcpy(argv + count, matches, j * sizeof(char *));
+        count += j;
+        free(matches);
+    }
+    glob_cache_free(&cache);
+    field_list_free(&fl);
+    if (argv == NULL) {
+        perror("malloc");
+        return (NULL);
+    }
+    argv[count] = NULL;
+    return (argv);
+}
+
+
+/**
+ * free_words - Release a NULL terminated vector of strings.
+ * @words: The vector (may be NULL).
+ */
+void free_words(char **words)
+{
+    size_t i;
+
+    for (i = 0; words != NULL && words[i] != NULL; i++) {
+        free(words[i]);
+    }
+    free(words);
+}
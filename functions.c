@@ -0,0 +1,98 @@
+#include "main.h"
+
+#define FUNC_BUCKETS 64
+
+/* Functions defined by the running shell */
+static shell_func *func_table[FUNC_BUCKETS];
+
+
+/**
+ * func_hash - Hash a function name (FNV-1a).
+ * @name: The name to hash.
+ *
+ * Return: The bucket index for @name.
+ */
+static unsigned int func_hash(const char *name)
+{
+    unsigned int hash = 2166136261u;
+
+    for (; *name != '\0'; name++) {
+        hash ^= (unsigned char)*name;
+        hash *= 16777619u;
+    }
+    return (hash % FUNC_BUCKETS);
+}
+
+
+/**
+ * func_lookup - Find a defined function.
+ * @name: The function name.
+ *
+ * Return: The function, or NULL if none is defined with that name.
+ */
+shell_func *func_lookup(const char *name)
+{
+    shell_func *func;
+
+    for (func = func_table[func_hash(name)]; func != NULL; func = func->next) {
+        if (stringcmp(func->name, name) == 0) {
+            return (func);
+        }
+    }
+    return (NULL);
+}
+
+
+/**
+ * func_define - Define or redefine a function.
+ * @name: The function name.
+ * @body: Its body; the table takes a reference instead of a copy.
+ *
+ * Return: 0 on success, -1 on allocation failure.
+ */
+int func_define(const char *name, ast_node *body)
+{
+    shell_func *func = func_lookup(name);
+    unsigned int bucket;
+
+    body->refs++;
+    if (func != NULL) {
+        ast_free(func->body);
+        func->body = body;
+        return (0);
+    }
+    func = malloc(sizeof(*func));
+    if (func == NULL || (func->name = stringdup(name)) == NULL) {
+        perror("malloc");
+        free(func);
+        ast_free(body);
+        return (-1);
+    }
+    func->body = body;
+    bucket = func_hash(name);
+    func->next = func_table[bucket];
+    func_table[bucket] = func;
+    return (0);
+}
+
+
+/**
+ * func_unset - Remove a function definition.
+ * @name: The function name.
+ */
+void func_unset(const char *name)
+{
+    shell_func **link = &func_table[func_hash(name)];
+    shell_func *func;
+
+    while ((func = *link) != NULL) {
+        if (stringcmp(func->name, name) == 0) {
+            *link = func->next;
+            ast_free(func->body);
+            free(func->name);
+            free(func);
+            return;
+        }
+        link = &func->next;
+    }
+}
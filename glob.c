@@ -0,0 +1,503 @@
+#include "main.h"
+
+
+/**
+ * match_bracket - Match one character against a [...] expression.
+ * @pattern: Points just after the '['.
+ * @c: The character to match.
+ * @end: Receives the position after the closing ']'.
+ *
+ * Return: 1 on match, 0 on mismatch, -1 if the bracket is not closed
+ * (in which case the '[' is an ordinary character).
+ */
+static int match_bracket(const char *pattern, unsigned char c, const char **end)
+{
+    const char *p = pattern;
+    int negate = 0, matched = 0;
+    unsigned char low, high;
+
+    if (*p == '!' || *p == '^') {
+        negate = 1;
+        p++;
+    }
+    /* A ']' right after the opening bracket is a literal member */
+    if (*p == ']') {
+        matched = (c == ']');
+        p++;
+    }
+    while (*p != ']') {
+        if (*p == '\0') {
+            return (-1);
+        }
+        if (*p == '\\' && p[1] != '\0') {
+            p++;
+        }
+        low = (unsigned char)*p++;
+        high = low;
+        if (*p == '-' && p[1] != ']' && p[1] != '\0') {
+            p++;
+            if (*p == '\\' && p[1] != '\0') {
+                p++;
+            }
+            high = (unsigned char)*p++;
+        }
+        if (c >= low && c <= high) {
+            matched = 1;
+        }
+    }
+    *end = p + 1;
+    return (matched != negate);
+}
+
+
+/**
+ * has_glob_chars - Check whether a word contains unescaped * ?, or a [
+ * closed by a ].
+ * @word: The word to inspect.
+ *
+ * An unclosed [ is an ordinary character (see match_bracket), so words
+ * like "[" or "a[b" are not patterns and never cost a directory scan.
+ *
+ * Return: 1 if the word is a pattern, 0 otherwise.
+ */
+int has_glob_chars(const char *word)
+{
+    const char *end;
+
+    for (; *word != '\0'; word++) {
+        if (*word == '\\' && word[1] != '\0') {
+            word++;
+        } else if (*word == '*' || *word == '?') {
+            return (1);
+        } else if (*word == '[' && match_bracket(word + 1, 0, &end) != -1) {
+            return (1);
+        }
+    }
+    return (0);
+}
+
+
+/**
+ * glob_match - Match a string against a shell pattern.
+ * @pattern: The pattern (*, ?, [...], backslash escapes).
+ * @string: The string to test.
+ *
+ * Uses the classic single-backtrack algorithm, so matching is linear for
+ * patterns with one '*' and never exponential.
+ *
+ * Return: 1 if @string matches, 0 otherwise.
+ */
+int glob_match(const char *pattern, const char *string)
+{
+    const char *star_p = NULL, *star_s = NULL, *next;
+    int result;
+
+    while (*string != '\0') {
+        if (*pattern == '*') {
+            while (*pattern == '*') {
+                pattern++;
+            }
+            if (*pattern == '\0') {
+                return (1);
+            }
+            star_p = pattern;
+            star_s = string;
+            continue;
+        }
+        if (*pattern == '?') {
+            pattern++;
+            string++;
+            continue;
+        }
+        if (*pattern == '[') {
+            result = match_bracket(pattern + 1, (unsigned char)*string, &next);
+            if (result == 1) {
+                pattern = next;
+                string++;
+                continue;
+            }
+            if (result == -1 && *string == '[') {
+                pattern++;
+                string++;
+                continue;
+            }
+        } else {
+            next = pattern;
+            if (*next == '\\' && next[1] != '\0') {
+                next++;
+            }
+            if (*next == *string) {
+                pattern = next + 1;
+                string++;
+                continue;
+            }
+        }
+        /* Mismatch: let the last '*' swallow one more character */
+        if (star_p == NULL) {
+            return (0);
+        }
+        pattern = star_p;
+        string = ++star_s;
+    }
+    while (*pattern == '*') {
+        pattern++;
+    }
+    return (*pattern == '\0');
+}
+
+
+/**
+ * unescape_pattern - Remove backslash escapes from a pattern.
+ * @pattern: The pattern.
+ * @len: Number of bytes of @pattern to use.
+ *
+ * Return: A newly allocated literal string, or NULL on allocation failure.
+ */
+char *unescape_pattern(const char *pattern, size_t len)
+{
+    char *literal = malloc(len + 1);
+    size_t i, j = 0;
+
+    if (literal == NULL) {
+        perror("malloc");
+        return (NULL);
+    }
+    for (i = 0; i < len; i++) {
+        if (pattern[i] == '\\' && i + 1 < len) {
+            i++;
+        }
+        literal[j++] = pattern[i];
+    }
+    literal[j] = '\0';
+    return (literal);
+}
+
+
+/**
+ * glob_cache_listing - Return the (cached) entries of a directory.
+ * @cache: The per-command cache.
+ * @dir: Directory path, "" meaning the current directory.
+ *
+ * Every directory is read at most once per command, so "*.log *.gz"
+ * scans the working directory a single time.
+ *
+ * Return: The listing, or NULL if the directory cannot be read.
+ */
+static dir_listing *glob_cache_listing(glob_cache *cache, const char *dir)
+{
+    dir_listing *listing;
+    struct dirent *entry;
+    DIR *stream;
+    char **names;
+    size_t cap = 64;
+
+    for (listing = cache->dirs; listing != NULL; listing = listing->next) {
+        if (stringcmp(listing->path, dir) == 0) {
+            return (listing->names != NULL ? listing : NULL);
+        }
+    }
+
+    listing = malloc(sizeof(*listing));
+    if (listing == NULL || (listing->path = stringdup(dir)) == NULL) {
+        perror("malloc");
+        free(listing);
+        return (NULL);
+    }
+    listing->names = NULL;
+    listing->count = 0;
+    listing->next = cache->dirs;
+    cache->dirs = listing;
+
+    stream = opendir(*dir != '\0' ? dir : ".");
+    if (stream == NULL) {
+        return (NULL);  /* Remember the failure as an empty slot */
+    }
+    listing->names = malloc(cap * sizeof(char *));
+    while (listing->names != NULL && (entry = readdir(stream)) != NULL) {
+        if (stringcmp(entry->d_name, ".") == 0 || stringcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        if (listing->count == cap) {
+            cap *= 2;
+            names = realloc(listing->names, cap * sizeof(char *));
+            if (names == NULL) {
+                break;
+            }
+            listing->names = names;
+        }
+        listing->names[listing->count] = stringdup(entry->d_name);
+        if (listing->names[listing->count] != NULL) {
+            listing->count++;
+        }
+    }
+    closedir(stream);
+    return (listing->names != NULL ? listing : NULL);
+}
+
+
+/**
+ * glob_cache_free - Release every listing held by a cache.
+ * @cache: The cache to empty.
+ */
+void glob_cache_free(glob_cache *cache)
+{
+    dir_listing *listing, *next;
+    size_t i;
+
+    for (listing = cache->dirs; listing != NULL; listing = next) {
+        next = listing->next;
+        for (i = 0; i < listing->count; i++) {
+            free(listing->names[i]);
+        }
+        free(listing->names);
+        free(listing->path);
+        free(listing);
+    }
+    cache->dirs = NULL;
+}
+
+
+/**
+ * glob_push - Append a match to a NULL terminated result vector.
+ * @results: The vector (may be NULL).
+ * @count: Number of results so far, updated.
+ * @cap: Allocated slots, updated.
+ * @match: The match, ownership is taken.
+ *
+ * Return: The (possibly moved) vector, or NULL on allocation failure.
+ */
+static char **glob_push(char **results, size_t *count, size_t *cap, char *match)
+{
+    char **grown;
+
+    if (*count + 1 >= *cap) {
+        *cap = *cap ? *cap * 2 : 16;
+        grown = realloc(results, *cap * sizeof(char *));
+        if (grown == NULL) {
+            perror("realloc");
+            free(match);
+            return (results);
+        }
+        results = grown;
+    }
+    results[(*count)++] = match;
+    results[*count] = NULL;
+    return (results);
+}
+
+
+/**
+ * struct glob_sort_key - A string with its first bytes packed big-endian.
+ * @key: Leading bytes of @str, so most comparisons are one integer compare.
+ * @str: The string.
+ */
+typedef struct glob_sort_key
+{
+unsigned long key;
+char *str;
+} glob_sort_key;
+
+/**
+ * compare_sort_keys - qsort comparator for glob_sort_key.
+ * @a: First key.
+ * @b: Second key.
+ *
+ * Return: <0, 0 or >0 like strcmp on the underlying strings.
+ */
+static int compare_sort_keys(const void *a, const void *b)
+{
+    const glob_sort_key *ka = a, *kb = b;
+
+    if (ka->key != kb->key) {
+        return (ka->key < kb->key ? -1 : 1);
+    }
+    return (strcmp(ka->str, kb->str));
+}
+
+/**
+ * glob_sort - Sort matches in byte order.
+ * @names: The matches.
+ * @count: Number of matches.
+ */
+void glob_sort(char **names, size_t count)
+{
+    glob_sort_key *keys;
+    size_t i, j;
+
+    if (count < 2) {
+        return;
+    }
+    keys = malloc(count * sizeof(*keys));
+    if (keys == NULL) {
+        return;
+    }
+    for (i = 0; i < count; i++) {
+        keys[i].key = 0;
+        keys[i].str = names[i];
+        /* Bytes after the terminator stay zero, keeping prefixes first */
+        for (j = 0; j < sizeof(unsigned long) && names[i][j] != '\0'; j++) {
+            keys[i].key |= (unsigned long)(unsigned char)names[i][j]
+                << (8 * (sizeof(unsigned long) - 1 - j));
+        }
+    }
+    qsort(keys, count, sizeof(*keys), compare_sort_keys);
+    for (i = 0; i < count; i++) {
+        names[i] = keys[i].str;
+    }
+    free(keys);
+}
+
+
+/**
+ * struct glob_walk - State of one pattern expansion.
+ * @cache: Directory listing cache.
+ * @results: Matches found so far.
+ * @count: Number of matches.
+ * @cap: Allocated result slots.
+ */
+typedef struct glob_walk
+{
+glob_cache *cache;
+char **results;
+size_t count;
+size_t cap;
+} glob_walk;
+
+static void glob_component(glob_walk *walk, const char *dir, const char *rest);
+
+/**
+ * glob_recursive - Expand a "**" component, which matches any number of
+ * directories (including none).
+ * @walk: Expansion state.
+ * @dir: Path built so far ("" or ending with '/').
+ * @next: The pattern after "**", without leading slashes.
+ *
+ * When only a file name pattern follows ("**" + "/" + "*.json"), the parallel
+ * walker matches names while it scans; otherwise it lists the directories of
+ * the tree and the rest of the pattern is expanded below each of them.
+ */
+static void glob_recursive(glob_walk *walk, const char *dir, const char *next)
+{
+    int last = (strchr(next, '/') == NULL && strstr(next, "**") == NULL);
+    char **paths;
+    size_t count, i;
+
+    paths = glob_walk_tree(dir, last ? (*next != '\0' ? next : "*") : NULL, &count);
+    for (i = 0; i < count; i++) {
+        if (last) {
+            walk->results = glob_push(walk->results, &walk->count, &walk->cap, paths[i]);
+            continue;
+        }
+        glob_component(walk, paths[i], next);
+        free(paths[i]);
+    }
+    free(paths);
+}
+
+
+/**
+ * glob_component - Expand the pattern components from @rest on, below @dir.
+ * @walk: Expansion state.
+ * @dir: Path built so far ("" or ending with '/').
+ * @rest: Remaining pattern, without leading slashes.
+ */
+static void glob_component(glob_walk *walk, const char *dir, const char *rest)
+{
+    const char *slash = strchr(rest, '/');
+    size_t len = slash != NULL ? (size_t)(slash - rest) : strlen(rest);
+    const char *next = rest + len;
+    char *component, *path;
+    dir_listing *listing;
+    struct stat st;
+    size_t i;
+
+    while (*next == '/') {
+        next++;
+    }
+    component = malloc(len + 1);
+    if (component == NULL) {
+        return;
+    }
+    memcpy(component, rest, len);
+    component[len] = '\0';
+
+    if (stringcmp(component, "**") == 0) {
+        free(component);
+        glob_recursive(walk, dir, next);
+        return;
+    }
+
+    if (!has_glob_chars(component)) {
+        /* Literal component: no directory scan, just extend the path */
+        free(component);
+        component = unescape_pattern(rest, len);
+        path = component != NULL ? malloc(strlen(dir) + len + 2) : NULL;
+        if (path != NULL) {
+            sprintf(path, "%s%s%s", dir, component, slash != NULL ? "/" : "");
+            if (*next != '\0') {
+                glob_component(walk, path, next);
+            } else if (lstat(path, &st) == 0) {
+                walk->results = glob_push(walk->results, &walk->count, &walk->cap,
+                    stringdup(path));
+            }
+        }
+        free(path);
+        free(component);
+        return;
+    }
+
+    listing = glob_cache_listing(walk->cache, dir);
+    for (i = 0; listing != NULL && i < listing->count; i++) {
+        /* Hidden files only match a pattern that starts with a dot */
+        if (listing->names[i][0] == '.' && component[0] != '.') {
+            continue;
+        }
+        if (!glob_match(component, listing->names[i])) {
+            continue;
+        }
+        path = malloc(strlen(dir) + strlen(listing->names[i]) + 2);
+        if (path == NULL) {
+            break;
+        }
+        sprintf(path, "%s%s%s", dir, listing->names[i], slash != NULL ? "/" : "");
+        if (*next != '\0') {
+            glob_component(walk, path, next);
+            free(path);
+        } else if (slash != NULL && (stat(path, &st) != 0 || !S_ISDIR(st.st_mode))) {
+            free(path);  /* A trailing slash only matches directories */
+        } else {
+            walk->results = glob_push(walk->results, &walk->count, &walk->cap, path);
+        }
+    }
+    free(component);
+}
+
+
+/**
+ * glob_expand - Expand one pathname pattern.
+ * @pattern: The pattern, with backslash escapes for literal characters.
+ * @cache: Per-command directory listing cache.
+ *
+ * Return: A sorted, NULL terminated vector of matches, or NULL if nothing
+ * matched (the caller then keeps the pattern as it is).
+ */
+char **glob_expand(const char *pattern, glob_cache *cache)
+{
+    glob_walk walk;
+    const char *rest = pattern;
+
+    walk.cache = cache;
+    walk.results = NULL;
+    walk.count = 0;
+    walk.cap = 0;
+
+    while (*rest == '/') {
+        rest++;
+    }
+    if (*rest == '\0') {
+        return (NULL);
+    }
+    glob_component(&walk, rest != pattern ? "/" : "", rest);
+    glob_sort(walk.results, walk.count);
+    return (walk.results);
+}
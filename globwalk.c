@@ -0,0 +1,390 @@
+#include "main.h"
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#define WALK_MAX_THREADS 16
+#define WALK_BUFFER_SIZE 65536
+
+/**
+ * struct linux_dirent64 - Record returned by the getdents64 system call.
+ * @d_ino: Inode number.
+ * @d_off: Offset of the next record.
+ * @d_reclen: Size of this record.
+ * @d_type: File type (DT_*), or DT_UNKNOWN.
+ * @d_name: NUL terminated entry name.
+ */
+struct linux_dirent64
+{
+unsigned long d_ino;
+long d_off;
+unsigned short d_reclen;
+unsigned char d_type;
+char d_name[1];
+};
+
+/**
+ * struct walk_deque - A worker's queue of directories still to scan.
+ * @items: Directory paths; the owner works at @tail, thieves take @head.
+ * @head: Index of the oldest item.
+ * @tail: One past the newest item.
+ * @cap: Allocated slots.
+ * @lock: Protects the deque against concurrent steals.
+ */
+typedef struct walk_deque
+{
+char **items;
+size_t head;
+size_t tail;
+size_t cap;
+pthread_mutex_t lock;
+} walk_deque;
+
+/**
+ * struct walk_shared - State shared by all walker threads.
+ * @queues: One deque per thread.
+ * @nthreads: Number of threads.
+ * @pending: Directories queued or being scanned; zero means done.
+ * @match: Pattern for entry names, or NULL to collect directories.
+ * @hidden: Non-zero if names starting with '.' may match.
+ * @idle_lock: Protects @pushes and the wait on @idle_cond.
+ * @idle_cond: Idle workers sleep here until work is pushed or the walk ends.
+ * @pushes: Count of pushes, so a worker can tell whether it missed one.
+ */
+typedef struct walk_shared
+{
+walk_deque *queues;
+int nthreads;
+long pending;
+const char *match;
+int hidden;
+pthread_mutex_t idle_lock;
+pthread_cond_t idle_cond;
+unsigned long pushes;
+} walk_shared;
+
+/**
+ * struct walk_worker - Per-thread walker state.
+ * @shared: Shared state.
+ * @id: Index of this worker's deque.
+ * @results: Paths found by this worker.
+ * @count: Number of results.
+ * @cap: Allocated result slots.
+ * @buffer: getdents64 buffer.
+ */
+typedef struct walk_worker
+{
+walk_shared *shared;
+int id;
+char **results;
+size_t count;
+size_t cap;
+char *buffer;
+} walk_worker;
+
+
+/**
+ * deque_push - Queue a directory on a worker's deque.
+ * @shared: Shared state.
+ * @id: Deque index.
+ * @path: Directory path, ownership is taken; NULL (a failed allocation)
+ * is ignored so it is never counted in pending.
+ */
+static void deque_push(walk_shared *shared, int id, char *path)
+{
+    walk_deque *dq = &shared->queues[id];
+    char **grown;
+
+    if (path == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&dq->lock);
+    if (dq->tail == dq->cap) {
+        if (dq->head > 0) {
+            memmove(dq->items, dq->items + dq->head, (dq->tail - dq->head) * sizeof(char *));
+            dq->tail -= dq->head;
+            dq->head = 0;
+        }
+        if (dq->tail == dq->cap) {
+            grown = realloc(dq->items, (dq->cap ? dq->cap * 2 : 64) * sizeof(char *));
+            if (grown == NULL) {
+                pthread_mutex_unlock(&dq->lock);
+                free(path);
+                return;
+            }
+            dq->items = grown;
+            dq->cap = dq->cap ? dq->cap * 2 : 64;
+        }
+    }
+    __sync_add_and_fetch(&shared->pending, 1);
+    dq->items[dq->tail++] = path;
+    pthread_mutex_unlock(&dq->lock);
+
+    pthread_mutex_lock(&shared->idle_lock);
+    shared->pushes++;
+    pthread_cond_signal(&shared->idle_cond);
+    pthread_mutex_unlock(&shared->idle_lock);
+}
+
+/**
+ * deque_take - Take a directory from a deque.
+ * @dq: The deque.
+ * @steal: Non-zero to take the oldest item (thief), else the newest (owner).
+ *
+ * Return: The path, or NULL if the deque is empty.
+ */
+static char *deque_take(walk_deque *dq, int steal)
+{
+    char *path = NULL;
+
+    pthread_mutex_lock(&dq->lock);
+    if (dq->head < dq->tail) {
+        path = steal ? dq->items[dq->head++] : dq->items[--dq->tail];
+        if (dq->head == dq->tail) {
+            dq->head = 0;
+            dq->tail = 0;
+        }
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return (path);
+}
+
+/**
+ * walk_result - Record a path found by a worker.
+ * @worker: The worker.
+ * @path: The path, ownership is taken.
+ */
+static void walk_result(walk_worker *worker, char *path)
+{
+    char **grown;
+
+    if (path == NULL) {
+        return;
+    }
+    if (worker->count == worker->cap) {
+        grown = realloc(worker->results, (worker->cap ? worker->cap * 2 : 64) * sizeof(char *));
+        if (grown == NULL) {
+            free(path);
+            return;
+        }
+        worker->results = grown;
+        worker->cap = worker->cap ? worker->cap * 2 : 64;
+    }
+    worker->results[worker->count++] = path;
+}
+
+/**
+ * join_path - Build "dir/name" ("name" when @dir is empty).
+ * @dir: Directory prefix, "" or ending in '/'.
+ * @name: Entry name.
+ * @slash: Non-zero to append a trailing '/'.
+ *
+ * Return: The new path, or NULL on allocation failure.
+ */
+static char *join_path(const char *dir, const char *name, int slash)
+{
+    size_t dlen = strlen(dir), nlen = strlen(name);
+    char *path = malloc(dlen + nlen + 2);
+
+    if (path != NULL) {
+        memcpy(path, dir, dlen);
+        memcpy(path + dlen, name, nlen);
+        if (slash) {
+            path[dlen + nlen++] = '/';
+        }
+        path[dlen + nlen] = '\0';
+    }
+    return (path);
+}
+
+/**
+ * walk_scan - Read one directory, queueing subdirectories and matching names.
+ * @worker: The worker doing the scan.
+ * @dir: Directory path ("" or ending in '/').
+ */
+static void walk_scan(walk_worker *worker, const char *dir)
+{
+    walk_shared *shared = worker->shared;
+    struct linux_dirent64 *entry;
+    struct stat st;
+    long nread, offset;
+    int fd, is_dir;
+
+    fd = openat(AT_FDCWD, *dir != '\0' ? dir : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1) {
+        return;
+    }
+    if (shared->match == NULL) {
+        walk_result(worker, stringdup(dir));
+    }
+    while ((nread = syscall(SYS_getdents64, fd, worker->buffer, WALK_BUFFER_SIZE)) > 0) {
+        for (offset = 0; offset < nread; offset += entry->d_reclen) {
+            entry = (struct linux_dirent64 *)(worker->buffer + offset);
+            if (entry->d_name[0] == '.' && (entry->d_name[1] == '\0'
+                || (entry->d_name[1] == '.' && entry->d_name[2] == '\0'))) {
+                continue;
+            }
+            is_dir = (entry->d_type == DT_DIR);
+            if (entry->d_type == DT_UNKNOWN
+                && fstatat(fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+                is_dir = S_ISDIR(st.st_mode);
+            }
+            /* Hidden directories are not descended into; symlinks never are */
+            if (is_dir && entry->d_name[0] != '.') {
+                deque_push(shared, worker->id, join_path(dir, entry->d_name, 1));
+            }
+            if (shared->match != NULL && (entry->d_name[0] != '.' || shared->hidden)
+                && glob_match(shared->match, entry->d_name)) {
+                walk_result(worker, join_path(dir, entry->d_name, 0));
+            }
+        }
+    }
+    close(fd);
+}
+
+/**
+ * walk_thread - Worker loop: scan own work, steal when idle, stop when done.
+ * @arg: The walk_worker.
+ *
+ * A worker that finds every deque empty sleeps on idle_cond until a push
+ * happens after its last look, or until pending drops to zero.
+ *
+ * Return: NULL.
+ */
+static void *walk_thread(void *arg)
+{
+    walk_worker *worker = arg;
+    walk_shared *shared = worker->shared;
+    unsigned long seen;
+    char *path;
+    int i, done;
+
+    for (;;) {
+        pthread_mutex_lock(&shared->idle_lock);
+        seen = shared->pushes;
+        pthread_mutex_unlock(&shared->idle_lock);
+        path = deque_take(&shared->queues[worker->id], 0);
+        for (i = 1; path == NULL && i < shared->nthreads; i++) {
+            path = deque_take(&shared->queues[(worker->id + i) % shared->nthreads], 1);
+        }
+        if (path == NULL) {
+            pthread_mutex_lock(&shared->idle_lock);
+            while (shared->pushes == seen && __sync_add_and_fetch(&shared->pending, 0) > 0) {
+                pthread_cond_wait(&shared->idle_cond, &shared->idle_lock);
+            }
+            done = (__sync_add_and_fetch(&shared->pending, 0) == 0);
+            pthread_mutex_unlock(&shared->idle_lock);
+            if (done) {
+                break;
+            }
+            continue;
+        }
+        walk_scan(worker, path);
+        free(path);
+        if (__sync_sub_and_fetch(&shared->pending, 1) == 0) {
+            pthread_mutex_lock(&shared->idle_lock);
+            pthread_cond_broadcast(&shared->idle_cond);
+            pthread_mutex_unlock(&shared->idle_lock);
+        }
+    }
+    return (NULL);
+}
+
+/**
+ * walk_thread_count - Choose how many walker threads to run.
+ *
+ * Return: Between 1 and WALK_MAX_THREADS.
+ */
+static int walk_thread_count(void)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (cpus < 1) {
+        return (1);
+    }
+    return (cpus > WALK_MAX_THREADS ? WALK_MAX_THREADS : (int)cpus);
+}
+
+
+/**
+ * glob_walk_tree - Walk a directory tree in parallel for a ** pattern.
+ * @dir: Top directory ("" for the cwd, otherwise ending in '/').
+ * @match: Pattern for entry names at any depth, or NULL to list the
+ * directories of the tree instead (including @dir itself).
+ * @count: Receives the number of paths returned.
+ *
+ * Directories are spread over worker threads with work-stealing deques;
+ * each worker reads with openat/getdents64 into its own buffer. Results
+ * are merged and sorted, so the output does not depend on scheduling.
+ *
+ * Return: A malloc'd vector of @count paths, or NULL if none were found.
+ */
+char **glob_walk_tree(const char *dir, const char *match, size_t *count)
+{
+    walk_shared shared;
+    walk_worker workers[WALK_MAX_THREADS];
+    pthread_t threads[WALK_MAX_THREADS];
+    char **merged = NULL;
+    size_t total = 0;
+    int i, started;
+
+    *count = 0;
+    shared.nthreads = walk_thread_count();
+    shared.pending = 0;
+    shared.match = match;
+    shared.hidden = (match != NULL && match[0] == '.');
+    shared.pushes = 0;
+    shared.queues = calloc(shared.nthreads, sizeof(walk_deque));
+    if (shared.queues == NULL) {
+        return (NULL);
+    }
+    pthread_mutex_init(&shared.idle_lock, NULL);
+    pthread_cond_init(&shared.idle_cond, NULL);
+    for (i = 0; i < shared.nthreads; i++) {
+        pthread_mutex_init(&shared.queues[i].lock, NULL);
+        workers[i].shared = &shared;
+        workers[i].id = i;
+        workers[i].results = NULL;
+        workers[i].count = 0;
+        workers[i].cap = 0;
+        workers[i].buffer = malloc(WALK_BUFFER_SIZE);
+    }
+    /* Worker 0 runs on the calling thread */
+    if (workers[0].buffer != NULL) {
+        deque_push(&shared, 0, stringdup(dir));
+        started = 1;
+        while (started < shared.nthreads && workers[started].buffer != NULL
+               && pthread_create(&threads[started], NULL, walk_thread, &workers[started]) == 0) {
+            started++;
+        }
+        walk_thread(&workers[0]);
+        for (i = 1; i < started; i++) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    for (i = 0; i < shared.nthreads; i++) {
+        total += workers[i].count;
+    }
+    if (total > 0) {
+        merged = malloc(total * sizeof(char *));
+    }
+    for (i = 0; i < shared.nthreads; i++) {
+        if (merged != NULL && workers[i].count > 0) {
+            memcpy(merged + *count, workers[i].results, workers[i].count * sizeof(char *));
+            *count += workers[i].count;
+        } else {
+            while (workers[i].count > 0) {
+                free(workers[i].results[--workers[i].count]);
+            }
+        }
+        free(workers[i].results);
+        free(workers[i].buffer);
+        free(shared.queues[i].items);
+        pthread_mutex_destroy(&shared.queues[i].lock);
+    }
+    free(shared.queues);
+    pthread_cond_destroy(&shared.idle_cond);
+    pthread_mutex_destroy(&shared.idle_lock);
+    glob_sort(merged, *count);
+    return (merged);
+}
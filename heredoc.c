@@ -0,0 +1,110 @@
+#define _GNU_SOURCE
+#include "main.h"
+#include <sys/mman.h>
+
+
+/**
+ * write_all - Write a whole buffer, retrying short writes.
+ * @fd: Destination descriptor.
+ * @data: Bytes to write.
+ * @len: Number of bytes.
+ *
+ * Return: 0 on success, -1 on error.
+ */
+int write_all(int fd, const char *data, size_t len)
+{
+    ssize_t written;
+
+    while (len > 0) {
+        written = write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return (-1);
+        }
+        data += written;
+        len -= written;
+    }
+    return (0);
+}
+
+
+/**
+ * heredoc_pipe - Fallback for kernels without memfd_create: serve the
+ * body through a pipe.
+ * @body: The here-document text.
+ * @len: Its length.
+ *
+ * Bodies that fit in the pipe buffer are written up front; larger ones
+ * are fed by a detached writer process so the reader never deadlocks.
+ *
+ * Return: The read end of the pipe, or -1 on error.
+ */
+static int heredoc_pipe(const char *body, size_t len)
+{
+    int fds[2];
+    pid_t pid;
+    long capacity = 65536;
+
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        return (-1);
+    }
+#ifdef F_SETPIPE_SZ
+    /* Try to grow the pipe so the whole body fits without a writer */
+    if (len > (size_t)capacity) {
+        capacity = fcntl(fds[1], F_SETPIPE_SZ, (int)(len < 1048576 ? len : 1048576));
+    }
+#endif
+    if (capacity > 0 && len <= (size_t)capacity) {
+        write_all(fds[1], body, len);
+        close(fds[1]);
+        return (fds[0]);
+    }
+
+    pid = fork();
+    if (pid == 0) {
+        /* Double fork so the writer is reparented and never left a zombie */
+        close(fds[0]);
+        if (fork() == 0) {
+            write_all(fds[1], body, len);
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+    if (pid < 0) {
+        perror("fork");
+        close(fds[0]);
+        return (-1);
+    }
+    waitpid(pid, NULL, 0);
+    return (fds[0]);
+}
+
+
+/**
+ * heredoc_open - Put a here-document body behind a file descriptor.
+ * @body: The (already expanded) body text.
+ * @len: Its length.
+ *
+ * The body lives in an anonymous memory file (memfd), rewound to the start,
+ * so the child reads it as stdin without anything touching the disk.
+ *
+ * Return: A readable descriptor positioned at the start of the body, or -1.
+ */
+int heredoc_open(const char *body, size_t len)
+{
+    int fd;
+
+    fd = memfd_create("hsh-heredoc", MFD_CLOEXEC);
+    if (fd == -1) {
+        return (heredoc_pipe(body, len));
+    }
+    if (write_all(fd, body, len) != 0 || lseek(fd, 0, SEEK_SET) != 0) {
+        perror("heredoc");
+        close(fd);
+        return (-1);
+    }
+    return (fd);
+}
@@ -0,0 +1,447 @@
+#define _GNU_SOURCE
+#include "main.h"
+#include <stdint.h>
+
+/*
+ * Ctrl-R index: entries are grouped in blocks, and each block keeps a
+ * 2048-bit signature of the trigrams found in its entries. A search only
+ * looks inside blocks whose signature holds every trigram of the query.
+ */
+#define HIST_BLOCK 32
+#define HIST_SIG_BITS 2048
+#define HIST_SIG_WORDS (HIST_SIG_BITS / 32)
+#define HIST_SIG_SHIFT 11 /* log2(HIST_SIG_BITS) */
+
+/**
+ * struct history_state - The command history.
+ * @opened: Non-zero once the history file has been opened.
+ * @loaded: Non-zero once the history file has been read.
+ * @fd: The history file, opened for appending, or -1.
+ * @text: Copy of the file as it was when first loaded (malloc'd).
+ * @text_len: Size of @text.
+ * @starts: Offset in @text of each entry read from the file.
+ * @file_count: Number of entries in @text.
+ * @added: Entries added by this shell (malloc'd).
+ * @added_count: Number of @added entries.
+ * @added_cap: Allocated size of @added.
+ * @sigs: Trigram signatures, HIST_SIG_WORDS words per block.
+ * @indexed: Number of entries covered by @sigs.
+ */
+typedef struct history_state
+{
+int opened;
+int loaded;
+int fd;
+char *text;
+size_t text_len;
+uint32_t *starts;
+size_t file_count;
+char **added;
+size_t added_count;
+size_t added_cap;
+uint32_t *sigs;
+size_t indexed;
+} history_state;
+
+static history_state hist = {0, 0, -1, NULL, 0, NULL, 0, NULL, 0, 0, NULL, 0};
+
+
+/**
+ * history_path - Find the history file: $HISTFILE, or ~/.hsh_history.
+ *
+ * Return: The path (malloc'd), or NULL if there is none.
+ */
+static char *history_path(void)
+{
+    const char *file = var_lookup("HISTFILE"), *home;
+    char *path;
+
+    if (file != NULL && *file != '\0') {
+        return (strdup(file));
+    }
+    home = var_lookup("HOME");
+    if (home == NULL || *home == '\0') {
+        return (NULL);
+    }
+    path = malloc(strlen(home) + sizeof("/.hsh_history"));
+    if (path == NULL) {
+        perror("malloc");
+        return (NULL);
+    }
+    strcpy(path, home);
+    strcat(path, "/.hsh_history");
+    return (path);
+}
+
+
+/**
+ * history_open - Open the history file for appending, on first use.
+ */
+static void history_open(void)
+{
+    char *path;
+
+    if (hist.opened) {
+        return;
+    }
+    hist.opened = 1;
+    path = history_path();
+    if (path != NULL) {
+        hist.fd = open(path, O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+        free(path);
+    }
+}
+
+
+/**
+ * history_load - Read the history file and find its entries.
+ *
+ * Done the first time an entry is needed (Up, Ctrl-R, history, !n), not
+ * at startup: a long history takes milliseconds to index. The file is
+ * copied rather than mapped: another shell or the user may truncate or
+ * rewrite it, and a mapping would then fault on pages past the new end.
+ * Entries this shell added before are already in the file, so they are
+ * dropped from memory.
+ */
+static void history_load(void)
+{
+    struct stat st;
+    char *p, *end, *nl;
+    size_t count = 0;
+    ssize_t got;
+
+    hist.loaded = 1;
+    history_open();
+    if (hist.fd < 0 || fstat(hist.fd, &st) != 0 || st.st_size == 0
+        || (uint64_t)st.st_size > UINT32_MAX) {
+        return;
+    }
+    hist.text = malloc(st.st_size);
+    if (hist.text == NULL) {
+        perror("malloc");
+        return;
+    }
+    /* The file may shrink meanwhile; keep what could be read */
+    while (hist.text_len < (size_t)st.st_size) {
+        got = pread(hist.fd, hist.text + hist.text_len, st.st_size - hist.text_len, hist.text_len);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            break;
+        }
+        hist.text_len += got;
+    }
+    end = hist.text + hist.text_len;
+    for (p = hist.text; p < end && (nl = memchr(p, '\n', end - p)) != NULL; p = nl + 1) {
+        count++;
+    }
+    hist.starts = malloc((count + 1) * sizeof(*hist.starts));
+    if (hist.starts == NULL) {
+        perror("malloc");
+        return;
+    }
+    /* A final line without its newline was cut short by a crash: drop it */
+    for (p = hist.text; p < end && (nl = memchr(p, '\n', end - p)) != NULL; p = nl + 1) {
+        hist.starts[hist.file_count++] = p - hist.text;
+    }
+    hist.starts[hist.file_count] = p - hist.text;
+    while (hist.added_count > 0) {
+        free(hist.added[--hist.added_count]);
+    }
+}
+
+
+/**
+ * history_last_is - Check whether a line is the newest history entry.
+ * @line: The line.
+ * @len: Its length.
+ *
+ * Before the history is loaded, the newest line this shell added is used,
+ * or else only the end of the file is read.
+ *
+ * Return: 1 if it is, 0 otherwise.
+ */
+static int history_last_is(const char *line, size_t len)
+{
+    char tail[4096];
+    const char *last;
+    size_t last_len;
+    ssize_t count;
+    off_t size;
+
+    if (hist.loaded) {
+        last = history_get(history_count() - 1, &last_len);
+        return (last != NULL && last_len == len && memcmp(last, line, len) == 0);
+    }
+    if (hist.added_count > 0) {
+        return (strcmp(hist.added[hist.added_count - 1], line) == 0);
+    }
+    if (hist.fd < 0 || len + 2 > sizeof(tail)
+        || (size = lseek(hist.fd, 0, SEEK_END)) < (off_t)len + 1) {
+        return (0);
+    }
+    /* The entry and the newline before it, unless it starts the file */
+    count = (size == (off_t)len + 1) ? (ssize_t)len + 1 : (ssize_t)len + 2;
+    if (pread(hist.fd, tail, count, size - count) != count) {
+        return (0);
+    }
+    return (tail[count - 1] == '\n' && memcmp(tail + count - 1 - len, line, len) == 0
+            && (count == (ssize_t)len + 1 || tail[0] == '\n'));
+}
+
+
+/**
+ * history_count - Number of history entries.
+ *
+ * Return: The count.
+ */
+size_t history_count(void)
+{
+    if (!hist.loaded) {
+        history_load();
+    }
+    return (hist.file_count + hist.added_count);
+}
+
+
+/**
+ * history_get - Get an entry of the history.
+ * @index: Entry number, from 0 (oldest).
+ * @len: Where to store its length.
+ *
+ * Return: The entry (not NUL terminated), or NULL if out of range.
+ */
+const char *history_get(size_t index, size_t *len)
+{
+    if (index >= history_count()) {
+        return (NULL);
+    }
+    if (index < hist.file_count) {
+        *len = hist.starts[index + 1] - hist.starts[index] - 1;
+        return (hist.text + hist.starts[index]);
+    }
+    *len = strlen(hist.added[index - hist.file_count]);
+    return (hist.added[index - hist.file_count]);
+}
+
+
+/**
+ * history_add - Record a command line, in memory and in the history file.
+ * @line: The line.
+ *
+ * Blank lines and repeats of the previous entry are not recorded. The
+ * file is written with a single O_APPEND write, so concurrent shells never
+ * interleave their entries.
+ */
+void history_add(const char *line)
+{
+    char **grown, *copy;
+    size_t len = strlen(line);
+
+    if (strspn(line, " \t") == len || strchr(line, '\n') != NULL) {
+        return;
+    }
+    history_open();
+    if (history_last_is(line, len)) {
+        return;
+    }
+    if (hist.added_count == hist.added_cap) {
+        hist.added_cap = hist.added_cap ? hist.added_cap * 2 : 64;
+        grown = realloc(hist.added, hist.added_cap * sizeof(char *));
+        if (grown == NULL) {
+            perror("realloc");
+            return;
+        }
+        hist.added = grown;
+    }
+    copy = malloc(len + 2);
+    if (copy == NULL) {
+        perror("malloc");
+        return;
+    }
+    memcpy(copy, line, len);
+    copy[len] = '\n';
+    if (hist.fd >= 0) {
+        write(hist.fd, copy, len + 1);
+    }
+    copy[len] = '\0';
+    hist.added[hist.added_count++] = copy;
+}
+
+
+/**
+ * trigram_bit - Signature bit of a trigram.
+ * @text: Its three bytes.
+ *
+ * Return: The bit number.
+ */
+static unsigned int trigram_bit(const char *text)
+{
+    uint32_t key = ((unsigned char)text[0] << 16) | ((unsigned char)text[1] << 8)
+                   | (unsigned char)text[2];
+
+    return ((key * 2654435761U) >> (32 - HIST_SIG_SHIFT));
+}
+
+
+/**
+ * history_index - Bring the trigram signatures up to date.
+ *
+ * Return: 0 on success, -1 on allocation failure.
+ */
+static int history_index(void)
+{
+    size_t count = history_count(), blocks = (count + HIST_BLOCK - 1) / HIST_BLOCK;
+    size_t old_blocks = (hist.indexed + HIST_BLOCK - 1) / HIST_BLOCK, len, i;
+    uint32_t *grown, *sig;
+    const char *text;
+    unsigned int bit;
+
+    if (hist.indexed == count) {
+        return (0);
+    }
+    if (blocks > old_blocks) {
+        grown = realloc(hist.sigs, blocks * HIST_SIG_WORDS * sizeof(uint32_t));
+        if (grown == NULL) {
+            perror("realloc");
+            return (-1);
+        }
+        hist.sigs = grown;
+        memset(hist.sigs + old_blocks * HIST_SIG_WORDS, 0,
+               (blocks - old_blocks) * HIST_SIG_WORDS * sizeof(uint32_t));
+    }
+    for (; hist.indexed < count; hist.indexed++) {
+        text = history_get(hist.indexed, &len);
+        sig = hist.sigs + (hist.indexed / HIST_BLOCK) * HIST_SIG_WORDS;
+        for (i = 0; i + 3 <= len; i++) {
+            bit = trigram_bit(text + i);
+            sig[bit / 32] |= 1U << (bit % 32);
+        }
+    }
+    return (0);
+}
+
+
+/**
+ * history_search - Find the newest entry containing a string.
+ * @query: The string.
+ * @len: Its length.
+ * @before: Only entries numbered below this are considered.
+ *
+ * Queries of three bytes or more skip every block whose signature lacks
+ * one of their trigrams, so most of a large history is never read.
+ *
+ * Return: The entry number, or -1 if none matches.
+ */
+long history_search(const char *query, size_t len, size_t before)
+{
+    uint32_t want[HIST_SIG_WORDS], *sig;
+    unsigned char words[HIST_SIG_WORDS];
+    size_t i, nwords = 0, block, first, entry_len;
+    const char *text;
+    unsigned int bit;
+    int usable;
+
+    if (before > history_count()) {
+        before = history_count();
+    }
+    usable = (len >= 3 && history_index() == 0);
+    memset(want, 0, sizeof(want));
+    for (i = 0; usable && i + 3 <= len; i++) {
+        bit = trigram_bit(query + i);
+        want[bit / 32] |= 1U << (bit % 32);
+    }
+    /* Only the signature words holding query bits are read per block */
+    for (i = 0; i < HIST_SIG_WORDS; i++) {
+        if (want[i] != 0) {
+            words[nwords++] = i;
+        }
+    }
+    while (before > 0) {
+        block = (before - 1) / HIST_BLOCK;
+        first = block * HIST_BLOCK;
+        if (usable) {
+            sig = hist.sigs + block * HIST_SIG_WORDS;
+            for (i = 0; i < nwords && (sig[words[i]] & want[words[i]]) == want[words[i]]; i++) {
+            }
+            if (i < nwords) {
+                before = first;
+                continue;
+            }
+        }
+        for (; before > first; before--) {
+            text = history_get(before - 1, &entry_len);
+            if (memmem(text, entry_len, query, len) != NULL) {
+                return ((long)before - 1);
+            }
+        }
+    }
+    return (-1);
+}
+
+
+/**
+ * history_expand - Replace !n, !-n and !! with earlier command lines.
+ * @line: The line as typed (freed when a new one is returned).
+ *
+ * Expansion does not happen inside single quotes. Like other shells, the
+ * expanded line is shown before it runs. The history is only looked at
+ * once a '!' turns out to start one of these, so lines like "if ! cmd" or
+ * "echo hi!" never load it.
+ *
+ * Return: The line to run (malloc'd), or NULL if an event was not found.
+ */
+char *history_expand(char *line)
+{
+    string_buffer sb;
+    const char *p, *text;
+    char *end;
+    size_t len, count = 0;
+    long n;
+    int quoted = 0, changed = 0;
+
+    if (strchr(line, '!') == NULL) {
+        return (line);
+    }
+    sbuf_init(&sb);
+    for (p = line; *p != '\0'; p++) {
+        if (*p == '\'') {
+            quoted = !quoted;
+        }
+        if (quoted || p[0] != '!' || !(p[1] == '!' || isdigit((unsigned char)p[1])
+                                      || (p[1] == '-' && isdigit((unsigned char)p[2])))) {
+            sbuf_addc(&sb, *p);
+            continue;
+        }
+        if (!changed) {
+            count = history_count();
+        }
+        if (p[1] == '!') {
+            n = (long)count - 1;
+            end = (char *)p + 2;
+        } else {
+            n = strtol(p + 1, &end, 10);
+            n = (n < 0) ? (long)count + n : n - 1;
+        }
+        text = (n >= 0) ? history_get(n, &len) : NULL;
+        if (text == NULL) {
+            shell_error("%.*s: event not found", (int)(end - p), p);
+            sbuf_free(&sb);
+            free(line);
+            return (NULL);
+        }
+        sbuf_addn(&sb, text, len);
+        p = end - 1;
+        changed = 1;
+    }
+    if (!changed) {
+        sbuf_free(&sb);
+        return (line);
+    }
+    free(line);
+    line = sbuf_finish(&sb);
+    write(STDOUT_FILENO, line, strlen(line));
+    write(STDOUT_FILENO, "\n", 1);
+    return (line);
+}
@@ -0,0 +1,974 @@
+#include "main.h"
+
+
+int loop_depth = 0;
+int pending_break = 0;
+int pending_continue = 0;
+int pending_return = 0;
+int func_depth = 0;
+
+/* Status of the last command substitution, and how many have run */
+static int subst_status = 0;
+static unsigned long subst_serial = 0;
+
+/**
+ * struct saved_fd - A descriptor set aside while a redirection is active.
+ * @fd: The redirected descriptor.
+ * @copy: Duplicate of its previous target, or -1 if it was closed.
+ * @next: Next saved descriptor.
+ */
+typedef struct saved_fd
+{
+int fd;
+int copy;
+struct saved_fd *next;
+} saved_fd;
+
+
+/**
+ * wait_status - Wait for a child and convert its status like $? does.
+ * @pid: The child.
+ *
+ * Return: The exit status, or 128 + signal number.
+ */
+static int wait_status(pid_t pid)
+{
+    int status;
+
+    while (waitpid(pid, &status, 0) == -1) {
+        if (errno != EINTR) {
+            return (127);
+        }
+    }
+    return (WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+}
+
+
+/**
+ * save_fd - Remember the current target of a descriptor.
+ * @fd: The descriptor about to be redirected.
+ * @saved: List of saved descriptors.
+ */
+static void save_fd(int fd, saved_fd **saved)
+{
+    saved_fd *entry;
+
+    for (entry = *saved; entry != NULL; entry = entry->next) {
+        if (entry->fd == fd) {
+            return;
+        }
+    }
+    entry = malloc(sizeof(*entry));
+    if (entry == NULL) {
+        perror("malloc");
+        return;
+    }
+    entry->fd = fd;
+    entry->copy = fcntl(fd, F_DUPFD_CLOEXEC, 10);
+    entry->next = *saved;
+    *saved = entry;
+}
+
+
+/**
+ * redirect_restore - Undo redirections applied with a save list.
+ * @saved: The list returned through redirect_apply; freed.
+ */
+static void redirect_restore(saved_fd *saved)
+{
+    saved_fd *next;
+
+    if (saved != NULL) {
+        out_retarget();
+        read_sync();
+    }
+    while (saved != NULL) {
+        next = saved->next;
+        if (saved->copy >= 0) {
+            dup2(saved->copy, saved->fd);
+            close(saved->copy);
+        } else {
+            close(saved->fd);
+        }
+        free(saved);
+        saved = next;
+    }
+}
+
+
+/**
+ * open_redirect - Open the file or here-document a redirection refers to.
+ * @r: The redirection (not a descriptor duplication).
+ *
+ * Return: The new descriptor, or -1 after printing an error.
+ */
+static int open_redirect(redirect *r)
+{
+    char *target, *body;
+    int fd, flags;
+
+    if (r->kind == REDIR_HEREDOC || r->kind == REDIR_HEREDOC_STRIP) {
+        body = r->quoted ? stringdup(r->body != NULL ? r->body : "")
+               : expand_heredoc(r->body != NULL ? r->body : "");
+        if (body == NULL) {
+            return (-1);
+        }
+        fd = heredoc_open(body, strlen(body));
+        free(body);
+        return (fd);
+    }
+
+    target = expand_word_string(r->word);
+    if (target == NULL) {
+        return (-1);
+    }
+    switch (r->kind) {
+    case REDIR_IN:
+        flags = O_RDONLY;
+        break;
+    case REDIR_APPEND:
+        flags = O_WRONLY | O_CREAT | O_APPEND;
+        break;
+    case REDIR_RDWR:
+        flags = O_RDWR | O_CREAT;
+        break;
+    default:
+        flags = O_WRONLY | O_CREAT | O_TRUNC;
+        break;
+    }
+    fd = open(target, flags, 0666);
+    if (fd == -1) {
+        if (r->kind == REDIR_IN) {
+            shell_error("cannot open %s: %s", target, errno == ENOENT ? "No such file" : strerror(errno));
+        } else {
+            shell_error("cannot create %s: %s", target,
+                errno == ENOENT ? "Directory nonexistent" : strerror(errno));
+        }
+    }
+    free(target);
+    return (fd);
+}
+
+
+/**
+ * redirect_apply - Perform a command's redirections.
+ * @r: The first redirection.
+ * @saved: Receives what is needed to undo them, or NULL in a child that
+ * never returns to the shell.
+ *
+ * Return: 0 on success, -1 after printing an error.
+ */
+static int redirect_apply(redirect *r, saved_fd **saved)
+{
+    char *target;
+    int fd;
+
+    if (r != NULL) {
+        out_retarget();
+        read_sync();
+        test_forget();
+    }
+    for (; r != NULL; r = r->next) {
+        if (saved != NULL) {
+            save_fd(r->fd, saved);
+        }
+        if (r->kind == REDIR_DUPIN || r->kind == REDIR_DUPOUT) {
+            target = expand_word_string(r->word);
+            if (target == NULL) {
+                return (-1);
+            }
+            if (stringcmp(target, "-") == 0) {
+                close(r->fd);
+            } else if (!is_integer(target) || target[0] == '-') {
+                shell_error("Syntax error: Bad fd number");
+                free(target);
+                return (-1);
+            } else if (atoi(target) != r->fd && dup2(atoi(target), r->fd) == -1) {
+                shell_error("%s: Bad file descriptor", target);
+                free(target);
+                return (-1);
+            }
+            free(target);
+            continue;
+        }
+        fd = open_redirect(r);
+        if (fd == -1) {
+            return (-1);
+        }
+        if (fd != r->fd) {
+            dup2(fd, r->fd);
+            close(fd);
+        }
+    }
+    return (0);
+}
+
+
+/**
+ * assign_all - Perform the NAME=value words of a command.
+ * @assigns: The raw assignment words (may be NULL).
+ * @export: Non-zero to put them in the environment (in a child).
+ *
+ * Return: 0 on success, 2 on error.
+ */
+static int assign_all(char **assigns, int export)
+{
+    char *value, *equal;
+    int i, status = 0;
+
+    for (i = 0; assigns != NULL && assigns[i] != NULL && status == 0; i++) {
+        equal = strchr(assigns[i], '=');
+        value = expand_word_string(equal + 1);
+        if (value == NULL) {
+            return (2);
+        }
+        *equal = '\0';
+        if (export) {
+            setenv(assigns[i], value, 1);
+        } else if (var_set(assigns[i], value) != 0) {
+            status = 2;
+        }
+        *equal = '=';
+        free(value);
+    }
+    return (status);
+}
+
+
+/**
+ * assign_temporary - Export assignments for the duration of a builtin.
+ * @assigns: The raw assignment words.
+ *
+ * Return: The previous values as "NAME=value" (or "NAME" if unset), to be
+ * handed to restore_temporary.
+ */
+static char **assign_temporary(char **assigns)
+{
+    char **saved;
+    char *equal, *old;
+    string_buffer sb;
+    int i, count = 0;
+
+    while (assigns[count] != NULL) {
+        count++;
+    }
+    saved = calloc(count + 1, sizeof(char *));
+    if (saved == NULL) {
+        perror("malloc");
+        return (NULL);
+    }
+    for (i = 0; i < count; i++) {
+        equal = strchr(assigns[i], '=');
+        sbuf_init(&sb);
+        sbuf_addn(&sb, assigns[i], equal - assigns[i]);
+        old = getenv(sb.data);
+        if (old != NULL) {
+            sbuf_addc(&sb, '=');
+            sbuf_adds(&sb, old);
+        }
+        saved[i] = sbuf_finish(&sb);
+    }
+    assign_all(assigns, 1);
+    return (saved);
+}
+
+
+/**
+ * restore_temporary - Undo assign_temporary.
+ * @saved: The saved values; freed.
+ */
+static void restore_temporary(char **saved)
+{
+    char *equal;
+    int i;
+
+    for (i = 0; saved != NULL && saved[i] != NULL; i++) {
+        equal = strchr(saved[i], '=');
+        if (equal == NULL) {
+            unsetenv(saved[i]);
+            continue;
+        }
+        *equal = '\0';
+        setenv(saved[i], equal + 1, 1);
+    }
+    free_words(saved);
+}
+
+
+/**
+ * exec_external - Replace the current (child) process with a program.
+ * @path: Path of the program.
+ * @argv: Argument vector.
+ * @node: The command, for its assignments and redirections.
+ */
+static void exec_external(char *path, char **argv, ast_node *node)
+{
+    assign_all(node->assigns, 1);
+    if (redirect_apply(node->redirs, NULL) != 0) {
+        out_exit(2);
+    }
+    out_flush();
+    read_sync();
+    execve(path, argv, environ);
+    if (errno == ENOENT) {
+        shell_error("%s: not found", argv[0]);
+        _exit(127);
+    }
+    shell_error("%s: %s", argv[0], errno == EACCES ? "Permission denied" : strerror(errno));
+    _exit(126);
+}
+
+
+/**
+ * call_function - Invoke a shell function in the current process.
+ * @func: The function.
+ * @argv: Argument vector; argv[1]... become the positional parameters.
+ *
+ * Return: The status given to return, or of the last command run.
+ */
+static int call_function(shell_func *func, char **argv)
+{
+    char **saved_params = positional_params;
+    int saved_count = positional_count, saved_depth = loop_depth, status;
+    ast_node *body = func->body;
+
+    positional_params = argv + 1;
+    positional_count = 0;
+    while (argv[positional_count + 1] != NULL) {
+        positional_count++;
+    }
+    /* Hold a reference so the function may redefine itself while running */
+    body->refs++;
+    var_scope_push();
+    func_depth++;
+    loop_depth = 0;
+    status = execute_node(body, 0);
+    loop_depth = saved_depth;
+    func_depth--;
+    var_scope_pop();
+    ast_free(body);
+    pending_return = 0;
+    positional_params = saved_params;
+    positional_count = saved_count;
+    return (status);
+}
+
+
+/**
+ * execute_simple - Run a simple command.
+ * @node: The command.
+ * @flags: EXEC_NOFORK if the shell may exec the command directly.
+ *
+ * Builtins run inside the shell with their redirections undone afterwards.
+ * Other commands are looked up in PATH first, so no process is created
+ * for a command that does not exist.
+ *
+ * Return: The exit status.
+ */
+static int execute_simple(ast_node *node, int flags)
+{
+    builtin_entry *builtin;
+    shell_func *func = NULL;
+    saved_fd *saved = NULL;
+    char **argv, *path, **environment = NULL;
+    int status = 0;
+    unsigned long serial = subst_serial;
+    pid_t pid;
+
+    shell_lineno = node->lineno;
+    argv = expand_words(node->words);
+    if (argv == NULL) {
+        /* Expansion errors abort a non-interactive shell, as in dash */
+        if (!isInteractiveMode()) {
+            exit(2);
+        }
+        return (2);
+    }
+    /* Special builtins come first, then functions, then other builtins */
+    builtin = (argv[0] != NULL) ? find_builtin(argv[0]) : NULL;
+    if (argv[0] != NULL && (builtin == NULL || !builtin->special)) {
+        func = func_lookup(argv[0]);
+        builtin = (func != NULL) ? NULL : builtin;
+    }
+    /* Anything but a test may change the files a later test looks at */
+    if (builtin == NULL || builtin->handler != builtin_test) {
+        test_forget();
+    }
+    if (argv[0] == NULL || builtin != NULL || func != NULL) {
+        if (argv[0] == NULL || (builtin != NULL && builtin->special)) {
+            status = assign_all(node->assigns, 0);
+            /* Without a command, the status is that of the last $(...) */
+            if (argv[0] == NULL && status == 0 && subst_serial != serial) {
+                status = subst_status;
+            }
+        } else if (node->assigns != NULL) {
+            environment = assign_temporary(node->assigns);
+        }
+        if (status == 0 && redirect_apply(node->redirs, &saved) != 0) {
+            status = 2;
+        }
+        if (status == 0 && builtin != NULL) {
+            out_failed();
+            status = builtin->handler(argv);
+            /* Output sent elsewhere is written before the status is known */
+            if (saved != NULL) {
+                out_flush();
+            }
+            if (out_failed()) {
+                shell_error("%s: I/O error", argv[0]);
+                status = 1;
+            }
+        } else if (status == 0 && func != NULL) {
+            status = call_function(func, argv);
+        }
+        redirect_restore(saved);
+        restore_temporary(environment);
+        free_words(argv);
+        return (status);
+    }
+
+    path = (strchr(argv[0], '/') != NULL) ? stringdup(argv[0]) : search_path(argv[0], X_OK);
+    if (path == NULL) {
+        /* The diagnostic honours the command's own redirections */
+        if (redirect_apply(node->redirs, &saved) == 0) {
+            shell_error("%s: not found", argv[0]);
+        }
+        redirect_restore(saved);
+        free_words(argv);
+        return (127);
+    }
+    if (flags & EXEC_NOFORK) {
+        exec_external(path, argv, node);
+    }
+    out_flush();
+    read_sync();
+    pid = fork();
+    if (pid == 0) {
+        exec_external(path, argv, node);
+    }
+    free(path);
+    free_words(argv);
+    if (pid == -1) {
+        perror("fork");
+        return (2);
+    }
+    return (wait_status(pid));
+}
+
+
+/**
+ * execute_pipeline - Run the commands of a pipeline concurrently.
+ * @node: The NODE_PIPE tree (left nested: ((a | b) | c)).
+ *
+ * Return: The exit status of the last command.
+ */
+static int execute_pipeline(ast_node *node)
+{
+    ast_node **stages, *p;
+    pid_t *pids;
+    int count = 1, i, fds[2], in_fd = -1, status = 0;
+
+    for (p = node; p->kind == NODE_PIPE; p = p->left) {
+        count++;
+    }
+    stages = malloc(count * sizeof(*stages));
+    pids = malloc(count * sizeof(*pids));
+    if (stages == NULL || pids == NULL) {
+        perror("malloc");
+        free(stages);
+        free(pids);
+        return (2);
+    }
+    i = count - 1;
+    for (p = node; p->kind == NODE_PIPE; p = p->left) {
+        stages[i--] = p->right;
+    }
+    stages[0] = p;
+
+    for (i = 0; i < count; i++) {
+        if (i < count - 1 && pipe(fds) != 0) {
+            perror("pipe");
+            break;
+        }
+        out_flush();
+        read_sync();
+        pids[i] = fork();
+        if (pids[i] == 0) {
+            if (in_fd >= 0) {
+                dup2(in_fd, STDIN_FILENO);
+                close(in_fd);
+            }
+            if (i < count - 1) {
+                close(fds[0]);
+                dup2(fds[1], STDOUT_FILENO);
+                close(fds[1]);
+                out_retarget();
+            }
+            out_exit(execute_node(stages[i], EXEC_NOFORK));
+        }
+        if (in_fd >= 0) {
+            close(in_fd);
+        }
+        if (i < count - 1) {
+            close(fds[1]);
+            in_fd = fds[0];
+        }
+        if (pids[i] == -1) {
+            perror("fork");
+            break;
+        }
+    }
+    if (in_fd >= 0 && i < count) {
+        close(in_fd);
+    }
+    count = i;
+    for (i = 0; i < count; i++) {
+        status = wait_status(pids[i]);
+    }
+    free(stages);
+    free(pids);
+    return (status);
+}
+
+
+/**
+ * execute_async - Run a command in the background.
+ * @node: The command.
+ *
+ * Without job control the command's standard input is /dev/null.
+ *
+ * Return: 0.
+ */
+static int execute_async(ast_node *node)
+{
+    pid_t pid;
+    int fd;
+
+    out_flush();
+    read_sync();
+    pid = fork();
+    if (pid == 0) {
+        fd = open("/dev/null", O_RDONLY);
+        if (fd > 0) {
+            dup2(fd, STDIN_FILENO);
+            close(fd);
+        }
+        out_exit(execute_node(node, EXEC_NOFORK));
+    }
+    if (pid == -1) {
+        perror("fork");
+        return (2);
+    }
+    return (0);
+}
+
+
+/**
+ * execute_subshell - Run commands in a child copy of the shell.
+ * @node: The commands.
+ * @flags: EXEC_NOFORK if this process may be used directly.
+ *
+ * Return: The exit status of the commands.
+ */
+static int execute_subshell(ast_node *node, int flags)
+{
+    pid_t pid;
+
+    if (flags & EXEC_NOFORK) {
+        return (execute_node(node, EXEC_NOFORK));
+    }
+    out_flush();
+    read_sync();
+    pid = fork();
+    if (pid == 0) {
+        out_exit(execute_node(node, EXEC_NOFORK));
+    }
+    if (pid == -1) {
+        perror("fork");
+        return (2);
+    }
+    return (wait_status(pid));
+}
+
+
+/**
+ * control_pending - Check whether break, continue or return is unwinding.
+ *
+ * Return: Non-zero if the rest of the current list must be skipped.
+ */
+static int control_pending(void)
+{
+    return (pending_break || pending_continue || pending_return);
+}
+
+
+/**
+ * loop_should_stop - Consume a pending break or continue at a loop's end.
+ *
+ * Return: 1 if the loop must stop, 0 to run the next iteration.
+ */
+static int loop_should_stop(void)
+{
+    if (pending_return) {
+        return (1);
+    }
+    if (pending_break > 0) {
+        pending_break--;
+        return (1);
+    }
+    if (pending_continue > 0) {
+        /* Still positive means an outer loop is to be continued */
+        return (--pending_continue > 0);
+    }
+    return (0);
+}
+
+
+/**
+ * execute_loop - Run a while or until loop.
+ * @node: The loop.
+ *
+ * Return: The status of the last body run, or 0.
+ */
+static int execute_loop(ast_node *node)
+{
+    int status = 0, condition;
+
+    loop_depth++;
+    for (;;) {
+        condition = execute_node(node->left, 0);
+        if (control_pending()) {
+            if (loop_should_stop()) {
+                break;
+            }
+            continue;
+        }
+        if ((condition == 0) != (node->kind == NODE_WHILE)) {
+            break;
+        }
+        status = execute_node(node->right, 0);
+        if (loop_should_stop()) {
+            break;
+        }
+    }
+    loop_depth--;
+    return (status);
+}
+
+
+/**
+ * execute_for - Run a for loop.
+ * @node: The loop.
+ *
+ * Return: The status of the last body run, or 0.
+ */
+static int execute_for(ast_node *node)
+{
+    char **items;
+    int status = 0, i;
+
+    if (node->words != NULL) {
+        items = expand_words(node->words);
+    } else {
+        /* Without "in words" the loop runs over the positional parameters */
+        items = calloc(positional_count + 1, sizeof(char *));
+        for (i = 0; items != NULL && i < positional_count; i++) {
+            items[i] = stringdup(positional_params[i]);
+        }
+    }
+    if (items == NULL) {
+        return (2);
+    }
+    loop_depth++;
+    for (i = 0; items[i] != NULL; i++) {
+        if (var_set(node->name, items[i]) != 0) {
+            status = 2;
+            break;
+        }
+        status = execute_node(node->left, 0);
+        if (loop_should_stop()) {
+            break;
+        }
+    }
+    loop_depth--;
+    free_words(items);
+    return (status);
+}
+
+
+/**
+ * execute_case - Run the first arm of a case whose pattern matches.
+ * @node: The case command.
+ * @flags: Execution flags for the chosen arm.
+ *
+ * Return: The status of the arm, or 0 if none matched.
+ */
+static int execute_case(ast_node *node, int flags)
+{
+    case_item *item;
+    char *subject, *pattern;
+    int i, matched = 0;
+
+    subject = expand_word_string(node->name);
+    if (subject == NULL) {
+        return (2);
+    }
+    for (item = node->cases; item != NULL && !matched; item = item->next) {
+        for (i = 0; item->patterns[i] != NULL && !matched; i++) {
+            pattern = expand_pattern(item->patterns[i]);
+            matched = (pattern != NULL && glob_match(pattern, subject));
+            free(pattern);
+        }
+        if (matched) {
+            free(subject);
+            return (execute_node(item->body, flags));
+        }
+    }
+    free(subject);
+    return (0);
+}
+
+
+/**
+ * execute_compound - Dispatch on the kind of a node.
+ * @node: The node.
+ * @flags: Execution flags.
+ *
+ * Return: The exit status.
+ */
+static int execute_compound(ast_node *node, int flags)
+{
+    int status;
+
+    switch (node->kind) {
+    case NODE_SIMPLE:
+        return (execute_simple(node, flags));
+    case NODE_PIPE:
+        return (execute_pipeline(node));
+    case NODE_SEQ:
+        execute_node(node->left, 0);
+        if (control_pending()) {
+            return (last_exit_status);
+        }
+        return (execute_node(node->right, flags));
+    case NODE_AND:
+    case NODE_OR:
+        status = execute_node(node->left, EXEC_AND_OR);
+        if ((status == 0) != (node->kind == NODE_AND) || control_pending()) {
+            return (status);
+        }
+        return (execute_node(node->right, flags | EXEC_AND_OR));
+    case NODE_NOT:
+        return (!execute_node(node->left, EXEC_AND_OR));
+    case NODE_BACKGROUND:
+        return (execute_async(node->left));
+    case NODE_SUBSHELL:
+        return (execute_subshell(node->left, flags));
+    case NODE_GROUP:
+        return (execute_node(node->left, flags));
+    case NODE_IF:
+        status = execute_node(node->left, 0);
+        if (control_pending()) {
+            return (status);
+        }
+        if (status == 0) {
+            return (execute_node(node->right, flags));
+        }
+        return (node->alt != NULL ? execute_node(node->alt, flags) : 0);
+    case NODE_WHILE:
+    case NODE_UNTIL:
+        return (execute_loop(node));
+    case NODE_FOR:
+        return (execute_for(node));
+    case NODE_CASE:
+        return (execute_case(node, flags));
+    case NODE_FUNCDEF:
+        return (func_define(node->name, node->left) == 0 ? 0 : 2);
+    }
+    return (0);
+}
+
+
+/**
+ * execute_node - Execute a syntax tree.
+ * @node: The tree (NULL does nothing).
+ * @flags: EXEC_NOFORK when the process ends after this command, which lets
+ * the last external command replace the process instead of forking.
+ * EXEC_AND_OR marks an operand of && || or !, whose tests share the
+ * file status cached by the first one.
+ *
+ * Compound commands run inside the shell; only external commands,
+ * pipelines, subshells and background jobs create processes.
+ *
+ * Return: The exit status, also stored in last_exit_status.
+ */
+int execute_node(ast_node *node, int flags)
+{
+    saved_fd *saved = NULL;
+    int status;
+
+    if (node == NULL) {
+        return (0);
+    }
+    /* A new && / || list: its tests may not reuse older file status */
+    if (!(flags & EXEC_AND_OR)) {
+        test_forget();
+    }
+    flags &= ~EXEC_AND_OR;
+    if (node->kind != NODE_SIMPLE && node->redirs != NULL) {
+        status = 2;
+        if (redirect_apply(node->redirs, &saved) == 0) {
+            status = execute_compound(node, flags & ~EXEC_NOFORK);
+        }
+        redirect_restore(saved);
+    } else {
+        status = execute_compound(node, flags);
+    }
+    last_exit_status = status;
+    return (status);
+}
+
+
+/**
+ * run_tree - Run one top-level command and release it.
+ * @tree: The command (may be NULL for an empty line).
+ * @flags: EXEC_NOFORK if it is the last command of a shell about to exit.
+ *
+ * Return: Non-zero if a top-level return asked to stop reading the source.
+ */
+int run_tree(ast_node *tree, int flags)
+{
+    execute_node(tree, flags);
+    ast_free(tree);
+    pending_break = 0;
+    pending_continue = 0;
+    if (pending_return) {
+        /* return outside a function ends the script being read */
+        pending_return = 0;
+        return (1);
+    }
+    /* Collect finished background jobs */
+    segment_reap();
+    return (0);
+}
+
+
+/**
+ * run_source - Parse and run every command of a source.
+ * @src: The input.
+ * @flags: EXEC_NOFORK if the process exits once the source is done; the
+ * last command may then exec in place (never pass it for a terminal).
+ *
+ * Each complete command is executed as soon as it has been parsed. A
+ * syntax error ends a non-interactive shell.
+ *
+ * Return: The exit status of the last command.
+ */
+int run_source(input_source *src, int flags)
+{
+    parser ps;
+    ast_node *tree;
+    int status;
+
+    parser_init(&ps, src);
+    for (;;) {
+        tree = parse_command(&ps, &status);
+        if (status == PARSE_EOF) {
+            break;
+        }
+        if (status == PARSE_ERROR) {
+            last_exit_status = 2;
+            if (!src->interactive) {
+                break;
+            }
+            continue;
+        }
+        /* Only look ahead for the end when it was asked for */
+        if (run_tree(tree, (flags & EXEC_NOFORK) && parser_at_eof(&ps) ? EXEC_NOFORK : 0)) {
+            break;
+        }
+    }
+    parser_free(&ps);
+    return (last_exit_status);
+}
+
+
+/**
+ * run_string - Parse and run commands held in a string.
+ * @text: The commands.
+ * @flags: EXEC_NOFORK if the process exits afterwards (see run_source).
+ *
+ * Return: The exit status of the last command.
+ */
+int run_string(const char *text, int flags)
+{
+    input_source src;
+    int status;
+
+    source_init_string(&src, text);
+    status = run_source(&src, flags);
+    source_free(&src);
+    return (status);
+}
+
+
+/**
+ * command_substitute - Run commands and capture their standard output.
+ * @text: The commands of a $(...) or `...` substitution.
+ *
+ * Trailing newlines are removed from the output, as POSIX requires.
+ *
+ * Return: The output (malloc'd), or NULL on error.
+ */
+char *command_substitute(const char *text)
+{
+    string_buffer sb;
+    char buffer[4096];
+    ssize_t count;
+    int fds[2];
+    pid_t pid;
+
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        return (NULL);
+    }
+    out_flush();
+    read_sync();
+    test_forget();
+    pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        if (fds[1] != STDOUT_FILENO) {
+            dup2(fds[1], STDOUT_FILENO);
+            close(fds[1]);
+        }
+        out_retarget();
+        out_exit(run_string(text, EXEC_NOFORK));
+    }
+    close(fds[1]);
+    if (pid == -1) {
+        perror("fork");
+        close(fds[0]);
+        return (NULL);
+    }
+
+    sbuf_init(&sb);
+    sbuf_reserve(&sb, 0);
+    while ((count = read(fds[0], buffer, sizeof(buffer))) != 0) {
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        sbuf_addn(&sb, buffer, count);
+    }
+    close(fds[0]);
+    last_exit_status = wait_status(pid);
+    subst_status = last_exit_status;
+    subst_serial++;
+    while (sb.len > 0 && sb.data[sb.len - 1] == '\n') {
+        sb.data[--sb.len] = '\0';
+    }
+    return (sbuf_finish(&sb));
+}
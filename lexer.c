@@ -0,0 +1,644 @@
+#include "main.h"
+
+
+/**
+ * stdin_refill - Append the next line of standard input to a source.
+ * @src: The source.
+ *
+ * In interactive mode the line is read with the line editor, showing the
+ * normal prompt for a new command and "> " when the command needs more
+ * lines.
+ *
+ * Return: 1 if text was added, 0 at end of input.
+ */
+static int stdin_refill(input_source *src)
+{
+    const char *prompt;
+    char *line;
+    size_t len, need, prompt_len = 0;
+    char *grown;
+
+    out_flush();
+    if (src->interactive) {
+        prompt = src->continuation ? "> " : prompt_render(&prompt_len);
+        line = line_edit(prompt, src->continuation ? 2 : prompt_len);
+        if (line != NULL) {
+            line = history_expand(line);
+            if (line == NULL) {
+                line = stringdup("");
+            } else {
+                history_add(line);
+            }
+            prompt_command_start();
+        }
+    } else {
+        line = read_line_raw();
+    }
+    src->continuation = 1;
+    if (line == NULL) {
+        src->eof = 1;
+        return (0);
+    }
+
+    /* Consumed text is dropped so the buffer only holds the current command */
+    if (src->pos > 0) {
+        memmove(src->buf, src->buf + src->pos, src->len - src->pos);
+        src->len -= src->pos;
+        src->pos = 0;
+    }
+    len = strlen(line);
+    need = src->len + len + 2;
+    if (need > src->cap) {
+        grown = realloc(src->buf, need * 2);
+        if (grown == NULL) {
+            perror("realloc");
+            free(line);
+            src->eof = 1;
+            return (0);
+        }
+        src->buf = grown;
+        src->cap = need * 2;
+    }
+    memcpy(src->buf + src->len, line, len);
+    src->len += len;
+    src->buf[src->len++] = '\n';
+    src->buf[src->len] = '\0';
+    free(line);
+    return (1);
+}
+
+
+/**
+ * source_init_string - Read commands from a string.
+ * @src: The source to initialize.
+ * @text: The commands; copied.
+ */
+void source_init_string(input_source *src, const char *text)
+{
+    src->len = strlen(text);
+    src->cap = src->len + 1;
+    src->buf = malloc(src->cap);
+    if (src->buf == NULL) {
+        perror("malloc");
+        src->len = 0;
+        src->cap = 0;
+    } else {
+        memcpy(src->buf, text, src->cap);
+    }
+    src->pos = 0;
+    src->fd = -1;
+    src->whole = 0;
+    src->lineno = 1;
+    src->interactive = 0;
+    src->continuation = 0;
+    src->eof = 1;
+    src->refill = NULL;
+}
+
+
+/**
+ * source_init_stdin - Read commands from standard input.
+ * @src: The source to initialize.
+ *
+ * A terminal is read line by line, with prompts. Anything else (pipes,
+ * redirected files) is read in large blocks through a private copy of
+ * the descriptor, like a script file.
+ */
+void source_init_stdin(input_source *src)
+{
+    src->buf = NULL;
+    src->len = 0;
+    src->cap = 0;
+    src->pos = 0;
+    src->fd = -1;
+    src->whole = 0;
+    src->lineno = 1;
+    src->interactive = isInteractiveMode();
+    src->continuation = 0;
+    src->eof = 0;
+    src->refill = stdin_refill;
+    if (!src->interactive) {
+        src->fd = fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 10);
+        if (src->fd >= 0) {
+            src->refill = source_read_block;
+        }
+    }
+}
+
+
+/**
+ * source_free - Release the buffer and file of a source.
+ * @src: The source.
+ */
+void source_free(input_source *src)
+{
+    if (src->cap > 0) {
+        free(src->buf);
+    }
+    if (src->fd >= 0) {
+        close(src->fd);
+    }
+    src->fd = -1;
+    src->whole = 0;
+    src->buf = NULL;
+    src->len = 0;
+    src->cap = 0;
+}
+
+
+/**
+ * lexer_init - Start tokenizing a source.
+ * @lx: The lexer.
+ * @src: The source.
+ */
+void lexer_init(lexer *lx, input_source *src)
+{
+    lx->src = src;
+    lx->alias_text = NULL;
+    lx->alias_pos = 0;
+    lx->alias_name = NULL;
+    lx->pending = NULL;
+    lx->npending = 0;
+    lx->pending_cap = 0;
+}
+
+
+/**
+ * lexer_free - Release the lexer's alias and here-document state.
+ * @lx: The lexer.
+ */
+void lexer_free(lexer *lx)
+{
+    free(lx->alias_text);
+    free(lx->alias_name);
+    free(lx->pending);
+    lx->alias_text = NULL;
+    lx->alias_name = NULL;
+    lx->pending = NULL;
+    lx->npending = 0;
+    lx->pending_cap = 0;
+}
+
+
+/**
+ * lexer_push_alias - Make the lexer read an alias value before the source.
+ * @lx: The lexer.
+ * @name: Alias name, remembered so the alias cannot expand itself.
+ * @value: Replacement text.
+ */
+void lexer_push_alias(lexer *lx, const char *name, const char *value)
+{
+    string_buffer sb;
+
+    sbuf_init(&sb);
+    sbuf_adds(&sb, value);
+    if (lx->alias_text != NULL) {
+        sbuf_adds(&sb, lx->alias_text + lx->alias_pos);
+    }
+    free(lx->alias_text);
+    free(lx->alias_name);
+    lx->alias_text = sbuf_finish(&sb);
+    lx->alias_pos = 0;
+    lx->alias_name = stringdup(name);
+}
+
+
+/**
+ * lexer_add_heredoc - Queue a here-document whose body follows the next newline.
+ * @lx: The lexer.
+ * @r: The redirection receiving the body.
+ */
+void lexer_add_heredoc(lexer *lx, redirect *r)
+{
+    redirect **grown;
+    int cap;
+
+    if (lx->npending == lx->pending_cap) {
+        cap = lx->pending_cap ? lx->pending_cap * 2 : 4;
+        grown = realloc(lx->pending, cap * sizeof(*grown));
+        if (grown == NULL) {
+            perror("realloc");
+            return;
+        }
+        lx->pending = grown;
+        lx->pending_cap = cap;
+    }
+    lx->pending[lx->npending++] = r;
+}
+
+
+/**
+ * token_free - Release the text of a token.
+ * @tok: The token.
+ */
+void token_free(token *tok)
+{
+    free(tok->text);
+    tok->text = NULL;
+}
+
+
+/**
+ * lx_peek - Look at an upcoming character without consuming it.
+ * @lx: The lexer.
+ * @ahead: How many characters ahead to look.
+ *
+ * Return: The character, or -1 at end of input.
+ */
+static int lx_peek(lexer *lx, size_t ahead)
+{
+    input_source *src = lx->src;
+    size_t left;
+
+    if (lx->alias_text != NULL) {
+        left = strlen(lx->alias_text + lx->alias_pos);
+        if (ahead < left) {
+            return ((unsigned char)lx->alias_text[lx->alias_pos + ahead]);
+        }
+        ahead -= left;
+    }
+    while (src->pos + ahead >= src->len) {
+        if (src->eof || src->refill == NULL || !src->refill(src)) {
+            return (-1);
+        }
+    }
+    return ((unsigned char)src->buf[src->pos + ahead]);
+}
+
+
+/**
+ * lx_getc - Consume one character.
+ * @lx: The lexer.
+ *
+ * Return: The character, or -1 at end of input.
+ */
+static int lx_getc(lexer *lx)
+{
+    int c = lx_peek(lx, 0);
+
+    if (c == -1) {
+        return (-1);
+    }
+    if (lx->alias_text != NULL && lx->alias_text[lx->alias_pos] != '\0') {
+        lx->alias_pos++;
+        if (lx->alias_text[lx->alias_pos] == '\0') {
+            free(lx->alias_text);
+            lx->alias_text = NULL;
+        }
+        return (c);
+    }
+    if (lx->alias_text != NULL) {
+        free(lx->alias_text);
+        lx->alias_text = NULL;
+    }
+    lx->src->pos++;
+    if (c == '\n') {
+        lx->src->lineno++;
+    }
+    return (c);
+}
+
+
+/**
+ * lx_skip_continuations - Drop backslash-newline pairs at the read position.
+ * @lx: The lexer.
+ */
+static void lx_skip_continuations(lexer *lx)
+{
+    while (lx_peek(lx, 0) == '\\' && lx_peek(lx, 1) == '\n') {
+        lx_getc(lx);
+        lx_getc(lx);
+    }
+}
+
+
+/**
+ * lx_unterminated - Report input that ended inside a quoted construct.
+ *
+ * Return: -1.
+ */
+static int lx_unterminated(void)
+{
+    shell_error("Syntax error: Unterminated quoted string");
+    return (-1);
+}
+
+
+static int lx_scan_dollar(lexer *lx, string_buffer *sb);
+
+/**
+ * lx_scan_quoted - Copy a quoted section, including both quote characters.
+ * @lx: The lexer, positioned at the opening quote.
+ * @sb: Receives the text.
+ *
+ * Return: 0 on success, -1 if the input ends first.
+ */
+static int lx_scan_quoted(lexer *lx, string_buffer *sb)
+{
+    int quote = lx_getc(lx), c;
+
+    sbuf_addc(sb, quote);
+    for (;;) {
+        c = lx_peek(lx, 0);
+        if (c == -1) {
+            return (lx_unterminated());
+        }
+        if (c == quote) {
+            sbuf_addc(sb, lx_getc(lx));
+            return (0);
+        }
+        if (quote == '\'') {
+            sbuf_addc(sb, lx_getc(lx));
+        } else if (c == '\\') {
+            lx_getc(lx);
+            c = lx_getc(lx);
+            if (c == -1) {
+                return (lx_unterminated());
+            }
+            if (c != '\n') {
+                sbuf_addc(sb, '\\');
+                sbuf_addc(sb, c);
+            }
+        } else if (c == '$') {
+            if (lx_scan_dollar(lx, sb) != 0) {
+                return (-1);
+            }
+        } else if (c == '`' && quote == '"') {
+            if (lx_scan_quoted(lx, sb) != 0) {
+                return (-1);
+            }
+        } else {
+            sbuf_addc(sb, lx_getc(lx));
+        }
+    }
+}
+
+
+/**
+ * lx_scan_nested - Copy text up to the bracket that closes an expansion.
+ * @lx: The lexer, positioned after the opening bracket.
+ * @sb: Receives the text, closing bracket included.
+ * @open: Opening bracket character.
+ * @close: Closing bracket character.
+ *
+ * Return: 0 on success, -1 if the input ends first.
+ */
+static int lx_scan_nested(lexer *lx, string_buffer *sb, int open, int close)
+{
+    int depth = 1, c;
+
+    for (;;) {
+        c = lx_peek(lx, 0);
+        if (c == -1) {
+            return (lx_unterminated());
+        }
+        if (c == '\'' || c == '"' || c == '`') {
+            if (lx_scan_quoted(lx, sb) != 0) {
+                return (-1);
+            }
+            continue;
+        }
+        if (c == '\\') {
+            sbuf_addc(sb, lx_getc(lx));
+            c = lx_getc(lx);
+            if (c == -1) {
+                return (lx_unterminated());
+            }
+            sbuf_addc(sb, c);
+            continue;
+        }
+        sbuf_addc(sb, lx_getc(lx));
+        if (c == open) {
+            depth++;
+        } else if (c == close && --depth == 0) {
+            return (0);
+        }
+    }
+}
+
+
+/**
+ * lx_scan_dollar - Copy a $ construct: $(...), $((...)), ${...} or $name.
+ * @lx: The lexer, positioned at the '$'.
+ * @sb: Receives the text.
+ *
+ * Return: 0 on success, -1 if the input ends inside the construct.
+ */
+static int lx_scan_dollar(lexer *lx, string_buffer *sb)
+{
+    int c;
+
+    sbuf_addc(sb, lx_getc(lx));
+    c = lx_peek(lx, 0);
+    if (c == '(' || c == '{') {
+        sbuf_addc(sb, lx_getc(lx));
+        return (lx_scan_nested(lx, sb, c, c == '(' ? ')' : '}'));
+    }
+    return (0);
+}
+
+
+/**
+ * lx_operator - Read an operator token.
+ * @lx: The lexer, positioned at the operator.
+ * @tok: Receives the token.
+ *
+ * Return: 1 if an operator was read, 0 if the next character starts a word.
+ */
+static int lx_operator(lexer *lx, token *tok)
+{
+    int c = lx_peek(lx, 0), next;
+
+    if (c == -1 || strchr(";&|()<>\n", c) == NULL) {
+        return (0);
+    }
+    lx_getc(lx);
+    if (c == '\n') {
+        /* Never look past a newline: the next line may not be typed yet */
+        tok->type = TOK_NEWLINE;
+        return (1);
+    }
+    next = lx_peek(lx, 0);
+    switch (c) {
+    case '(':
+        tok->type = TOK_LPAREN;
+        break;
+    case ')':
+        tok->type = TOK_RPAREN;
+        break;
+    case ';':
+        tok->type = (next == ';') ? TOK_DSEMI : TOK_SEMI;
+        break;
+    case '&':
+        tok->type = (next == '&') ? TOK_AND_IF : TOK_AMP;
+        break;
+    case '|':
+        tok->type = (next == '|') ? TOK_OR_IF : TOK_PIPE;
+        break;
+    case '<':
+        tok->type = TOK_REDIR;
+        tok->redir = REDIR_IN;
+        if (next == '<') {
+            lx_getc(lx);
+            tok->redir = REDIR_HEREDOC;
+            if (lx_peek(lx, 0) == '-') {
+                tok->redir = REDIR_HEREDOC_STRIP;
+                lx_getc(lx);
+            }
+            return (1);
+        }
+        tok->redir = next == '&' ? REDIR_DUPIN : next == '>' ? REDIR_RDWR : REDIR_IN;
+        break;
+    default:
+        tok->type = TOK_REDIR;
+        tok->redir = next == '>' ? REDIR_APPEND : next == '&' ? REDIR_DUPOUT
+                     : next == '|' ? REDIR_CLOBBER : REDIR_OUT;
+        break;
+    }
+    /* Two-character operators consume their second character */
+    if (tok->type == TOK_DSEMI || tok->type == TOK_AND_IF || tok->type == TOK_OR_IF
+        || (tok->type == TOK_REDIR && tok->redir != REDIR_IN && tok->redir != REDIR_OUT)) {
+        lx_getc(lx);
+    }
+    return (1);
+}
+
+
+/**
+ * lx_read_heredocs - Read the bodies of the pending here-documents.
+ * @lx: The lexer, positioned at the start of the line after the operator.
+ */
+static void lx_read_heredocs(lexer *lx)
+{
+    string_buffer body, line;
+    redirect *r;
+    int i, c;
+    char *text;
+
+    for (i = 0; i < lx->npending; i++) {
+        r = lx->pending[i];
+        sbuf_init(&body);
+        sbuf_reserve(&body, 0);
+        for (;;) {
+            sbuf_init(&line);
+            sbuf_reserve(&line, 0);
+            while ((c = lx_getc(lx)) != -1 && c != '\n') {
+                sbuf_addc(&line, c);
+            }
+            text = line.data;
+            while (r->kind == REDIR_HEREDOC_STRIP && *text == '\t') {
+                text++;
+            }
+            if (stringcmp(text, r->word) == 0 || (c == -1 && line.len == 0)) {
+                sbuf_free(&line);
+                break;
+            }
+            sbuf_adds(&body, text);
+            sbuf_addc(&body, '\n');
+            sbuf_free(&line);
+            if (c == -1) {
+                break;
+            }
+        }
+        r->body = sbuf_finish(&body);
+    }
+    lx->npending = 0;
+}
+
+
+/**
+ * lexer_next - Read the next token.
+ * @lx: The lexer.
+ * @tok: Receives the token; a word's text is malloc'd.
+ *
+ * Comments and line continuations are removed here. Words keep their
+ * quotes, which are removed during expansion. Pending here-document bodies
+ * are read as soon as the newline that ends their command is seen.
+ *
+ * Return: The token type.
+ */
+int lexer_next(lexer *lx, token *tok)
+{
+    string_buffer sb;
+    int c, digits = 1;
+    size_t i;
+
+    tok->text = NULL;
+    tok->quoted = 0;
+    tok->io_number = -1;
+    for (;;) {
+        lx_skip_continuations(lx);
+        c = lx_peek(lx, 0);
+        if (c != ' ' && c != '\t') {
+            break;
+        }
+        lx_getc(lx);
+    }
+    /* The recursion guard lasts until a token starts outside the alias */
+    if (lx->alias_text == NULL && lx->alias_name != NULL) {
+        free(lx->alias_name);
+        lx->alias_name = NULL;
+    }
+    if (c == '#') {
+        while ((c = lx_peek(lx, 0)) != -1 && c != '\n') {
+            lx_getc(lx);
+        }
+    }
+    tok->lineno = lx->src->lineno;
+    if (c == -1) {
+        lx_read_heredocs(lx);
+        tok->type = TOK_EOF;
+        return (TOK_EOF);
+    }
+    if (lx_operator(lx, tok)) {
+        if (tok->type == TOK_NEWLINE && lx->npending > 0) {
+            lx_read_heredocs(lx);
+        }
+        return (tok->type);
+    }
+
+    sbuf_init(&sb);
+    for (;;) {
+        lx_skip_continuations(lx);
+        c = lx_peek(lx, 0);
+        if (c == -1 || strchr(" \t;&|()<>\n", c) != NULL) {
+            break;
+        }
+        if (c == '\'' || c == '"' || c == '`') {
+            tok->quoted = 1;
+            if (lx_scan_quoted(lx, &sb) != 0) {
+                sbuf_free(&sb);
+                tok->type = TOK_ERROR;
+                return (TOK_ERROR);
+            }
+        } else if (c == '\\') {
+            tok->quoted = 1;
+            sbuf_addc(&sb, lx_getc(lx));
+            if ((c = lx_getc(lx)) != -1) {
+                sbuf_addc(&sb, c);
+            }
+        } else if (c == '$') {
+            if (lx_scan_dollar(lx, &sb) != 0) {
+                sbuf_free(&sb);
+                tok->type = TOK_ERROR;
+                return (TOK_ERROR);
+            }
+        } else {
+            sbuf_addc(&sb, lx_getc(lx));
+        }
+    }
+    tok->text = sbuf_finish(&sb);
+
+    /* An unquoted number directly before < or > names a descriptor */
+    for (i = 0; tok->text[i] != '\0'; i++) {
+        digits = digits && isdigit((unsigned char)tok->text[i]);
+    }
+    if (digits && i > 0 && i < 4 && (c == '<' || c == '>')) {
+        tok->io_number = atoi(tok->text);
+        token_free(tok);
+        lx_operator(lx, tok);
+        return (tok->type);
+    }
+    tok->type = TOK_WORD;
+    return (TOK_WORD);
+}
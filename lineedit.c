@@ -0,0 +1,954 @@
+#include "main.h"
+#include <termios.h>
+#include <sys/select.h>
+#include <sys/ioctl.h>
+
+/* Bytes read from the terminal at once; a paste is handled in one pass */
+#define LE_INPUT 256
+/* How long a lone ESC waits for the rest of an escape sequence (ms) */
+#define LE_ESC_WAIT 50
+/* Completion lists longer than this are shown only after asking */
+#define LE_LIST_ASK 100
+/* hist_pos before Up is first pressed; the history is not loaded until then */
+#define LE_TYPED ((size_t)-1)
+
+#define KEY_CTRL(c) ((c) & 0x1f)
+
+/* Keys decoded from escape sequences */
+enum le_key
+{
+LE_KEY_LEFT = 256, LE_KEY_RIGHT, LE_KEY_UP, LE_KEY_DOWN, LE_KEY_HOME,
+LE_KEY_END, LE_KEY_DELETE, LE_KEY_WORD_LEFT, LE_KEY_WORD_RIGHT,
+LE_KEY_KILL_WORD, LE_KEY_RUBOUT_WORD
+};
+
+/**
+ * struct line_editor - State of the line being edited.
+ * @line: The text.
+ * @pos: Byte offset of the editing point.
+ * @cursor: Byte offset the terminal cursor is actually at.
+ * @cell: Cell the terminal cursor is at, counted from the start of the
+ * prompt's row; the row is @cell / @width.
+ * @width: Columns of the terminal.
+ * @prompt_width: Cells taken by the last line of the prompt.
+ * @out: Terminal output not yet written; flushed once per batch of keys.
+ * @prompt: The prompt, for full redraws.
+ * @prompt_len: Length of @prompt.
+ * @hist_pos: History entry shown by Up/Down, or LE_TYPED for the line
+ * being typed before the history is first used.
+ * @draft: The line being typed before moving through the history.
+ * @last_key: The key handled before the current one.
+ * @overlay: Non-zero while a search or question is shown instead of the
+ * prompt, which must then not be repainted.
+ */
+typedef struct line_editor
+{
+string_buffer line;
+size_t pos;
+size_t cursor;
+size_t cell;
+size_t width;
+size_t prompt_width;
+string_buffer out;
+const char *prompt;
+size_t prompt_len;
+size_t hist_pos;
+char *draft;
+int last_key;
+int overlay;
+} line_editor;
+
+/* Text removed by the last kill command, inserted again by Ctrl-Y */
+static char *kill_buffer;
+
+/* Typed bytes not decoded yet; kept across lines so a paste is not lost */
+static unsigned char input[LE_INPUT];
+static size_t input_len, input_pos;
+
+
+/**
+ * le_columns - Count the terminal cells taken by part of the line.
+ * @text: The text.
+ * @len: Its length in bytes.
+ *
+ * UTF-8 continuation bytes take no cell of their own.
+ *
+ * Return: The number of cells.
+ */
+static size_t le_columns(const char *text, size_t len)
+{
+    size_t cells = 0;
+
+    while (len-- > 0) {
+        if ((*text++ & 0xc0) != 0x80) {
+            cells++;
+        }
+    }
+    return (cells);
+}
+
+
+/**
+ * le_prompt_width - Count the cells the last line of a prompt takes.
+ * @prompt: The prompt.
+ * @len: Its length.
+ *
+ * Escape sequences (colours, window titles) take no cell.
+ *
+ * Return: The number of cells.
+ */
+static size_t le_prompt_width(const char *prompt, size_t len)
+{
+    const char *end = prompt + len;
+    size_t cells = 0;
+
+    while (prompt < end) {
+        if (*prompt == '\n' || *prompt == '\r') {
+            cells = 0;
+            prompt++;
+        } else if (*prompt == '\033' && prompt + 1 < end && prompt[1] == '[') {
+            /* CSI: parameters up to a final byte in @..~ */
+            for (prompt += 2; prompt < end && (*prompt < '@' || *prompt > '~'); prompt++) {
+            }
+            prompt++;
+        } else if (*prompt == '\033' && prompt + 1 < end && prompt[1] == ']') {
+            /* OSC: up to BEL or ESC \ */
+            for (prompt += 2; prompt < end && *prompt != '\a' && *prompt != '\033'; prompt++) {
+            }
+            prompt += (prompt + 1 < end && *prompt == '\033') ? 2 : 1;
+        } else if (*prompt == '\033') {
+            prompt += 2;
+        } else {
+            cells += ((*prompt++ & 0xc0) != 0x80);
+        }
+    }
+    return (cells);
+}
+
+
+/**
+ * le_size - Ask the terminal for its width.
+ * @ed: The editor.
+ */
+static void le_size(line_editor *ed)
+{
+    struct winsize ws;
+
+    ed->width = 80;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0) {
+        ed->width = ws.ws_col;
+    }
+}
+
+
+/**
+ * le_flush - Write the pending terminal output.
+ * @ed: The editor.
+ */
+static void le_flush(line_editor *ed)
+{
+    if (ed->out.len > 0) {
+        write_all(STDOUT_FILENO, ed->out.data, ed->out.len);
+        ed->out.len = 0;
+    }
+}
+
+
+/**
+ * le_step - Move the terminal cursor by a number of rows or columns.
+ * @ed: The editor.
+ * @count: How far.
+ * @dir: The CSI final byte: 'A' up, 'B' down, 'C' right, 'D' left.
+ */
+static void le_step(line_editor *ed, size_t count, char dir)
+{
+    char seq[32];
+
+    if (count == 1 && dir == 'D') {
+        sbuf_addc(&ed->out, '\b');
+    } else if (count > 0) {
+        sprintf(seq, "\033[%lu%c", (unsigned long)count, dir);
+        sbuf_adds(&ed->out, seq);
+    }
+}
+
+
+/**
+ * le_goto - Move the terminal cursor to a cell of the edited rows.
+ * @ed: The editor.
+ * @cell: The cell, counted like @ed->cell.
+ */
+static void le_goto(line_editor *ed, size_t cell)
+{
+    size_t row = ed->cell / ed->width, col = ed->cell % ed->width;
+    size_t to_row = cell / ed->width, to_col = cell % ed->width;
+
+    if (to_row < row) {
+        le_step(ed, row - to_row, 'A');
+    } else {
+        le_step(ed, to_row - row, 'B');
+    }
+    if (to_col < col) {
+        le_step(ed, col - to_col, 'D');
+    } else {
+        le_step(ed, to_col - col, 'C');
+    }
+    ed->cell = cell;
+}
+
+
+/**
+ * le_wrapped - Account for text just written up to the cursor.
+ * @ed: The editor.
+ * @cells: Cells the text took.
+ *
+ * A terminal keeps the cursor in the last column after filling a row, so
+ * the next row is entered explicitly for the cursor to be where @ed->cell
+ * says.
+ */
+static void le_wrapped(line_editor *ed, size_t cells)
+{
+    ed->cell += cells;
+    if (ed->cell > 0 && ed->cell % ed->width == 0) {
+        sbuf_adds(&ed->out, " \r");
+    }
+}
+
+
+/**
+ * le_move - Move the terminal cursor to a byte offset of the line.
+ * @ed: The editor.
+ * @to: The offset.
+ */
+static void le_move(line_editor *ed, size_t to)
+{
+    if (to < ed->cursor) {
+        le_goto(ed, ed->cell - le_columns(ed->line.data + to, ed->cursor - to));
+    } else if (to > ed->cursor) {
+        le_goto(ed, ed->cell + le_columns(ed->line.data + ed->cursor, to - ed->cursor));
+    }
+    ed->cursor = to;
+}
+
+
+/**
+ * le_refresh - Redraw the line from the first changed byte onwards.
+ * @ed: The editor.
+ * @from: First byte that changed.
+ * @shrunk: Non-zero if the line got shorter, so stale cells must go.
+ *
+ * Cells before @from are left alone: only what changed is sent. A line
+ * longer than the terminal is wide continues on the rows below.
+ */
+static void le_refresh(line_editor *ed, size_t from, int shrunk)
+{
+    le_move(ed, from);
+    sbuf_addn(&ed->out, ed->line.data + from, ed->line.len - from);
+    le_wrapped(ed, le_columns(ed->line.data + from, ed->line.len - from));
+    ed->cursor = ed->line.len;
+    if (shrunk) {
+        sbuf_adds(&ed->out, "\033[J");
+    }
+    le_move(ed, ed->pos);
+}
+
+
+/**
+ * le_insert - Insert text at the editing point.
+ * @ed: The editor.
+ * @text: The text.
+ * @len: Its length.
+ */
+static void le_insert(line_editor *ed, const char *text, size_t len)
+{
+    char *at;
+
+    if (len == 0 || sbuf_reserve(&ed->line, len) != 0) {
+        return;
+    }
+    at = ed->line.data + ed->pos;
+    memmove(at + len, at, ed->line.len - ed->pos + 1);
+    memcpy(at, text, len);
+    ed->line.len += len;
+    ed->pos += len;
+    le_refresh(ed, ed->pos - len, 0);
+}
+
+
+/**
+ * le_delete - Remove part of the line.
+ * @ed: The editor.
+ * @from: First byte to remove.
+ * @to: End of the removed range.
+ * @kill: Non-zero to keep the text for Ctrl-Y.
+ */
+static void le_delete(line_editor *ed, size_t from, size_t to, int kill)
+{
+    char *at = ed->line.data + from;
+
+    if (from >= to) {
+        return;
+    }
+    if (kill) {
+        free(kill_buffer);
+        kill_buffer = strndup(at, to - from);
+    }
+    memmove(at, ed->line.data + to, ed->line.len - to + 1);
+    ed->line.len -= to - from;
+    ed->pos = from;
+    le_refresh(ed, from, 1);
+}
+
+
+/**
+ * le_prev_char - Find the start of the character before an offset.
+ * @ed: The editor.
+ * @pos: The offset.
+ *
+ * Return: The start of the previous character.
+ */
+static size_t le_prev_char(line_editor *ed, size_t pos)
+{
+    while (pos > 0 && (ed->line.data[--pos] & 0xc0) == 0x80) {
+    }
+    return (pos);
+}
+
+
+/**
+ * le_next_char - Find the end of the character at an offset.
+ * @ed: The editor.
+ * @pos: The offset.
+ *
+ * Return: The start of the next character.
+ */
+static size_t le_next_char(line_editor *ed, size_t pos)
+{
+    if (pos < ed->line.len) {
+        pos++;
+    }
+    while (pos < ed->line.len && (ed->line.data[pos] & 0xc0) == 0x80) {
+        pos++;
+    }
+    return (pos);
+}
+
+
+/**
+ * le_word_left - Find the start of the word before the editing point.
+ * @ed: The editor.
+ *
+ * Return: Its offset.
+ */
+static size_t le_word_left(line_editor *ed)
+{
+    size_t pos = ed->pos;
+
+    while (pos > 0 && isspace((unsigned char)ed->line.data[pos - 1])) {
+        pos--;
+    }
+    while (pos > 0 && !isspace((unsigned char)ed->line.data[pos - 1])) {
+        pos--;
+    }
+    return (pos);
+}
+
+
+/**
+ * le_word_right - Find the end of the word after the editing point.
+ * @ed: The editor.
+ *
+ * Return: Its offset.
+ */
+static size_t le_word_right(line_editor *ed)
+{
+    size_t pos = ed->pos;
+
+    while (pos < ed->line.len && isspace((unsigned char)ed->line.data[pos])) {
+        pos++;
+    }
+    while (pos < ed->line.len && !isspace((unsigned char)ed->line.data[pos])) {
+        pos++;
+    }
+    return (pos);
+}
+
+
+/**
+ * le_replace - Replace the whole line, redrawing only what differs.
+ * @ed: The editor.
+ * @text: The new text.
+ * @len: Its length.
+ */
+static void le_replace(line_editor *ed, const char *text, size_t len)
+{
+    size_t same = 0, old_len = ed->line.len;
+
+    while (same < len && same < old_len && ed->line.data[same] == text[same]) {
+        same++;
+    }
+    ed->line.len = same;
+    if (sbuf_addn(&ed->line, text + same, len - same) != 0) {
+        return;
+    }
+    ed->pos = ed->line.len;
+    le_refresh(ed, same, old_len > ed->line.len);
+}
+
+
+/**
+ * le_home - Go back to the start of the prompt's row and clear the rows
+ * taken by the line.
+ * @ed: The editor.
+ */
+static void le_home(line_editor *ed)
+{
+    le_step(ed, ed->cell / ed->width, 'A');
+    sbuf_adds(&ed->out, "\r\033[J");
+    ed->cell = 0;
+}
+
+
+/**
+ * le_redraw - Draw the prompt and the whole line again, after the screen
+ * was cleared or used for something else.
+ * @ed: The editor.
+ */
+static void le_redraw(line_editor *ed)
+{
+    le_home(ed);
+    le_size(ed);
+    sbuf_addn(&ed->out, ed->prompt, ed->prompt_len);
+    ed->prompt_width = le_prompt_width(ed->prompt, ed->prompt_len);
+    le_wrapped(ed, ed->prompt_width);
+    ed->cursor = 0;
+    le_refresh(ed, 0, 0);
+}
+
+
+/**
+ * le_history - Show an older or newer history entry (Up/Down).
+ * @ed: The editor.
+ * @step: -1 for older, 1 for newer.
+ *
+ * The line typed before moving into the history comes back after the
+ * newest entry.
+ */
+static void le_history(line_editor *ed, int step)
+{
+    size_t count = history_count(), len;
+    const char *text;
+
+    if (ed->hist_pos == LE_TYPED) {
+        ed->hist_pos = count;
+    }
+    if ((step < 0 && ed->hist_pos == 0) || (step > 0 && ed->hist_pos >= count)) {
+        return;
+    }
+    if (ed->hist_pos == count) {
+        free(ed->draft);
+        ed->draft = strndup(ed->line.data, ed->line.len);
+    }
+    ed->hist_pos += step;
+    if (ed->hist_pos == count) {
+        text = ed->draft != NULL ? ed->draft : "";
+        len = strlen(text);
+    } else {
+        text = history_get(ed->hist_pos, &len);
+    }
+    le_replace(ed, text, len);
+}
+
+
+/**
+ * le_repaint - Show the prompt again after its segments changed.
+ * @ed: The editor.
+ *
+ * Only the main prompt has segments; a continuation prompt is left alone.
+ */
+static void le_repaint(line_editor *ed)
+{
+    const char *prompt;
+    size_t len;
+
+    prompt = prompt_update(&len);
+    if (prompt != NULL && prompt == ed->prompt) {
+        ed->prompt_len = len;
+        le_redraw(ed);
+    }
+}
+
+
+/**
+ * le_getc - Read the next byte typed.
+ * @ed: The editor.
+ * @wait_ms: How long to wait when nothing is buffered, or -1 for ever.
+ *
+ * Pending output is flushed before blocking, so each batch of keys costs
+ * a single write.
+ *
+ * Return: The byte, or -1 at end of input or timeout.
+ */
+static int le_getc(line_editor *ed, int wait_ms)
+{
+    struct timeval tv;
+    fd_set fds;
+    ssize_t count;
+    int wake, ready;
+
+    while (input_pos == input_len) {
+        le_flush(ed);
+        /* While idle, also wait for fresh prompt segments to show */
+        wake = (wait_ms < 0 && !ed->overlay) ? segment_fd() : -1;
+        FD_ZERO(&fds);
+        FD_SET(STDIN_FILENO, &fds);
+        if (wake >= 0) {
+            FD_SET(wake, &fds);
+        }
+        tv.tv_sec = 0;
+        tv.tv_usec = wait_ms * 1000;
+        ready = select((wake > STDIN_FILENO ? wake : STDIN_FILENO) + 1, &fds, NULL, NULL,
+                       wait_ms >= 0 ? &tv : NULL);
+        if (ready <= 0 && wait_ms >= 0) {
+            return (-1);
+        }
+        if (ready > 0 && wake >= 0 && FD_ISSET(wake, &fds)) {
+            le_repaint(ed);
+            continue;
+        }
+        do {
+            count = read(STDIN_FILENO, input, sizeof(input));
+        } while (count < 0 && errno == EINTR);
+        if (count <= 0) {
+            return (-1);
+        }
+        input_len = count;
+        input_pos = 0;
+    }
+    return (input[input_pos++]);
+}
+
+
+/**
+ * le_escape - Decode the rest of an escape sequence.
+ * @ed: The editor.
+ *
+ * Handles the CSI/SS3 keys of xterm-like terminals and Alt (ESC-prefixed)
+ * word commands.
+ *
+ * Return: One of enum le_key, or 0 for anything unknown.
+ */
+static int le_escape(line_editor *ed)
+{
+    int c = le_getc(ed, LE_ESC_WAIT), param = 0, modifier = 0;
+
+    switch (c) {
+    case 'b':
+        return (LE_KEY_WORD_LEFT);
+    case 'f':
+        return (LE_KEY_WORD_RIGHT);
+    case 'd':
+        return (LE_KEY_KILL_WORD);
+    case 127:
+    case KEY_CTRL('H'):
+        return (LE_KEY_RUBOUT_WORD);
+    case '[':
+    case 'O':
+        break;
+    default:
+        return (0);
+    }
+    while ((c = le_getc(ed, LE_ESC_WAIT)) != -1 && (isdigit(c) || c == ';')) {
+        if (c == ';') {
+            modifier = param;
+            param = 0;
+            continue;
+        }
+        param = param * 10 + (c - '0');
+    }
+    /* ESC[1;5C: the parameter after ';' is the modifier (5 is Ctrl) */
+    if (modifier != 0) {
+        modifier = param;
+    }
+    switch (c) {
+    case 'A':
+        return (LE_KEY_UP);
+    case 'B':
+        return (LE_KEY_DOWN);
+    case 'C':
+        return (modifier >= 3 ? LE_KEY_WORD_RIGHT : LE_KEY_RIGHT);
+    case 'D':
+        return (modifier >= 3 ? LE_KEY_WORD_LEFT : LE_KEY_LEFT);
+    case 'H':
+        return (LE_KEY_HOME);
+    case 'F':
+        return (LE_KEY_END);
+    case '~':
+        if (param == 1 || param == 7) {
+            return (LE_KEY_HOME);
+        }
+        if (param == 4 || param == 8) {
+            return (LE_KEY_END);
+        }
+        return (param == 3 ? LE_KEY_DELETE : 0);
+    }
+    return (0);
+}
+
+
+/**
+ * le_search - Incremental reverse search through the history (Ctrl-R).
+ * @ed: The editor.
+ *
+ * Typing narrows the search, Ctrl-R moves to older matches, Backspace
+ * widens it again and Ctrl-G gives up. Any other key takes the match into
+ * the line and is then handled as usual.
+ *
+ * Return: The key that ended the search, or 0 if it needs no handling.
+ */
+static int le_search(line_editor *ed)
+{
+    string_buffer query;
+    const char *text = NULL, *label;
+    size_t count = history_count(), len = 0;
+    long found = -1, next;
+    int c;
+
+    sbuf_init(&query);
+    sbuf_reserve(&query, 0);
+    ed->overlay = 1;
+    for (;;) {
+        label = (found < 0 && query.len > 0) ? "(failed reverse-i-search)`" : "(reverse-i-search)`";
+        le_home(ed);
+        sbuf_adds(&ed->out, label);
+        sbuf_addn(&ed->out, query.data, query.len);
+        sbuf_adds(&ed->out, "': ");
+        if (text != NULL) {
+            sbuf_addn(&ed->out, text, len);
+        }
+        le_wrapped(ed, strlen(label) + le_columns(query.data, query.len) + 3
+                   + (text != NULL ? le_columns(text, len) : 0));
+        c = le_getc(ed, -1);
+        if (c == 27) {
+            c = le_escape(ed);
+        }
+        if (c == KEY_CTRL('R')) {
+            next = (query.len > 0) ? history_search(query.data, query.len,
+                                                    found < 0 ? count : (size_t)found) : -1;
+        } else if (c == 127 || c == KEY_CTRL('H')) {
+            if (query.len > 0) {
+                query.data[--query.len] = '\0';
+            }
+            next = (query.len > 0) ? history_search(query.data, query.len, count) : -1;
+            found = next;
+        } else if (c >= ' ' && c < 127) {
+            sbuf_addc(&query, (char)c);
+            /* The current match may still contain the longer query */
+            next = history_search(query.data, query.len, found < 0 ? count : (size_t)found + 1);
+            found = next;
+        } else {
+            break;
+        }
+        if (next >= 0) {
+            found = next;
+            text = history_get(found, &len);
+        } else if (found < 0) {
+            text = NULL;
+        }
+    }
+    sbuf_free(&query);
+    ed->overlay = 0;
+    if (c == KEY_CTRL('G') || c == -1) {
+        le_redraw(ed);
+        return (0);
+    }
+    if (found >= 0) {
+        ed->line.len = 0;
+        sbuf_addn(&ed->line, text, len);
+        ed->pos = len;
+        ed->hist_pos = found;
+    }
+    le_redraw(ed);
+    return (c);
+}
+
+
+/**
+ * le_list - Show completions below the line, in columns, then redraw it.
+ * @ed: The editor.
+ * @comp: The completions.
+ */
+static void le_list(line_editor *ed, const completion *comp)
+{
+    size_t width = 0, len, cols, rows, row, i;
+    char ask[64];
+    int c;
+
+    le_move(ed, ed->line.len);
+    if (comp->count > LE_LIST_ASK) {
+        sprintf(ask, "\nDisplay all %lu possibilities? (y or n)", (unsigned long)comp->count);
+        sbuf_adds(&ed->out, ask);
+        ed->overlay = 1;
+        c = le_getc(ed, -1);
+        ed->overlay = 0;
+        if (c != 'y' && c != 'Y') {
+            sbuf_addc(&ed->out, '\n');
+            ed->cell = 0;
+            le_redraw(ed);
+            return;
+        }
+    }
+    for (i = 0; i < comp->count; i++) {
+        len = le_columns(comp->names[i], strlen(comp->names[i])) + 1;
+        width = (len > width) ? len : width;
+    }
+    width += 1;
+    le_size(ed);
+    cols = (ed->width / width > 0) ? ed->width / width : 1;
+    rows = (comp->count + cols - 1) / cols;
+    sbuf_addc(&ed->out, '\n');
+    for (row = 0; row < rows; row++) {
+        for (i = row; i < comp->count; i += rows) {
+            len = le_columns(comp->names[i], strlen(comp->names[i]));
+            sbuf_adds(&ed->out, comp->names[i]);
+            if (complete_is_dir(comp, i)) {
+                sbuf_addc(&ed->out, '/');
+                len++;
+            }
+            while (i + rows < comp->count && len++ < width) {
+                sbuf_addc(&ed->out, ' ');
+            }
+        }
+        sbuf_addc(&ed->out, '\n');
+    }
+    ed->cell = 0;
+    le_redraw(ed);
+}
+
+
+/**
+ * le_complete - Complete the word before the cursor (Tab).
+ * @ed: The editor.
+ *
+ * The text shared by every candidate is inserted; a single candidate is
+ * finished with a space, or a slash for a directory. When nothing can be
+ * added, a second Tab in a row lists the candidates.
+ */
+static void le_complete(line_editor *ed)
+{
+    completion comp;
+    string_buffer add;
+    const char *first, *last;
+    size_t common;
+
+    if (complete_find(ed->line.data, ed->pos, &comp) != 0 || comp.count == 0) {
+        sbuf_addc(&ed->out, '\a');
+        return;
+    }
+    first = comp.names[0];
+    last = comp.names[comp.count - 1];
+    for (common = comp.typed; first[common] != '\0' && first[common] == last[common]; common++) {
+    }
+    sbuf_init(&add);
+    complete_escape(&add, first + comp.typed, common - comp.typed, comp.quote);
+    if (comp.count == 1) {
+        if (complete_is_dir(&comp, 0)) {
+            sbuf_addc(&add, '/');
+        } else {
+            if (comp.quote != 0) {
+                sbuf_addc(&add, comp.quote);
+            }
+            sbuf_addc(&add, ' ');
+        }
+    }
+    if (add.len > 0) {
+        le_insert(ed, add.data, add.len);
+    } else if (ed->last_key == '\t') {
+        le_list(ed, &comp);
+    } else {
+        sbuf_addc(&ed->out, '\a');
+    }
+    sbuf_free(&add);
+}
+
+
+/**
+ * le_key - Apply one key to the line.
+ * @ed: The editor.
+ * @c: The key (a byte or one of enum le_key).
+ *
+ * Return: 0 to keep editing, 1 when the line is complete, -1 for end of
+ * input (Ctrl-D on an empty line).
+ */
+static int le_key(line_editor *ed, int c)
+{
+    char byte;
+
+    switch (c) {
+    case '\r':
+    case '\n':
+        return (1);
+    case KEY_CTRL('D'):
+        if (ed->line.len == 0) {
+            return (-1);
+        }
+        le_delete(ed, ed->pos, le_next_char(ed, ed->pos), 0);
+        break;
+    case LE_KEY_DELETE:
+        le_delete(ed, ed->pos, le_next_char(ed, ed->pos), 0);
+        break;
+    case KEY_CTRL('C'):
+        /* Abandon the line, as the terminal's own interrupt would */
+        ed->line.len = 0;
+        ed->line.data[0] = '\0';
+        ed->pos = 0;
+        ed->cursor = 0;
+        sbuf_adds(&ed->out, "^C");
+        return (1);
+    case 127:
+    case KEY_CTRL('H'):
+        le_delete(ed, le_prev_char(ed, ed->pos), ed->pos, 0);
+        break;
+    case KEY_CTRL('A'):
+    case LE_KEY_HOME:
+        ed->pos = 0;
+        le_move(ed, ed->pos);
+        break;
+    case KEY_CTRL('E'):
+    case LE_KEY_END:
+        ed->pos = ed->line.len;
+        le_move(ed, ed->pos);
+        break;
+    case KEY_CTRL('B'):
+    case LE_KEY_LEFT:
+        ed->pos = le_prev_char(ed, ed->pos);
+        le_move(ed, ed->pos);
+        break;
+    case KEY_CTRL('F'):
+    case LE_KEY_RIGHT:
+        ed->pos = le_next_char(ed, ed->pos);
+        le_move(ed, ed->pos);
+        break;
+    case LE_KEY_WORD_LEFT:
+        ed->pos = le_word_left(ed);
+        le_move(ed, ed->pos);
+        break;
+    case LE_KEY_WORD_RIGHT:
+        ed->pos = le_word_right(ed);
+        le_move(ed, ed->pos);
+        break;
+    case KEY_CTRL('K'):
+        le_delete(ed, ed->pos, ed->line.len, 1);
+        break;
+    case KEY_CTRL('U'):
+        le_delete(ed, 0, ed->pos, 1);
+        break;
+    case KEY_CTRL('W'):
+    case LE_KEY_RUBOUT_WORD:
+        le_delete(ed, le_word_left(ed), ed->pos, 1);
+        break;
+    case LE_KEY_KILL_WORD:
+        le_delete(ed, ed->pos, le_word_right(ed), 1);
+        break;
+    case KEY_CTRL('Y'):
+        if (kill_buffer != NULL) {
+            le_insert(ed, kill_buffer, strlen(kill_buffer));
+        }
+        break;
+    case KEY_CTRL('P'):
+    case LE_KEY_UP:
+        le_history(ed, -1);
+        break;
+    case KEY_CTRL('N'):
+    case LE_KEY_DOWN:
+        le_history(ed, 1);
+        break;
+    case KEY_CTRL('R'):
+        c = le_search(ed);
+        return (c != 0 ? le_key(ed, c) : 0);
+    case '\t':
+        le_complete(ed);
+        break;
+    case KEY_CTRL('L'):
+        /* Clear the screen and draw the prompt and line again */
+        sbuf_adds(&ed->out, "\033[H\033[2J");
+        ed->cell = 0;
+        le_redraw(ed);
+        break;
+    default:
+        if (c >= ' ' && c < 256 && c != 127) {
+            byte = (char)c;
+            le_insert(ed, &byte, 1);
+        }
+        break;
+    }
+    return (0);
+}
+
+
+/**
+ * line_edit - Read a line from the terminal with editing.
+ * @prompt: The prompt to show.
+ * @prompt_len: Its length.
+ *
+ * The terminal is put in raw mode while the line is edited and restored
+ * before returning, so commands run with the usual settings. Each batch
+ * of keys results in one write carrying only the cells that changed.
+ * Without a usable terminal this falls back to a plain read.
+ *
+ * Return: The line without its newline (malloc'd), or NULL at end of input.
+ */
+char *line_edit(const char *prompt, size_t prompt_len)
+{
+    struct termios saved, raw;
+    line_editor ed;
+    int c, result = 0;
+
+    if (tcgetattr(STDIN_FILENO, &saved) != 0) {
+        write_all(STDOUT_FILENO, prompt, prompt_len);
+        return (read_line_raw());
+    }
+    raw = saved;
+    raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+    raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+    raw.c_cflag |= CS8;
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    if (tcsetattr(STDIN_FILENO, TCSADRAIN, &raw) != 0) {
+        write_all(STDOUT_FILENO, prompt, prompt_len);
+        return (read_line_raw());
+    }
+
+    memset(&ed, 0, sizeof(ed));
+    sbuf_init(&ed.line);
+    sbuf_init(&ed.out);
+    sbuf_reserve(&ed.line, 0);
+    sbuf_addn(&ed.out, prompt, prompt_len);
+    ed.prompt = prompt;
+    ed.prompt_len = prompt_len;
+    le_size(&ed);
+    ed.prompt_width = le_prompt_width(prompt, prompt_len);
+    le_wrapped(&ed, ed.prompt_width);
+    ed.hist_pos = LE_TYPED;
+    while (result == 0) {
+        c = le_getc(&ed, -1);
+        if (c == 27) {
+            c = le_escape(&ed);
+        }
+        result = (c == -1) ? (ed.line.len > 0 ? 1 : -1) : le_key(&ed, c);
+        ed.last_key = c;
+    }
+    if (result == 1) {
+        le_move(&ed, ed.line.len);
+    }
+    sbuf_addc(&ed.out, '\n');
+    le_flush(&ed);
+    sbuf_free(&ed.out);
+    free(ed.draft);
+    tcsetattr(STDIN_FILENO, TCSADRAIN, &saved);
+    if (result == -1) {
+        sbuf_free(&ed.line);
+        return (NULL);
+    }
+    return (sbuf_finish(&ed.line));
+}
@@ -0,0 +1,112 @@
+#include "main.h"
+#include <sys/stat.h>
+
+/* Read size for input streamed in blocks (pipes, FIFOs, devices) */
+#define LOADER_CHUNK 65536
+/* Regular files up to this size are read whole when opened */
+#define LOADER_WHOLE (16 * 1024 * 1024)
+
+
+/**
+ * source_read_block - Append the next block of a source's file to it.
+ * @src: The source.
+ *
+ * Text the lexer has consumed is dropped first, so the buffer only ever
+ * holds the unread tail plus one chunk, whatever the script's size.
+ *
+ * Return: 1 if text was added, 0 at end of input.
+ */
+int source_read_block(input_source *src)
+{
+    ssize_t count;
+    char *grown;
+
+    if (src->pos > 0) {
+        memmove(src->buf, src->buf + src->pos, src->len - src->pos);
+        src->len -= src->pos;
+        src->pos = 0;
+    }
+    if (src->len + LOADER_CHUNK > src->cap) {
+        grown = realloc(src->buf, src->len + LOADER_CHUNK);
+        if (grown == NULL) {
+            perror("realloc");
+            src->eof = 1;
+            return (0);
+        }
+        src->buf = grown;
+        src->cap = src->len + LOADER_CHUNK;
+    }
+    /* Whoever feeds the input may be waiting for the output so far */
+    out_flush();
+    read_sync();
+    do {
+        count = read(src->fd, src->buf + src->len, src->cap - src->len);
+    } while (count < 0 && errno == EINTR);
+    if (count <= 0) {
+        src->eof = 1;
+        return (0);
+    }
+    src->len += count;
+    return (1);
+}
+
+
+/**
+ * source_open_file - Prepare a script file for the lexer.
+ * @src: The source to initialise.
+ * @path: Path of the script.
+ *
+ * Regular files are read whole, in one read, and lexed in place without
+ * splitting into lines. They are not mapped: a script truncated or
+ * rewritten while it runs would then kill the shell with SIGBUS. Larger
+ * files and anything else are read in large chunks on demand.
+ *
+ * Return: 0 on success, -1 if the file cannot be opened (errno is set).
+ */
+int source_open_file(input_source *src, const char *path)
+{
+    struct stat st;
+    ssize_t count;
+
+    src->buf = NULL;
+    src->len = 0;
+    src->cap = 0;
+    src->pos = 0;
+    src->whole = 0;
+    src->lineno = 1;
+    src->interactive = 0;
+    src->continuation = 0;
+    src->eof = 0;
+    src->refill = source_read_block;
+    src->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (src->fd < 0) {
+        return (-1);
+    }
+    if (fstat(src->fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0
+        || st.st_size > LOADER_WHOLE) {
+        return (0);
+    }
+
+    src->buf = malloc(st.st_size);
+    if (src->buf == NULL) {
+        return (0);
+    }
+    src->cap = st.st_size;
+    /* The file may shrink or grow meanwhile: what was read is the script */
+    while (src->len < src->cap) {
+        count = read(src->fd, src->buf + src->len, src->cap - src->len);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        src->len += count;
+    }
+    close(src->fd);
+    src->fd = -1;
+    src->whole = 1;
+    src->eof = 1;
+    src->refill = NULL;
+    return (0);
+}
@@ -4,6 +4,10 @@
 /* Define the array here */
 char **definedalias = NULL;
 
+/* Name the shell was started as and the line being run, for messages */
+char *shell_name = NULL;
+int shell_lineno = 1;
+
 /**
  * sigint_handler - Handle the SIGINT signal (Ctrl+C).
  * @signum: The signal number.
@@ -29,66 +33,62 @@ void sigint_handler(int signum) {
  * @argc: The number of command-line arguments.
  * @argv: An array of command-line arguments.
  *        argv[0] is the name of the program.
- * Return: Always 0.
+ * Return: The exit status of the last command.
  */
 int main(int argc, char *argv[])
 {
-  char *command;
-  char *delim = "&&||";
-  char *delimone = ";";
-  char *delimtwo = "$$ $?";
-  char *cmd = NULL;
-
-
-   while (1)
-   {
-       if (argc == 2) {
-           execute_commands_from_file(argv[1]);
-	   break;
-       }
-        /* Display user name */
-        if (isInteractiveMode()) {
-            displayHostName();
-	    }
+  input_source src;
+  int status;
 
-        /* Get user input */
-        cmd = read_command();
+  shell_name = argv[0];
+  if (argc >= 3 && strcmp(argv[1], "--compile") == 0) {
+      return (script_compile(argv + 2));
+  }
+  if (argc >= 3 && strcmp(argv[1], "--cache-bench") == 0) {
+      return (script_cache_bench(argv[2], argc >= 4 ? atoi(argv[3]) : 20));
+  }
+  if (argc >= 2 && strcmp(argv[1], "--startup-bench") == 0) {
+      return (startup_bench(argc >= 3 ? atoi(argv[2]) : 200));
+  }
+  if (argc >= 2 && strcmp(argv[1], "--dispatch-bench") == 0) {
+      return (dispatch_bench(argc >= 3 ? atol(argv[2]) : 1000000));
+  }
+  if (argc >= 2 && strcmp(argv[1], "-c") == 0) {
+      if (argc < 3) {
+          shell_error("-c requires an argument");
+          return (2);
+      }
+      /* hsh -c 'commands' [name [args...]]: name becomes $0 */
+      if (argc >= 4) {
+          shell_name = argv[3];
+          positional_params = argv + 4;
+          positional_count = argc - 4;
+      }
+      return (run_string(argv[2], EXEC_NOFORK));
+  }
+  if (argc >= 2 && strcmp(argv[1], "-j") == 0) {
+      if (argc != 4) {
+          shell_error("-j requires a job count and a file");
+          return (2);
+      }
+      return (batch_run(argv[2], argv[3]));
+  }
+  if (argc >= 2) {
+      /* hsh script [args...]: the arguments become $1, $2, ... */
+      positional_params = argv + 2;
+      positional_count = argc - 2;
+      return (execute_commands_from_file(argv[1]));
+  }
 
-	/* Exit the loop if Ctrl+D (EOF) is encountered */
-	if (cmd == NULL) {
-	   break;
-	}
-        command = cmdConstructor(cmd);
-        if (strstr(command, "alias") != NULL) {
-            free(command);
-            return (-1);
-        }
-
-        /* Check and execute built-in commands */
-	if (containschars(command, delimtwo) != 0) {
-	   execute_with_variable_replacement(command);
-	} else if (strsearch(command, "exit") != 0) {
-            execute_exit(command);
-        } else if (stringcmp(command, "env") == 0) {
-            execute_env();
-        } else if (stringtwocmp(command, "cd", 2) == 0) {
-            execute_cd(command);
-        } else if (containschars(command, delimone) == 1) {
-            execute_separator(command);
-        } else if (strstr(command, delim) != NULL) {
-            execute_logical_operator(command);
-        } else if (strsearch(command, "setenv") != 0 ||
-		strsearch(command, "unsetenv") != 0) {
-		process_env_command(command);
-	}
-	else {
-            /* Execute the command */
-            execute_command(command);
-        }
-        if (command != NULL) {
-           free(command);
-        }
-   }
+  /* Commands are parsed and run one complete command at a time */
+  source_init_stdin(&src);
+  status = run_source(&src, 0);
+  source_free(&src);
 
- return (EXIT_SUCCESS);
+  /* Ctrl+D (EOF) at the prompt */
+  if (src.interactive) {
+      errno = 0;
+      handle_errno("EOF");
+  }
+  return (status);
 }
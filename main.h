@@ -36,11 +36,269 @@ char *word;
 struct Node *next;
 } Node;
 
+/**
+ * struct string_buffer - A growable, NUL terminated string.
+ * @data: The characters (NULL until something is appended).
+ * @len: Number of characters stored, excluding the terminator.
+ * @cap: Allocated size of @data.
+ */
+typedef struct string_buffer
+{
+char *data;
+size_t len;
+size_t cap;
+} string_buffer;
+
+/**
+ * struct shell_var - A shell variable kept outside the environment.
+ * @name: The variable name.
+ * @value: The variable value.
+ * @flags: Attribute flags.
+ * @next: Next variable in the same hash bucket.
+ */
+typedef struct shell_var
+{
+char *name;
+char *value;
+int flags;
+struct shell_var *next;
+} shell_var;
+
+/**
+ * struct dir_listing - The entries of one directory, read once per command.
+ * @path: Directory path as written in the pattern ("" for the cwd).
+ * @names: Entry names (excluding "." and "..").
+ * @count: Number of entries.
+ * @next: Next cached directory.
+ */
+typedef struct dir_listing
+{
+char *path;
+char **names;
+size_t count;
+struct dir_listing *next;
+} dir_listing;
+
+/**
+ * struct glob_cache - Directory listings shared by the patterns of a command.
+ * @dirs: Cached listings.
+ */
+typedef struct glob_cache
+{
+dir_listing *dirs;
+} glob_cache;
+
+/**
+ * struct input_source - Text the lexer reads from.
+ * @buf: Buffered text.
+ * @len: Number of bytes in @buf.
+ * @pos: Read position of the lexer.
+ * @cap: Allocated size of @buf (0 if @buf is not owned by the source).
+ * @fd: File read by @refill, or -1.
+ * @whole: Non-zero when @buf holds the whole file, read when it was opened.
+ * @lineno: Line number at @pos.
+ * @interactive: Non-zero to display prompts before reading.
+ * @continuation: Non-zero once the current command needed more input.
+ * @eof: Set when @refill reported the end of input.
+ * @refill: Appends more input to @buf; returns 0 at end of input.
+ */
+typedef struct input_source
+{
+char *buf;
+size_t len;
+size_t pos;
+size_t cap;
+int fd;
+int whole;
+int lineno;
+int interactive;
+int continuation;
+int eof;
+int (*refill)(struct input_source *src);
+} input_source;
+
+/* Token types produced by the lexer */
+enum token_type
+{
+TOK_EOF, TOK_WORD, TOK_NEWLINE, TOK_SEMI, TOK_AMP, TOK_AND_IF, TOK_OR_IF,
+TOK_PIPE, TOK_LPAREN, TOK_RPAREN, TOK_DSEMI, TOK_REDIR, TOK_ERROR
+};
+
+/* Redirection operators */
+enum redir_kind
+{
+REDIR_IN, REDIR_OUT, REDIR_APPEND, REDIR_CLOBBER, REDIR_RDWR,
+REDIR_DUPIN, REDIR_DUPOUT, REDIR_HEREDOC, REDIR_HEREDOC_STRIP
+};
+
+/* Kinds of syntax tree nodes */
+enum node_kind
+{
+NODE_SIMPLE, NODE_PIPE, NODE_AND, NODE_OR, NODE_SEQ, NODE_BACKGROUND,
+NODE_NOT, NODE_SUBSHELL, NODE_GROUP, NODE_IF, NODE_WHILE, NODE_UNTIL,
+NODE_FOR, NODE_CASE, NODE_FUNCDEF
+};
+
+/**
+ * struct token - A lexical token.
+ * @type: One of enum token_type.
+ * @text: Raw text of a word, quotes included (NULL for operators).
+ * @quoted: Non-zero if the word contains quoting characters.
+ * @redir: Operator kind for TOK_REDIR.
+ * @io_number: Explicit descriptor before a redirection, or -1.
+ * @lineno: Line the token starts on.
+ */
+typedef struct token
+{
+int type;
+char *text;
+int quoted;
+int redir;
+int io_number;
+int lineno;
+} token;
+
+/**
+ * struct redirect - A redirection attached to a command.
+ * @fd: Descriptor being redirected.
+ * @kind: One of enum redir_kind.
+ * @word: Target word, or the here-document delimiter (quotes removed).
+ * @body: Here-document body, raw.
+ * @quoted: Non-zero if the here-document delimiter was quoted.
+ * @next: Next redirection, in source order.
+ */
+typedef struct redirect
+{
+int fd;
+int kind;
+char *word;
+char *body;
+int quoted;
+struct redirect *next;
+} redirect;
+
+/**
+ * struct case_item - One "pattern) list ;;" arm of a case command.
+ * @patterns: NULL terminated list of raw pattern words.
+ * @body: Commands to run, or NULL.
+ * @next: Next arm.
+ */
+typedef struct case_item
+{
+char **patterns;
+struct ast_node *body;
+struct case_item *next;
+} case_item;
+
+/**
+ * struct ast_node - A node of the command syntax tree.
+ * @kind: One of enum node_kind.
+ * @lineno: Line the command starts on.
+ * @words: Simple command words, or the word list of a for loop.
+ * @assigns: NAME=value words preceding a simple command.
+ * @redirs: Redirections of a simple or compound command.
+ * @left: Left operand; condition of if/while/until; body of for, !, ( ), { }.
+ * @right: Right operand; then-part of if; body of while/until.
+ * @alt: Else-part of if (an elif is a nested NODE_IF).
+ * @name: Variable of a for loop, subject word of a case, function name.
+ * @cases: Arms of a case command.
+ * @refs: Extra owners of the node (function table entries); ast_free
+ * only releases the node when the last owner lets go.
+ */
+typedef struct ast_node
+{
+int kind;
+int lineno;
+char **words;
+char **assigns;
+redirect *redirs;
+struct ast_node *left;
+struct ast_node *right;
+struct ast_node *alt;
+char *name;
+case_item *cases;
+int refs;
+} ast_node;
+
+/**
+ * struct shell_func - A function defined with name() { ... }.
+ * @name: Function name.
+ * @body: The compound command run on invocation (a shared reference).
+ * @next: Next function in the same hash bucket.
+ */
+typedef struct shell_func
+{
+char *name;
+ast_node *body;
+struct shell_func *next;
+} shell_func;
+
+/**
+ * struct lexer - Tokenizer state.
+ * @src: Input being tokenized.
+ * @alias_text: Expanded alias text read before @src, or NULL.
+ * @alias_pos: Read position in @alias_text.
+ * @alias_name: Alias most recently expanded, to stop recursion.
+ * @pending: Here-documents whose bodies start after the next newline
+ * (malloc'd, grown as needed).
+ * @npending: Number of pending here-documents.
+ * @pending_cap: Allocated size of @pending.
+ */
+typedef struct lexer
+{
+input_source *src;
+char *alias_text;
+size_t alias_pos;
+char *alias_name;
+redirect **pending;
+int npending;
+int pending_cap;
+} lexer;
+
+/**
+ * struct parser - Recursive descent parser state.
+ * @lx: The lexer.
+ * @tok: Lookahead token (valid when @have_tok is set).
+ * @have_tok: Non-zero if @tok holds an unconsumed token.
+ * @error: Set after a syntax error has been reported.
+ */
+typedef struct parser
+{
+lexer lx;
+token tok;
+int have_tok;
+int error;
+} parser;
+
+/* Results of parse_command */
+#define PARSE_OK 0
+#define PARSE_EMPTY 1
+#define PARSE_EOF 2
+#define PARSE_ERROR 3
+
+/* Flags for execute_node */
+#define EXEC_NOFORK 1
+#define EXEC_AND_OR 2
+
+/**
+ * struct builtin_entry - A command implemented inside the shell.
+ * @name: Command name.
+ * @handler: Implementation, called with the expanded argument vector.
+ * @special: Non-zero for POSIX special builtins, whose variable
+ * assignments outlive the command.
+ */
+typedef struct builtin_entry
+{
+const char *name;
+int (*handler)(char **argv);
+int special;
+} builtin_entry;
+
 /* Prefix of the command ie execution command */
 extern char *prefixes[];
-char *startsWithPrefix(char *input);
 char *concatTokens(char **tokens, char *separator);
 void handle_errno(char *program_nam);
+void shell_error(const char *format, ...);
 
 /* String functions prototype */
 char *stringcpy(char *dest, const char *src);
@@ -55,6 +313,13 @@ int wputchar(int chars);
 void wputs(char *str);
 char *startwith(char *string, char *prefix);
 size_t strexit(char *string, char *target);
+void sbuf_init(string_buffer *sb);
+int sbuf_reserve(string_buffer *sb, size_t extra);
+int sbuf_addn(string_buffer *sb, const char *str, size_t n);
+int sbuf_adds(string_buffer *sb, const char *str);
+int sbuf_addc(string_buffer *sb, char c);
+char *sbuf_finish(string_buffer *sb);
+void sbuf_free(string_buffer *sb);
 
 /*Custom strtok function prototypes and a strncpy clone*/
 void stringcpyall(char *dest, const char *src, size_t n);
@@ -73,10 +338,52 @@ void free_environment(char **env_array);
 /*display prompt and Read command functions prototypes*/
 int isInteractiveMode(void);
 void displayHostName(void);
+void prompt_chdir(const char *cwd);
+const char *prompt_render(size_t *len);
+const char *prompt_update(size_t *len);
+void prompt_command_start(void);
+char *line_edit(const char *prompt, size_t prompt_len);
 char *getUserName(void);
-char *read_command();
+char *read_line_raw(void);
 char *strsearch(char *str, const char *keyword);
 
+/* History prototypes */
+size_t history_count(void);
+const char *history_get(size_t index, size_t *len);
+void history_add(const char *line);
+long history_search(const char *query, size_t len, size_t before);
+char *history_expand(char *line);
+
+/**
+ * struct completion - The completions of the word before the cursor.
+ * @names: The candidates, sorted; owned by the completion caches.
+ * @count: Number of candidates.
+ * @typed: Bytes of each candidate already typed.
+ * @dir: Directory holding the candidates, or NULL for command names.
+ * @quote: Quote left open in the word, or 0.
+ */
+typedef struct completion
+{
+char **names;
+size_t count;
+size_t typed;
+const char *dir;
+char quote;
+} completion;
+
+/* Prompt segment prototypes */
+void segment_request(const char *dir);
+int segment_wait(int ms);
+void segment_git(const char *dir, char *out, size_t size);
+int segment_fd(void);
+void segment_drain(void);
+void segment_reap(void);
+
+/* Completion prototypes */
+int complete_find(const char *line, size_t pos, completion *comp);
+int complete_is_dir(const completion *comp, size_t index);
+void complete_escape(string_buffer *sb, const char *text, size_t len, char quote);
+
 /* Knight functions prototypes*/
 int isOnlyWhitespace(const char *str);
 char **tokenize(char *str, char *delimiter);
@@ -85,10 +392,7 @@ size_t strcondition(char *String, char *stableString, char *allowedString, size_
 int containschars(const char *string, char *target);
 
 /*Get path and execute command + system command prototype*/
-char *get_command_path(char *command);
-int execute_command(char *command);
-void execute_cd(char *input);
-int get_system(char *command);
+char *search_path(const char *command, int mode);
 int run_system(const char *command);
 
 /*Menviroment getenv + more string funcion prototype*/
@@ -96,18 +400,107 @@ char *get_environment(const char *name);
 int strinprintf(char *str, size_t size, const char *format, ...);
 int stringtwocmp(const char *str1, const char *str2, size_t n);
 void process_env_command(char *command);
-void execute_commands_from_file(char *filename);
+int execute_commands_from_file(char *filename);
 
 /*incrementString or write it*/
 void* memoryset(void* ptr, int value, size_t num);
 char* incrementString(char *numStr);
 
 /* Built-in function prototypes */
-void execute_exit(char *input);
 void execute_env(void);
-void execute_separator(char *input);
-void execute_logical_operator(char *command);
-int execute_with_variable_replacement(char *command);
+builtin_entry *find_builtin(const char *name);
+const char *builtin_name(size_t index);
+int dispatch_bench(long rounds);
+int builtin_echo(char **argv);
+int builtin_printf(char **argv);
+int builtin_test(char **argv);
+void test_forget(void);
+int builtin_read(char **argv);
+void read_sync(void);
+const char *dir_logical(void);
+int builtin_cd(char **argv);
+int builtin_pushd(char **argv);
+int builtin_popd(char **argv);
+int builtin_dirs(char **argv);
+int builtin_pwd(char **argv);
+
+/* Buffered standard output of builtins */
+int out_flush(void);
+int out_retarget(void);
+int out_failed(void);
+int out_write(const char *text, size_t len);
+int out_puts(const char *text);
+int out_printf(const char *format, ...);
+void out_exit(int status);
+
+/* Lexer and parser prototypes */
+void source_init_string(input_source *src, const char *text);
+void source_init_stdin(input_source *src);
+void source_free(input_source *src);
+int source_open_file(input_source *src, const char *path);
+int source_read_block(input_source *src);
+int script_cache_run(input_source *src, const char *path, int *status);
+int script_compile(char **paths);
+int script_cache_bench(const char *path, int rounds);
+int startup_bench(int rounds);
+int batch_run(const char *jobs_arg, char *path);
+void lexer_init(lexer *lx, input_source *src);
+void lexer_free(lexer *lx);
+int lexer_next(lexer *lx, token *tok);
+void lexer_push_alias(lexer *lx, const char *name, const char *value);
+void lexer_add_heredoc(lexer *lx, redirect *r);
+void token_free(token *tok);
+void parser_init(parser *ps, input_source *src);
+void parser_free(parser *ps);
+ast_node *parse_command(parser *ps, int *status);
+int parser_at_eof(parser *ps);
+void ast_free(ast_node *node);
+
+/* Interpreter prototypes */
+int execute_node(ast_node *node, int flags);
+int run_tree(ast_node *tree, int flags);
+int run_source(input_source *src, int flags);
+int run_string(const char *text, int flags);
+char *command_substitute(const char *text);
+
+/* Shell variable store, arithmetic and expansion prototypes */
+int is_valid_name(const char *name, size_t len);
+char *var_lookup(const char *name);
+char *var_lookup_n(const char *name, size_t len);
+int var_set(const char *name, const char *value);
+int var_set_number(const char *name, long number);
+void var_unset(const char *name);
+int var_export(const char *name, const char *value);
+void var_scope_push(void);
+void var_scope_pop(void);
+int var_make_local(const char *name);
+
+/* Function prototypes */
+int func_define(const char *name, ast_node *body);
+shell_func *func_lookup(const char *name);
+void func_unset(const char *name);
+int is_assignment(const char *word);
+int var_assign(const char *word);
+int arith_eval(const char *expr, long *result);
+char *expand_command(const char *command);
+char *expand_heredoc(const char *body);
+char **expand_words(char **words);
+char *expand_word_string(const char *word);
+char *expand_pattern(const char *word);
+void free_words(char **words);
+
+/* Here-document prototypes */
+int write_all(int fd, const char *data, size_t len);
+int heredoc_open(const char *body, size_t len);
+
+/* Pathname expansion prototypes */
+int has_glob_chars(const char *word);
+int glob_match(const char *pattern, const char *string);
+char *unescape_pattern(const char *pattern, size_t len);
+void glob_sort(char **names, size_t count);
+char **glob_expand(const char *pattern, glob_cache *cache);
+void glob_cache_free(glob_cache *cache);
+char **glob_walk_tree(const char *dir, const char *match, size_t *count);
 
 /* Alias function prototypes */
 size_t charsBeforeWord(char *string, char *word);
@@ -115,8 +508,19 @@ void addAlias(char *alias);
 char *checkAlias(char *command);
 char *cmdConstructor(char *command);
 char **extractSubstrings(char *string, const char *keyword);
+char *lookupAlias(const char *name);
 
 
 extern char **environ;
 extern char **definedalias;
+extern int last_exit_status;
+extern char *shell_name;
+extern int shell_lineno;
+extern int loop_depth;
+extern int pending_break;
+extern int pending_continue;
+extern int pending_return;
+extern int func_depth;
+extern char **positional_params;
+extern int positional_count;
 #endif /* MAIN_H */
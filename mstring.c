@@ -128,3 +128,124 @@ size_t strexit(char *string, char *target) {
     }
     return (count);
 }
+
+
+/**
+ * sbuf_init - Initialise an empty growable string buffer.
+ * @sb: The buffer to initialise.
+ */
+void sbuf_init(string_buffer *sb)
+{
+    sb->data = NULL;
+    sb->len = 0;
+    sb->cap = 0;
+}
+
+/**
+ * sbuf_reserve - Make room for at least @extra more bytes plus a terminator.
+ * @sb: The buffer to grow.
+ * @extra: Number of bytes about to be appended.
+ *
+ * Return: 0 on success, -1 if memory could not be allocated.
+ */
+int sbuf_reserve(string_buffer *sb, size_t extra)
+{
+    size_t need = sb->len + extra + 1;
+    size_t cap = sb->cap ? sb->cap : 64;
+    char *data;
+
+    if (need <= sb->cap) {
+        return (0);
+    }
+    while (cap < need) {
+        cap *= 2;
+    }
+    data = realloc(sb->data, cap);
+    if (data == NULL) {
+        perror("realloc");
+        return (-1);
+    }
+    sb->data = data;
+    sb->data[sb->len] = '\0';
+    sb->cap = cap;
+    return (0);
+}
+
+/**
+ * sbuf_addn - Append @n bytes of @str to the buffer.
+ * @sb: The buffer.
+ * @str: Bytes to append.
+ * @n: Number of bytes.
+ *
+ * Return: 0 on success, -1 on allocation failure.
+ */
+int sbuf_addn(string_buffer *sb, const char *str, size_t n)
+{
+    if (sbuf_reserve(sb, n) != 0) {
+        return (-1);
+    }
+    memcpy(sb->data + sb->len, str, n);
+    sb->len += n;
+    sb->data[sb->len] = '\0';
+    return (0);
+}
+
+/**
+ * sbuf_adds - Append a NUL terminated string to the buffer.
+ * @sb: The buffer.
+ * @str: String to append (NULL appends nothing).
+ *
+ * Return: 0 on success, -1 on allocation failure.
+ */
+int sbuf_adds(string_buffer *sb, const char *str)
+{
+    if (str == NULL) {
+        return (sbuf_reserve(sb, 0));
+    }
+    return (sbuf_addn(sb, str, strlen(str)));
+}
+
+/**
+ * sbuf_addc - Append a single character to the buffer.
+ * @sb: The buffer.
+ * @c: Character to append.
+ *
+ * Return: 0 on success, -1 on allocation failure.
+ */
+int sbuf_addc(string_buffer *sb, char c)
+{
+    if (sb->len + 2 > sb->cap && sbuf_reserve(sb, 1) != 0) {
+        return (-1);
+    }
+    sb->data[sb->len++] = c;
+    sb->data[sb->len] = '\0';
+    return (0);
+}
+
+/**
+ * sbuf_finish - Hand the accumulated string over to the caller.
+ * @sb: The buffer, left empty afterwards.
+ *
+ * Return: A malloc'd NUL terminated string (never NULL unless out of memory).
+ */
+char *sbuf_finish(string_buffer *sb)
+{
+    char *data;
+
+    if (sbuf_reserve(sb, 0) != 0) {
+        return (NULL);
+    }
+    data = sb->data;
+    sbuf_init(sb);
+    return (data);
+}
+
+/**
+ * sbuf_free - Release the buffer's storage.
+ * @sb: The buffer.
+ */
+void sbuf_free(string_buffer *sb)
+{
+    free(sb->data);
+    sbuf_init(sb);
+}
@@ -0,0 +1,191 @@
+#include "main.h"
+
+/* Size of the builtin output buffer */
+#define OUT_SIZE 16384
+
+/* How the buffer is flushed, decided on the first write to each target */
+#define OUT_UNKNOWN 0
+#define OUT_BLOCK 1
+#define OUT_LINE 2
+
+/**
+ * struct out_buffer - Standard output written by builtins.
+ * @data: Bytes not written yet.
+ * @len: Number of them.
+ * @mode: OUT_LINE when standard output is a terminal, OUT_BLOCK otherwise;
+ * kept until out_retarget says standard output changed.
+ * @failed: Non-zero after a write error, until out_failed is called.
+ * @registered: Non-zero once out_flush is set to run at exit.
+ *
+ * Everything that writes to standard output outside the buffer (external
+ * commands, redirections, child processes) flushes it first, so the order
+ * of the output is kept.
+ */
+typedef struct out_buffer
+{
+char data[OUT_SIZE];
+size_t len;
+int mode;
+int failed;
+int registered;
+} out_buffer;
+
+static out_buffer out;
+
+
+/**
+ * out_at_exit - Flush the buffer when the shell exits.
+ */
+static void out_at_exit(void)
+{
+    out_flush();
+}
+
+
+/**
+ * out_flush - Write the buffered output.
+ *
+ * Return: 0 on success, -1 on a write error (the output is dropped).
+ */
+int out_flush(void)
+{
+    int status = 0;
+
+    if (out.len > 0) {
+        status = write_all(STDOUT_FILENO, out.data, out.len);
+        out.len = 0;
+    }
+    if (status < 0) {
+        out.failed = 1;
+        return (-1);
+    }
+    return (0);
+}
+
+
+/**
+ * out_retarget - Flush the buffer before standard output is replaced.
+ *
+ * The terminal check is made again on the next write.
+ *
+ * Return: 0 on success, -1 on a write error.
+ */
+int out_retarget(void)
+{
+    out.mode = OUT_UNKNOWN;
+    return (out_flush());
+}
+
+
+/**
+ * out_failed - Tell whether a write failed since the last call.
+ *
+ * Return: 1 if one did, 0 otherwise.
+ */
+int out_failed(void)
+{
+    int failed = out.failed;
+
+    out.failed = 0;
+    return (failed);
+}
+
+
+/**
+ * out_write - Append bytes to standard output.
+ * @text: The bytes.
+ * @len: Their number.
+ *
+ * Return: 0 on success, -1 if writing failed.
+ */
+int out_write(const char *text, size_t len)
+{
+    int status = 0;
+
+    if (out.mode == OUT_UNKNOWN) {
+        out.mode = isatty(STDOUT_FILENO) ? OUT_LINE : OUT_BLOCK;
+        if (!out.registered) {
+            atexit(out_at_exit);
+            out.registered = 1;
+        }
+    }
+    if (out.len + len > OUT_SIZE) {
+        status = out_flush();
+    }
+    if (len >= OUT_SIZE) {
+        if (write_all(STDOUT_FILENO, text, len) < 0) {
+            out.failed = 1;
+            return (-1);
+        }
+        return (status);
+    }
+    memcpy(out.data + out.len, text, len);
+    out.len += len;
+    if (out.mode == OUT_LINE && memchr(text, '\n', len) != NULL) {
+        status |= out_flush();
+    }
+    return (status);
+}
+
+
+/**
+ * out_puts - Append a string to standard output.
+ * @text: The string.
+ *
+ * Return: 0 on success, -1 if writing failed.
+ */
+int out_puts(const char *text)
+{
+    return (out_write(text, strlen(text)));
+}
+
+
+/**
+ * out_printf - Append formatted text to standard output.
+ * @format: printf format.
+ *
+ * Return: 0 on success, -1 if writing failed.
+ */
+int out_printf(const char *format, ...)
+{
+    char small[512], *text = small;
+    va_list args;
+    int len, status;
+
+    va_start(args, format);
+    len = vsnprintf(small, sizeof(small), format, args);
+    va_end(args);
+    if (len < 0) {
+        return (-1);
+    }
+    if ((size_t)len >= sizeof(small)) {
+        text = malloc(len + 1);
+        if (text == NULL) {
+            perror("malloc");
+            return (-1);
+        }
+        va_start(args, format);
+        vsnprintf(text, len + 1, format, args);
+        va_end(args);
+    }
+    status = out_write(text, len);
+    if (text != small) {
+        free(text);
+    }
+    return (status);
+}
+
+
+/**
+ * out_exit - End a child copy of the shell after writing its output.
+ * @status: Exit status.
+ *
+ * Children leave with _exit, which skips the atexit flush; input read
+ * ahead by read is given back to the parent the same way.
+ */
+void out_exit(int status)
+{
+    out_flush();
+    read_sync();
+    _exit(status);
+}
@@ -0,0 +1,1057 @@
+#include "main.h"
+
+static ast_node *parse_and_or(parser *ps);
+static ast_node *parse_compound_list(parser *ps, const char *expecting);
+static ast_node *parse_unit(parser *ps);
+static ast_node *parse_function(parser *ps, ast_node *node);
+
+
+/**
+ * parser_init - Prepare a parser for a source.
+ * @ps: The parser.
+ * @src: Input to parse.
+ */
+void parser_init(parser *ps, input_source *src)
+{
+    lexer_init(&ps->lx, src);
+    ps->have_tok = 0;
+    ps->tok.text = NULL;
+    ps->error = 0;
+}
+
+
+/**
+ * parser_free - Release the parser's lookahead and lexer state.
+ * @ps: The parser.
+ */
+void parser_free(parser *ps)
+{
+    if (ps->have_tok) {
+        token_free(&ps->tok);
+        ps->have_tok = 0;
+    }
+    lexer_free(&ps->lx);
+}
+
+
+/**
+ * peek - Return the type of the lookahead token, reading it if needed.
+ * @ps: The parser.
+ *
+ * Tokens are only read on demand, so the parser never asks for input past
+ * the newline that ends a command.
+ *
+ * Return: The token type.
+ */
+static int peek(parser *ps)
+{
+    if (!ps->have_tok) {
+        lexer_next(&ps->lx, &ps->tok);
+        ps->have_tok = 1;
+        if (ps->tok.type == TOK_ERROR) {
+            ps->error = 1;
+        }
+    }
+    return (ps->tok.type);
+}
+
+
+/**
+ * consume - Drop the lookahead token.
+ * @ps: The parser.
+ */
+static void consume(parser *ps)
+{
+    token_free(&ps->tok);
+    ps->have_tok = 0;
+}
+
+
+/**
+ * take_word - Consume the lookahead word and return its text.
+ * @ps: The parser.
+ *
+ * Return: The word (ownership passes to the caller).
+ */
+static char *take_word(parser *ps)
+{
+    char *text = ps->tok.text;
+
+    ps->tok.text = NULL;
+    ps->have_tok = 0;
+    return (text);
+}
+
+
+/**
+ * at_keyword - Check whether the lookahead is an unquoted reserved word.
+ * @ps: The parser.
+ * @word: The reserved word.
+ *
+ * Return: 1 if it is, 0 otherwise.
+ */
+static int at_keyword(parser *ps, const char *word)
+{
+    return (peek(ps) == TOK_WORD && !ps->tok.quoted && stringcmp(ps->tok.text, word) == 0);
+}
+
+
+/**
+ * is_reserved - Check whether a word is a reserved word.
+ * @tok: The token.
+ *
+ * Return: 1 if it is, 0 otherwise.
+ */
+static int is_reserved(token *tok)
+{
+    static const char *const words[] = {
+        "if", "then", "else", "elif", "fi", "do", "done", "case", "esac",
+        "while", "until", "for", "in", "{", "}", "!", NULL
+    };
+    int i;
+
+    if (tok->type != TOK_WORD || tok->quoted) {
+        return (0);
+    }
+    for (i = 0; words[i] != NULL; i++) {
+        if (strcmp(tok->text, words[i]) == 0) {
+            return (1);
+        }
+    }
+    return (0);
+}
+
+
+/**
+ * token_name - Describe the lookahead token for an error message.
+ * @ps: The parser.
+ *
+ * Return: A static description.
+ */
+static const char *token_name(parser *ps)
+{
+    static const char *const names[] = {
+        "end of file", "word", "newline", ";", "&", "&&", "||", "|", "(", ")", ";;"
+    };
+    static const char *const redirs[] = {
+        "<", ">", ">>", ">|", "<>", "<&", ">&", "<<", "<<-"
+    };
+
+    if (ps->tok.type == TOK_WORD) {
+        return (ps->tok.text);
+    }
+    if (ps->tok.type == TOK_REDIR) {
+        return (redirs[ps->tok.redir]);
+    }
+    return (names[ps->tok.type]);
+}
+
+
+/**
+ * syntax_error - Report an unexpected token.
+ * @ps: The parser.
+ * @expecting: What was expected, or NULL.
+ */
+static void syntax_error(parser *ps, const char *expecting)
+{
+    if (ps->error) {
+        return;
+    }
+    ps->error = 1;
+    shell_lineno = ps->tok.lineno;
+    if (ps->tok.type == TOK_EOF && expecting != NULL) {
+        shell_error("Syntax error: end of file unexpected (expecting \"%s\")", expecting);
+    } else if (ps->tok.type == TOK_EOF) {
+        shell_error("Syntax error: end of file unexpected");
+    } else {
+        shell_error("Syntax error: \"%s\" unexpected", token_name(ps));
+    }
+}
+
+
+/**
+ * expect_keyword - Consume a required reserved word.
+ * @ps: The parser.
+ * @word: The reserved word.
+ *
+ * Return: 0 if found, -1 after reporting a syntax error.
+ */
+static int expect_keyword(parser *ps, const char *word)
+{
+    if (!at_keyword(ps, word)) {
+        syntax_error(ps, word);
+        return (-1);
+    }
+    consume(ps);
+    return (0);
+}
+
+
+/**
+ * skip_newlines - Consume any newline tokens.
+ * @ps: The parser.
+ */
+static void skip_newlines(parser *ps)
+{
+    while (peek(ps) == TOK_NEWLINE) {
+        consume(ps);
+    }
+}
+
+
+/**
+ * new_node - Allocate a zeroed syntax tree node.
+ * @kind: Node kind.
+ * @lineno: Source line.
+ *
+ * Return: The node, or NULL on allocation failure.
+ */
+static ast_node *new_node(int kind, int lineno)
+{
+    ast_node *node = calloc(1, sizeof(ast_node));
+
+    if (node == NULL) {
+        perror("malloc");
+        return (NULL);
+    }
+    node->kind = kind;
+    node->lineno = lineno;
+    return (node);
+}
+
+
+/**
+ * new_binary - Build a node joining two subtrees.
+ * @kind: Node kind.
+ * @left: Left operand.
+ * @right: Right operand.
+ *
+ * Return: The node, or NULL (both operands are freed) on failure.
+ */
+static ast_node *new_binary(int kind, ast_node *left, ast_node *right)
+{
+    ast_node *node = new_node(kind, left->lineno);
+
+    if (node == NULL) {
+        ast_free(left);
+        ast_free(right);
+        return (NULL);
+    }
+    node->left = left;
+    node->right = right;
+    return (node);
+}
+
+
+/**
+ * word_push - Append a word to a NULL terminated vector.
+ * @vec: The vector (may be NULL).
+ * @count: Number of words in @vec, updated.
+ * @word: The word, ownership is taken.
+ *
+ * Return: The (possibly moved) vector.
+ */
+static char **word_push(char **vec, size_t *count, char *word)
+{
+    char **grown = realloc(vec, (*count + 2) * sizeof(char *));
+
+    if (grown == NULL) {
+        perror("realloc");
+        free(word);
+        return (vec);
+    }
+    grown[(*count)++] = word;
+    grown[*count] = NULL;
+    return (grown);
+}
+
+
+/**
+ * parse_redirect - Parse one redirection and append it to a list.
+ * @ps: The parser, at a TOK_REDIR token.
+ * @list: Where to append (a pointer to the list's last next field).
+ *
+ * Return: 0 on success, -1 on syntax error.
+ */
+static int parse_redirect(parser *ps, redirect ***list)
+{
+    redirect *r = calloc(1, sizeof(redirect));
+    char *word, *p;
+    string_buffer sb;
+
+    if (r == NULL) {
+        perror("malloc");
+        return (-1);
+    }
+    r->kind = ps->tok.redir;
+    r->fd = ps->tok.io_number;
+    if (r->fd < 0) {
+        r->fd = (r->kind == REDIR_IN || r->kind == REDIR_RDWR || r->kind == REDIR_DUPIN
+                 || r->kind == REDIR_HEREDOC || r->kind == REDIR_HEREDOC_STRIP) ? 0 : 1;
+    }
+    consume(ps);
+    if (peek(ps) != TOK_WORD) {
+        free(r);
+        syntax_error(ps, NULL);
+        return (-1);
+    }
+    r->quoted = ps->tok.quoted;
+    word = take_word(ps);
+    if (r->kind == REDIR_HEREDOC || r->kind == REDIR_HEREDOC_STRIP) {
+        /* The delimiter is matched with its quotes removed */
+        sbuf_init(&sb);
+        for (p = word; *p != '\0'; p++) {
+            if (*p == '\\' && p[1] != '\0') {
+                sbuf_addc(&sb, *++p);
+            } else if (*p != '\'' && *p != '"') {
+                sbuf_addc(&sb, *p);
+            }
+        }
+        free(word);
+        word = sbuf_finish(&sb);
+        lexer_add_heredoc(&ps->lx, r);
+    }
+    r->word = word;
+    **list = r;
+    *list = &r->next;
+    return (0);
+}
+
+
+/**
+ * parse_redirect_list - Parse redirections following a compound command.
+ * @ps: The parser.
+ * @node: The command receiving them.
+ *
+ * Return: 0 on success, -1 on syntax error.
+ */
+static int parse_redirect_list(parser *ps, ast_node *node)
+{
+    redirect **tail = &node->redirs;
+
+    while (peek(ps) == TOK_REDIR) {
+        if (parse_redirect(ps, &tail) != 0) {
+            return (-1);
+        }
+    }
+    return (0);
+}
+
+
+/**
+ * parse_simple - Parse assignments, words and redirections of a command.
+ * @ps: The parser.
+ *
+ * Aliases are expanded when they appear as the command word.
+ *
+ * Return: The node, or NULL on error.
+ */
+static ast_node *parse_simple(parser *ps)
+{
+    ast_node *node = new_node(NODE_SIMPLE, ps->tok.lineno);
+    redirect **tail;
+    size_t nwords = 0, nassigns = 0;
+    char *value;
+
+    if (node == NULL) {
+        return (NULL);
+    }
+    tail = &node->redirs;
+    for (;;) {
+        if (peek(ps) == TOK_REDIR) {
+            if (parse_redirect(ps, &tail) != 0) {
+                ast_free(node);
+                return (NULL);
+            }
+            continue;
+        }
+        if (ps->tok.type != TOK_WORD) {
+            break;
+        }
+        if (nwords == 0 && is_assignment(ps->tok.text)) {
+            node->assigns = word_push(node->assigns, &nassigns, take_word(ps));
+            continue;
+        }
+        if (nwords == 0 && !ps->tok.quoted
+            && (ps->lx.alias_name == NULL || stringcmp(ps->lx.alias_name, ps->tok.text) != 0)
+            && (value = lookupAlias(ps->tok.text)) != NULL) {
+            lexer_push_alias(&ps->lx, ps->tok.text, value);
+            consume(ps);
+            continue;
+        }
+        node->words = word_push(node->words, &nwords, take_word(ps));
+        if (nwords == 1 && nassigns == 0 && node->redirs == NULL && peek(ps) == TOK_LPAREN) {
+            node->name = node->words[0];
+            node->words[0] = NULL;
+            return (parse_function(ps, node));
+        }
+    }
+    if (nwords == 0 && nassigns == 0 && node->redirs == NULL) {
+        ast_free(node);
+        syntax_error(ps, NULL);
+        return (NULL);
+    }
+    return (node);
+}
+
+
+/**
+ * parse_if - Parse if ... then ... [elif ... then ...] [else ...] fi.
+ * @ps: The parser, at "if" or "elif".
+ *
+ * Return: The node, or NULL on error.
+ */
+static ast_node *parse_if(parser *ps)
+{
+    ast_node *node = new_node(NODE_IF, ps->tok.lineno);
+
+    if (node == NULL) {
+        return (NULL);
+    }
+    consume(ps);
+    node->left = parse_compound_list(ps, "then");
+    if (node->left == NULL || expect_keyword(ps, "then") != 0) {
+        ast_free(node);
+        return (NULL);
+    }
+    node->right = parse_compound_list(ps, "fi");
+    if (node->right == NULL) {
+        ast_free(node);
+        return (NULL);
+    }
+    if (at_keyword(ps, "elif")) {
+        node->alt = parse_if(ps);
+        if (node->alt == NULL) {
+            ast_free(node);
+            return (NULL);
+        }
+        return (node);
+    }
+    if (at_keyword(ps, "else")) {
+        consume(ps);
+        node->alt = parse_compound_list(ps, "fi");
+        if (node->alt == NULL) {
+            ast_free(node);
+            return (NULL);
+        }
+    }
+    if (expect_keyword(ps, "fi") != 0) {
+        ast_free(node);
+        return (NULL);
+    }
+    return (node);
+}
+
+
+/**
+ * parse_do_group - Parse "do list done".
+ * @ps: The parser.
+ *
+ * Return: The list, or NULL on error.
+ */
+static ast_node *parse_do_group(parser *ps)
+{
+    ast_node *body;
+
+    if (expect_keyword(ps, "do") != 0) {
+        return (NULL);
+    }
+    body = parse_compound_list(ps, "done");
+    if (body != NULL && expect_keyword(ps, "done") != 0) {
+        ast_free(body);
+        return (NULL);
+    }
+    return (body);
+}
+
+
+/**
+ * parse_while - Parse while/until list do list done.
+ * @ps: The parser, at "while" or "until".
+ * @kind: NODE_WHILE or NODE_UNTIL.
+ *
+ * Return: The node, or NULL on error.
+ */
+static ast_node *parse_while(parser *ps, int kind)
+{
+    ast_node *node = new_node(kind, ps->tok.lineno);
+
+    if (node == NULL) {
+        return (NULL);
+    }
+    consume(ps);
+    node->left = parse_compound_list(ps, "do");
+    if (node->left == NULL || (node->right = parse_do_group(ps)) == NULL) {
+        ast_free(node);
+        return (NULL);
+    }
+    return (node);
+}
+
+
+/**
+ * parse_for - Parse for name [in words] do list done.
+ * @ps: The parser, at "for".
+ *
+ * Return: The node, or NULL on error.
+ */
+static ast_node *parse_for(parser *ps)
+{
+    ast_node *node = new_node(NODE_FOR, ps->tok.lineno);
+    size_t count = 0;
+
+    if (node == NULL) {
+        return (NULL);
+    }
+    consume(ps);
+    if (peek(ps) != TOK_WORD || !is_valid_name(ps->tok.text, strlen(ps->tok.text))) {
+        syntax_error(ps, NULL);
+        ast_free(node);
+        return (NULL);
+    }
+    node->name = take_word(ps);
+    skip_newlines(ps);
+    if (at_keyword(ps, "in")) {
+        consume(ps);
+        node->words = calloc(1, sizeof(char *));
+        while (peek(ps) == TOK_WORD) {
+            node->words = word_push(node->words, &count, take_word(ps));
+        }
+        if (ps->tok.type != TOK_SEMI && ps->tok.type != TOK_NEWLINE) {
+            syntax_error(ps, "do");
+            ast_free(node);
+            return (NULL);
+        }
+        consume(ps);
+    } else if (peek(ps) == TOK_SEMI) {
+        consume(ps);
+    }
+    skip_newlines(ps);
+    node->left = parse_do_group(ps);
+    if (node->left == NULL) {
+        ast_free(node);
+        return (NULL);
+    }
+    return (node);
+}
+
+
+/**
+ * parse_case - Parse case word in [(] pattern [| pattern]...) list ;; ... esac.
+ * @ps: The parser, at "case".
+ *
+ * Return: The node, or NULL on error.
+ */
+static ast_node *parse_case(parser *ps)
+{
+    ast_node *node = new_node(NODE_CASE, ps->tok.lineno);
+    case_item **tail, *item;
+    size_t count;
+
+    if (node == NULL) {
+        return (NULL);
+    }
+    consume(ps);
+    if (peek(ps) != TOK_WORD) {
+        syntax_error(ps, NULL);
+        ast_free(node);
+        return (NULL);
+    }
+    node->name = take_word(ps);
+    skip_newlines(ps);
+    if (expect_keyword(ps, "in") != 0) {
+        ast_free(node);
+        return (NULL);
+    }
+    tail = &node->cases;
+    for (;;) {
+        skip_newlines(ps);
+        if (at_keyword(ps, "esac")) {
+            consume(ps);
+            return (node);
+        }
+        item = calloc(1, sizeof(case_item));
+        if (item == NULL) {
+            perror("malloc");
+            ast_free(node);
+            return (NULL);
+        }
+        *tail = item;
+        tail = &item->next;
+        if (peek(ps) == TOK_LPAREN) {
+            consume(ps);
+        }
+        count = 0;
+        while (peek(ps) == TOK_WORD) {
+            item->patterns = word_push(item->patterns, &count, take_word(ps));
+            if (peek(ps) != TOK_PIPE) {
+                break;
+            }
+            consume(ps);
+        }
+        if (count == 0 || peek(ps) != TOK_RPAREN) {
+            syntax_error(ps, ")");
+            ast_free(node);
+            return (NULL);
+        }
+        consume(ps);
+        skip_newlines(ps);
+        if (peek(ps) != TOK_DSEMI && !at_keyword(ps, "esac")) {
+            item->body = parse_compound_list(ps, "esac");
+            if (item->body == NULL) {
+                ast_free(node);
+                return (NULL);
+            }
+        }
+        if (peek(ps) == TOK_DSEMI) {
+            consume(ps);
+        } else if (!at_keyword(ps, "esac")) {
+            syntax_error(ps, "esac");
+            ast_free(node);
+            return (NULL);
+        }
+    }
+}
+
+
+/**
+ * parse_group - Parse { list } or ( list ).
+ * @ps: The parser, at "{" or "(".
+ * @kind: NODE_GROUP or NODE_SUBSHELL.
+ *
+ * Return: The node, or NULL on error.
+ */
+static ast_node *parse_group(parser *ps, int kind)
+{
+    ast_node *node = new_node(kind, ps->tok.lineno);
+
+    if (node == NULL) {
+        return (NULL);
+    }
+    consume(ps);
+    node->left = parse_compound_list(ps, kind == NODE_GROUP ? "}" : ")");
+    if (node->left == NULL) {
+        ast_free(node);
+        return (NULL);
+    }
+    if (kind == NODE_GROUP) {
+        if (expect_keyword(ps, "}") != 0) {
+            ast_free(node);
+            return (NULL);
+        }
+    } else if (peek(ps) != TOK_RPAREN) {
+        syntax_error(ps, ")");
+        ast_free(node);
+        return (NULL);
+    } else {
+        consume(ps);
+    }
+    return (node);
+}
+
+
+/**
+ * parse_function - Parse the rest of a function definition.
+ * @ps: The parser, after the function name.
+ * @node: Node holding the name in @name; turned into a NODE_FUNCDEF.
+ *
+ * Both "name() body" and "function name [()] body" end up here; the body
+ * must be a compound command.
+ *
+ * Return: The node, or NULL on error.
+ */
+static ast_node *parse_function(parser *ps, ast_node *node)
+{
+    node->kind = NODE_FUNCDEF;
+    free_words(node->words);
+    node->words = NULL;
+    if (!is_valid_name(node->name, strlen(node->name))) {
+        shell_lineno = node->lineno;
+        shell_error("Syntax error: Bad function name");
+        ps->error = 1;
+        ast_free(node);
+        return (NULL);
+    }
+    if (peek(ps) == TOK_LPAREN) {
+        consume(ps);
+        if (peek(ps) != TOK_RPAREN) {
+            syntax_error(ps, ")");
+            ast_free(node);
+            return (NULL);
+        }
+        consume(ps);
+    }
+    skip_newlines(ps);
+    if (peek(ps) != TOK_LPAREN && !at_keyword(ps, "{") && !at_keyword(ps, "if")
+        && !at_keyword(ps, "while") && !at_keyword(ps, "until") && !at_keyword(ps, "for")
+        && !at_keyword(ps, "case")) {
+        syntax_error(ps, NULL);
+        ast_free(node);
+        return (NULL);
+    }
+    node->left = parse_unit(ps);
+    if (node->left == NULL) {
+        ast_free(node);
+        return (NULL);
+    }
+    return (node);
+}
+
+
+/**
+ * parse_unit - Parse a simple or compound command.
+ * @ps: The parser.
+ *
+ * Return: The node, or NULL on error.
+ */
+static ast_node *parse_unit(parser *ps)
+{
+    ast_node *node = NULL;
+    int type = peek(ps);
+
+    if (type == TOK_LPAREN) {
+        node = parse_group(ps, NODE_SUBSHELL);
+    } else if (at_keyword(ps, "function")) {
+        node = new_node(NODE_FUNCDEF, ps->tok.lineno);
+        consume(ps);
+        if (node == NULL || peek(ps) != TOK_WORD) {
+            free(node);
+            syntax_error(ps, NULL);
+            return (NULL);
+        }
+        node->name = take_word(ps);
+        return (parse_function(ps, node));
+    } else if (type == TOK_WORD && is_reserved(&ps->tok)) {
+        if (at_keyword(ps, "if")) {
+            node = parse_if(ps);
+        } else if (at_keyword(ps, "while")) {
+            node = parse_while(ps, NODE_WHILE);
+        } else if (at_keyword(ps, "until")) {
+            node = parse_while(ps, NODE_UNTIL);
+        } else if (at_keyword(ps, "for")) {
+            node = parse_for(ps);
+        } else if (at_keyword(ps, "case")) {
+            node = parse_case(ps);
+        } else if (at_keyword(ps, "{")) {
+            node = parse_group(ps, NODE_GROUP);
+        } else {
+            syntax_error(ps, NULL);
+            return (NULL);
+        }
+    } else if (type == TOK_WORD || type == TOK_REDIR) {
+        return (parse_simple(ps));
+    } else {
+        syntax_error(ps, NULL);
+        return (NULL);
+    }
+    if (node != NULL && parse_redirect_list(ps, node) != 0) {
+        ast_free(node);
+        return (NULL);
+    }
+    return (node);
+}
+
+
+/**
+ * parse_pipeline - Parse [!] command [| command]...
+ * @ps: The parser.
+ *
+ * Return: The node, or NULL on error.
+ */
+static ast_node *parse_pipeline(parser *ps)
+{
+    ast_node *node, *right, *negated;
+    int negate = 0;
+
+    if (at_keyword(ps, "!")) {
+        negate = 1;
+        consume(ps);
+    }
+    node = parse_unit(ps);
+    while (node != NULL && peek(ps) == TOK_PIPE) {
+        consume(ps);
+        skip_newlines(ps);
+        right = parse_unit(ps);
+        if (right == NULL) {
+            ast_free(node);
+            return (NULL);
+        }
+        node = new_binary(NODE_PIPE, node, right);
+    }
+    if (node != NULL && negate) {
+        negated = new_node(NODE_NOT, node->lineno);
+        if (negated == NULL) {
+            ast_free(node);
+            return (NULL);
+        }
+        negated->left = node;
+        node = negated;
+    }
+    return (node);
+}
+
+
+/**
+ * parse_and_or - Parse pipelines joined by && and ||.
+ * @ps: The parser.
+ *
+ * Return: The node, or NULL on error.
+ */
+static ast_node *parse_and_or(parser *ps)
+{
+    ast_node *node = parse_pipeline(ps), *right;
+    int kind;
+
+    while (node != NULL && (peek(ps) == TOK_AND_IF || ps->tok.type == TOK_OR_IF)) {
+        kind = (ps->tok.type == TOK_AND_IF) ? NODE_AND : NODE_OR;
+        consume(ps);
+        skip_newlines(ps);
+        right = parse_pipeline(ps);
+        if (right == NULL) {
+            ast_free(node);
+            return (NULL);
+        }
+        node = new_binary(kind, node, right);
+    }
+    return (node);
+}
+
+
+/**
+ * append_command - Add a command to a list, honouring a trailing '&'.
+ * @list: The list so far (may be NULL).
+ * @node: The command.
+ * @background: Non-zero if the command ended with '&'.
+ *
+ * Return: The new list, or NULL on allocation failure.
+ */
+static ast_node *append_command(ast_node *list, ast_node *node, int background)
+{
+    ast_node *bg;
+
+    if (background) {
+        bg = new_node(NODE_BACKGROUND, node->lineno);
+        if (bg == NULL) {
+            ast_free(list);
+            ast_free(node);
+            return (NULL);
+        }
+        bg->left = node;
+        node = bg;
+    }
+    return (list == NULL ? node : new_binary(NODE_SEQ, list, node));
+}
+
+
+/**
+ * ends_list - Check whether the lookahead closes a compound list.
+ * @ps: The parser.
+ *
+ * Return: 1 if it does, 0 otherwise.
+ */
+static int ends_list(parser *ps)
+{
+    static const char *const words[] = {
+        "then", "else", "elif", "fi", "do", "done", "esac", "}", NULL
+    };
+    int i;
+
+    if (ps->tok.type == TOK_RPAREN || ps->tok.type == TOK_DSEMI || ps->tok.type == TOK_EOF) {
+        return (1);
+    }
+    for (i = 0; words[i] != NULL; i++) {
+        if (at_keyword(ps, words[i])) {
+            return (1);
+        }
+    }
+    return (0);
+}
+
+
+/**
+ * parse_compound_list - Parse the commands inside a compound command.
+ * @ps: The parser.
+ * @expecting: The word that should eventually close the list.
+ *
+ * Return: The list, or NULL on error (an empty list is an error).
+ */
+static ast_node *parse_compound_list(parser *ps, const char *expecting)
+{
+    ast_node *list = NULL, *node;
+    int background;
+
+    skip_newlines(ps);
+    while (!ends_list(ps)) {
+        node = parse_and_or(ps);
+        if (node == NULL) {
+            ast_free(list);
+            return (NULL);
+        }
+        background = (peek(ps) == TOK_AMP);
+        list = append_command(list, node, background);
+        if (list == NULL) {
+            return (NULL);
+        }
+        if (ps->tok.type == TOK_SEMI || ps->tok.type == TOK_AMP || ps->tok.type == TOK_NEWLINE) {
+            consume(ps);
+            skip_newlines(ps);
+        } else {
+            break;
+        }
+    }
+    if (list == NULL || ps->error) {
+        ast_free(list);
+        syntax_error(ps, expecting);
+        return (NULL);
+    }
+    return (list);
+}
+
+
+/**
+ * recover - Discard the rest of the line after a syntax error.
+ * @ps: The parser.
+ */
+static void recover(parser *ps)
+{
+    ps->lx.npending = 0;
+    while (peek(ps) != TOK_NEWLINE && ps->tok.type != TOK_EOF) {
+        consume(ps);
+    }
+    consume(ps);
+}
+
+
+/**
+ * parse_command - Parse the next complete command.
+ * @ps: The parser.
+ * @status: Receives PARSE_OK, PARSE_EMPTY (blank line), PARSE_EOF or
+ * PARSE_ERROR (already reported; the offending line is skipped).
+ *
+ * A complete command is a list of and-or lists ended by a newline. Nothing
+ * past that newline is read, so commands run as soon as they are complete.
+ *
+ * Return: The syntax tree, or NULL.
+ */
+ast_node *parse_command(parser *ps, int *status)
+{
+    ast_node *list = NULL, *node;
+    int background;
+
+    ps->error = 0;
+    if (!ps->have_tok) {
+        ps->lx.src->continuation = 0;
+    }
+    if (peek(ps) == TOK_EOF) {
+        *status = ps->error ? PARSE_ERROR : PARSE_EOF;
+        return (NULL);
+    }
+    if (ps->tok.type == TOK_NEWLINE) {
+        consume(ps);
+        *status = PARSE_EMPTY;
+        return (NULL);
+    }
+    for (;;) {
+        node = parse_and_or(ps);
+        if (node == NULL) {
+            break;
+        }
+        background = (peek(ps) == TOK_AMP);
+        list = append_command(list, node, background);
+        if (list == NULL) {
+            break;
+        }
+        if (ps->tok.type == TOK_SEMI || ps->tok.type == TOK_AMP) {
+            consume(ps);
+            if (peek(ps) != TOK_NEWLINE && ps->tok.type != TOK_EOF) {
+                continue;
+            }
+        }
+        if (ps->tok.type == TOK_NEWLINE) {
+            consume(ps);
+            *status = PARSE_OK;
+            return (list);
+        }
+        if (ps->tok.type == TOK_EOF) {
+            *status = PARSE_OK;
+            return (list);
+        }
+        syntax_error(ps, NULL);
+        break;
+    }
+    ast_free(list);
+    if (!ps->error) {
+        syntax_error(ps, NULL);
+    }
+    recover(ps);
+    *status = PARSE_ERROR;
+    return (NULL);
+}
+
+
+/**
+ * redirect_free - Release a list of redirections.
+ * @r: The first redirection.
+ */
+static void redirect_free(redirect *r)
+{
+    redirect *next;
+
+    while (r != NULL) {
+        next = r->next;
+        free(r->word);
+        free(r->body);
+        free(r);
+        r = next;
+    }
+}
+
+
+/**
+ * parser_at_eof - Check whether any command follows in the input.
+ * @ps: The parser, between two commands.
+ *
+ * Blank lines are skipped. This reads ahead, so it must not be used on a
+ * terminal, where it would wait for the next line.
+ *
+ * Return: 1 if the input is exhausted, 0 otherwise.
+ */
+int parser_at_eof(parser *ps)
+{
+    while (peek(ps) == TOK_NEWLINE) {
+        consume(ps);
+    }
+    return (ps->tok.type == TOK_EOF);
+}
+
+
+/**
+ * ast_free - Release a syntax tree.
+ * @node: The root (may be NULL).
+ */
+void ast_free(ast_node *node)
+{
+    case_item *item, *next;
+
+    if (node == NULL) {
+        return;
+    }
+    if (node->refs > 0) {
+        node->refs--;
+        return;
+    }
+    free_words(node->words);
+    free_words(node->assigns);
+    redirect_free(node->redirs);
+    ast_free(node->left);
+    ast_free(node->right);
+    ast_free(node->alt);
+    free(node->name);
+    for (item = node->cases; item != NULL; item = next) {
+        next = item->next;
+        free_words(item->patterns);
+        ast_free(item->body);
+        free(item);
+    }
+    free(node);
+}
@@ -37,9 +37,6 @@ char *prefixes[] = {
     "dirs",       /* Display the list of currently remembered directories */
     "pushd",      /* Add directories to the directory stack */
     "popd",       /* Remove directories from the directory stack */
-    "umask",      /* Set the default file permissions */
-    "bg",         /* Put a job in the background */
-    "fg",         /* Bring a job to the foreground */
     "case",       /* Conditionally perform a command */
     "coproc",     /* Co-process */
     "declare",    /* Declare variables and give them attributes */
@@ -61,32 +58,6 @@ char *prefixes[] = {
 };
 
 
-/**
- * startsWithPrefix - Check if a command starts with a prefix.
- * @prefixes: The execution of program format to check.
- * @input: The command to find.
- * Return: 0 if the command starts with a prefix, -1 otherwise.
- */
-
-char *startsWithPrefix(char *input)
-{
-  size_t i = 0;
-  size_t prefix_length;
-
-  while (prefixes[i] != NULL) {	  
-	prefix_length = stringlen(prefixes[i]);
-
-	if (strncmp(input, prefixes[i], prefix_length) == 0) {
-	   return (prefixes[i]);
-        }
-
-   i++;
-  }
-
- return (NULL); /* No matching prefix found */
-}
-
-
 /* concatTokens - Concatenates all tokens into a single string.
  *
  * @tokens: The array of tokens to concatenate.
@@ -772,3 +743,30 @@ size_t i;
       }
 
 }
+
+
+/**
+ * shell_error - Print a diagnostic prefixed with the shell name and line.
+ * @format: printf style format of the message.
+ *
+ * The message is written as "name: line: message\n" in a single write.
+ */
+void shell_error(const char *format, ...)
+{
+    char message[BUFFER_SIZE];
+    va_list args;
+    int length;
+
+    /* Keep the message after output the same command already produced */
+    out_flush();
+    length = snprintf(message, sizeof(message), "%s: %d: ",
+        shell_name != NULL ? shell_name : "./hsh", shell_lineno);
+    va_start(args, format);
+    length += vsnprintf(message + length, sizeof(message) - length - 1, format, args);
+    va_end(args);
+    if (length > (int)sizeof(message) - 2) {
+        length = sizeof(message) - 2;
+    }
+    message[length++] = '\n';
+    write(STDERR_FILENO, message, length);
+}
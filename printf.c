@@ -0,0 +1,355 @@
+#include "main.h"
+#include <inttypes.h>
+
+/* Characters that may follow % in a printf conversion, before the width */
+#define PRINTF_FLAGS "-+ #0'"
+
+
+/**
+ * escape_decode - Decode a backslash escape.
+ * @p: The text after the backslash.
+ * @value: Where to store the byte it stands for, or -1 for \c.
+ * @echo_style: Non-zero for echo -e and %b, where octal escapes are
+ * written \0NNN; zero for printf formats, where they are \NNN.
+ *
+ * An unknown escape stands for the backslash itself.
+ *
+ * Return: The text after the escape.
+ */
+static const char *escape_decode(const char *p, int *value, int echo_style)
+{
+    static const char names[] = "abefnrtv\\", bytes[] = "\a\b\033\f\n\r\t\v\\";
+    const char *found = (*p != '\0') ? strchr(names, *p) : NULL;
+    int digits;
+
+    if (found != NULL) {
+        *value = (unsigned char)bytes[found - names];
+        return (p + 1);
+    }
+    if (*p == 'c') {
+        *value = -1;
+        return (p + 1);
+    }
+    if (!echo_style && (*p == '"' || *p == '\'')) {
+        *value = *p;
+        return (p + 1);
+    }
+    if (*p == 'x' && isxdigit((unsigned char)p[1])) {
+        *value = 0;
+        for (p++, digits = 0; digits < 2 && isxdigit((unsigned char)*p); digits++, p++) {
+            *value = *value * 16 + (isdigit((unsigned char)*p) ? *p - '0'
+                                    : tolower((unsigned char)*p) - 'a' + 10);
+        }
+        return (p);
+    }
+    if (*p >= '0' && *p <= '7' && (!echo_style || *p == '0')) {
+        if (echo_style) {
+            p++;
+        }
+        *value = 0;
+        for (digits = 0; digits < 3 && *p >= '0' && *p <= '7'; digits++, p++) {
+            *value = *value * 8 + (*p - '0');
+        }
+        *value &= 0xff;
+        return (p);
+    }
+    *value = '\\';
+    return (p);
+}
+
+
+/**
+ * escape_write - Write text, decoding its backslash escapes.
+ * @text: The text.
+ * @echo_style: As for escape_decode.
+ * @stop: Set to 1 if \c was found, ending all output.
+ *
+ * Runs of plain text are written in one piece.
+ *
+ * Return: 0 on success, -1 if writing failed.
+ */
+static int escape_write(const char *text, int echo_style, int *stop)
+{
+    const char *slash;
+    char byte;
+    int value, status = 0;
+
+    while ((slash = strchr(text, '\\')) != NULL) {
+        status |= out_write(text, slash - text);
+        text = escape_decode(slash + 1, &value, echo_style);
+        if (value == -1) {
+            *stop = 1;
+            return (status);
+        }
+        byte = (char)value;
+        status |= out_write(&byte, 1);
+    }
+    return (status | out_puts(text));
+}
+
+
+/**
+ * builtin_echo - Write the arguments: echo [-neE] [arg...]
+ * @argv: Argument vector.
+ *
+ * As the echo of GNU systems: -n drops the newline, -e decodes backslash
+ * escapes and -E (the default) does not.
+ *
+ * Return: 0, or 1 if writing failed.
+ */
+int builtin_echo(char **argv)
+{
+    int newline = 1, escapes = 0, stop = 0, status = 0, i;
+    const char *p;
+
+    for (i = 1; argv[i] != NULL && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        for (p = argv[i] + 1; *p == 'n' || *p == 'e' || *p == 'E'; p++) {
+        }
+        if (*p != '\0') {
+            break;
+        }
+        for (p = argv[i] + 1; *p != '\0'; p++) {
+            newline = newline && *p != 'n';
+            escapes = (*p == 'e') ? 1 : (*p == 'E') ? 0 : escapes;
+        }
+    }
+    for (; argv[i] != NULL && !stop; i++) {
+        if (escapes) {
+            status |= escape_write(argv[i], 1, &stop);
+        } else {
+            status |= out_puts(argv[i]);
+        }
+        if (argv[i + 1] != NULL && !stop) {
+            status |= out_write(" ", 1);
+        }
+    }
+    if (newline && !stop) {
+        status |= out_write("\n", 1);
+    }
+    return (status != 0);
+}
+
+
+/**
+ * printf_number - Convert a printf argument to a number.
+ * @arg: The argument, or NULL when they ran out (0).
+ * @is_unsigned: Non-zero for %o %u %x %X, whose values above INTMAX_MAX
+ * keep their bits; the others are clamped to the intmax_t range.
+ * @status: Set to 1 if the argument is not a valid number.
+ *
+ * A leading quote gives the value of the next character, as POSIX says.
+ *
+ * Return: The number.
+ */
+static intmax_t printf_number(const char *arg, int is_unsigned, int *status)
+{
+    char *end;
+    intmax_t value;
+
+    if (arg == NULL || *arg == '\0') {
+        return (0);
+    }
+    if (*arg == '\'' || *arg == '"') {
+        return ((unsigned char)arg[1]);
+    }
+    errno = 0;
+    if (is_unsigned) {
+        value = (intmax_t)strtoumax(arg, &end, 0);
+    } else {
+        value = strtoimax(arg, &end, 0);
+    }
+    if (end == arg || *end != '\0') {
+        shell_error("printf: %s: %s", arg,
+                    end == arg ? "expected numeric value" : "not completely converted");
+        *status = 1;
+    } else if (errno == ERANGE) {
+        shell_error("printf: %s: %s", arg, strerror(errno));
+        *status = 1;
+    }
+    return (value);
+}
+
+
+/**
+ * printf_float - Convert a printf argument to a floating point number.
+ * @arg: The argument, or NULL when they ran out (0).
+ * @status: Set to 1 if the argument is not a valid number.
+ *
+ * Return: The number.
+ */
+static double printf_float(const char *arg, int *status)
+{
+    char *end;
+    double value;
+
+    if (arg == NULL || *arg == '\0') {
+        return (0);
+    }
+    if (*arg == '\'' || *arg == '"') {
+        return ((unsigned char)arg[1]);
+    }
+    value = strtod(arg, &end);
+    if (end == arg || *end != '\0') {
+        shell_error("printf: %s: %s", arg,
+                    end == arg ? "expected numeric value" : "not completely converted");
+        *status = 1;
+    }
+    return (value);
+}
+
+
+/**
+ * printf_once - Write a printf format once, taking arguments as needed.
+ * @format: The format.
+ * @args: The remaining arguments, advanced past those used.
+ * @status: Set to 1 on a bad argument or a write error.
+ *
+ * Each conversion is handed to the C library with its flags, width and
+ * precision, so the output matches the C printf.
+ *
+ * Return: 0 at the end of the format, 1 if \c stopped all output, -1 on
+ * an invalid directive.
+ */
+static int printf_once(const char *format, char ***args, int *status)
+{
+    char spec[64], *arg, conv;
+    const char *p = format, *start;
+    string_buffer expanded;
+    int value, stop = 0;
+    size_t len;
+
+    while (*p != '\0') {
+        start = p;
+        p += strcspn(p, "\\%");
+        *status |= (out_write(start, p - start) != 0);
+        if (*p == '\\') {
+            p = escape_decode(p + 1, &value, 0);
+            if (value == -1) {
+                return (1);
+            }
+            spec[0] = (char)value;
+            *status |= (out_write(spec, 1) != 0);
+            continue;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        if (p[1] == '%' || p[1] == '\0') {
+            *status |= (out_write("%", 1) != 0);
+            p += (p[1] == '%') ? 2 : 1;
+            continue;
+        }
+
+        /* Copy the flags, and the width and precision with * filled in */
+        start = p++;
+        p += strspn(p, PRINTF_FLAGS);
+        len = p - start;
+        if (len > 16) {
+            len = 16;
+        }
+        memcpy(spec, start, len);
+        if (*p == '*') {
+            len += sprintf(spec + len, "%d", (int)printf_number(**args, 0, status));
+            *args += (**args != NULL);
+            p++;
+        } else {
+            for (; isdigit((unsigned char)*p) && len < 32; p++) {
+                spec[len++] = *p;
+            }
+        }
+        if (*p == '.') {
+            spec[len++] = *p++;
+            if (*p == '*') {
+                len += sprintf(spec + len, "%d", (int)printf_number(**args, 0, status));
+                *args += (**args != NULL);
+                p++;
+            } else {
+                for (; isdigit((unsigned char)*p) && len < 48; p++) {
+                    spec[len++] = *p;
+                }
+            }
+        }
+        p += strspn(p, "hlLjzt");
+        conv = *p++;
+        if (conv == '\0' || strchr("diouxXcsbeEfFgGaA", conv) == NULL) {
+            shell_error("printf: %.*s: invalid directive", (int)(p - start - !conv), start);
+            *status = 1;
+            return (-1);
+        }
+
+        arg = **args;
+        *args += (arg != NULL);
+        if (strchr("di", conv) != NULL) {
+            strcpy(spec + len, "jd");
+            *status |= (out_printf(spec, printf_number(arg, 0, status)) != 0);
+        } else if (strchr("ouxX", conv) != NULL) {
+            sprintf(spec + len, "j%c", conv);
+            *status |= (out_printf(spec, (uintmax_t)printf_number(arg, 1, status)) != 0);
+        } else if (strchr("eEfFgGaA", conv) != NULL) {
+            sprintf(spec + len, "%c", conv);
+            *status |= (out_printf(spec, printf_float(arg, status)) != 0);
+        } else if (conv == 'c') {
+            /* The first character, or nothing for an empty argument */
+            strcpy(spec + len, ".1s");
+            *status |= (out_printf(spec, arg != NULL ? arg : "") != 0);
+        } else if (conv == 's') {
+            strcpy(spec + len, "s");
+            *status |= (out_printf(spec, arg != NULL ? arg : "") != 0);
+        } else {
+            /* %b: the argument's escapes decoded, as echo -e does */
+            sbuf_init(&expanded);
+            sbuf_reserve(&expanded, 0);
+            for (start = arg != NULL ? arg : ""; *start != '\0' && !stop; ) {
+                if (*start != '\\') {
+                    sbuf_addc(&expanded, *start++);
+                    continue;
+                }
+                start = escape_decode(start + 1, &value, 1);
+                if (value == -1) {
+                    stop = 1;
+                } else {
+                    sbuf_addc(&expanded, (char)value);
+                }
+            }
+            strcpy(spec + len, "s");
+            if (expanded.data != NULL) {
+                *status |= (out_printf(spec, expanded.data) != 0);
+            }
+            sbuf_free(&expanded);
+            if (stop) {
+                return (1);
+            }
+        }
+    }
+    return (0);
+}
+
+
+/**
+ * builtin_printf - Write formatted output: printf format [arg...]
+ * @argv: Argument vector.
+ *
+ * The format is used again as long as arguments remain and it consumed
+ * some of them, as POSIX requires.
+ *
+ * Return: 0, 1 on a bad argument or write error, 2 on a usage error.
+ */
+int builtin_printf(char **argv)
+{
+    char **args, **before;
+    int status = 0, result;
+
+    if (argv[1] != NULL && strcmp(argv[1], "--") == 0) {
+        argv++;
+    }
+    if (argv[1] == NULL) {
+        shell_error("printf: usage: printf format [arg ...]");
+        return (2);
+    }
+    args = argv + 2;
+    do {
+        before = args;
+        result = printf_once(argv[1], &args, &status);
+    } while (result == 0 && *args != NULL && args != before);
+    return (status);
+}
@@ -0,0 +1,429 @@
+#include "main.h"
+
+/* Bytes asked for by the first read ahead after a rewind, and at most */
+#define READ_FIRST 512
+#define READ_SIZE 65536
+
+/* Kinds of characters for field splitting */
+#define READ_PLAIN 0
+#define READ_SPACE 1
+#define READ_DELIM 2
+
+/**
+ * struct read_buffer - Input read ahead of the read builtin.
+ * @fd: The file descriptor, or -1 when nothing is held.
+ * @data: READ_SIZE bytes (malloc'd on first use).
+ * @start: First byte not consumed yet.
+ * @end: End of the bytes read.
+ * @want: Bytes to ask for on the next refill; it doubles while no one
+ * else needs the file offset, so long loops read large blocks.
+ * @registered: Non-zero once read_sync is set to run at exit.
+ *
+ * Only regular files are read ahead: their offset can be moved back with
+ * lseek, so before anything else may use the descriptor (a redirection,
+ * a new process, the shell exiting) read_sync rewinds it to just after
+ * the last delimiter consumed, as if read had gone byte by byte.
+ */
+typedef struct read_buffer
+{
+int fd;
+char *data;
+size_t start;
+size_t end;
+size_t want;
+int registered;
+} read_buffer;
+
+static read_buffer rb = {-1, NULL, 0, 0, READ_FIRST, 0};
+
+/**
+ * struct read_line - A line read, being split into variables.
+ * @text: The bytes, escapes still in place unless raw.
+ * @len: Their number.
+ * @raw: Non-zero for read -r: backslashes are plain characters.
+ * @ifs: The field separators.
+ */
+typedef struct read_line
+{
+const char *text;
+size_t len;
+int raw;
+const char *ifs;
+} read_line;
+
+
+/**
+ * read_at_exit - Give back the input read ahead when the shell exits.
+ */
+static void read_at_exit(void)
+{
+    read_sync();
+}
+
+
+/**
+ * read_sync - Rewind the file read ahead to the input actually consumed.
+ *
+ * Called before anything that may use the descriptor or its offset.
+ */
+void read_sync(void)
+{
+    if (rb.fd < 0) {
+        return;
+    }
+    if (rb.end > rb.start) {
+        lseek(rb.fd, -(off_t)(rb.end - rb.start), SEEK_CUR);
+    }
+    rb.fd = -1;
+    rb.start = 0;
+    rb.end = 0;
+    rb.want = READ_FIRST;
+}
+
+
+/**
+ * read_begin - Decide how a descriptor is read.
+ * @fd: The descriptor.
+ *
+ * A regular file keeps the bytes read ahead by an earlier read on the same
+ * descriptor; anything else is read one byte at a time, so no input meant
+ * for other commands is consumed.
+ */
+static void read_begin(int fd)
+{
+    struct stat st;
+
+    if (rb.fd == fd) {
+        return;
+    }
+    read_sync();
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return;
+    }
+    if (rb.data == NULL) {
+        rb.data = malloc(READ_SIZE);
+        if (rb.data == NULL) {
+            return;
+        }
+    }
+    if (!rb.registered) {
+        atexit(read_at_exit);
+        rb.registered = 1;
+    }
+    rb.fd = fd;
+}
+
+
+/**
+ * read_byte - Get the next byte of input.
+ * @fd: The descriptor, set up with read_begin.
+ * @c: Where to store it.
+ *
+ * Return: 1 for a byte, 0 at end of input, -1 on error.
+ */
+static int read_byte(int fd, char *c)
+{
+    ssize_t count;
+
+    if (rb.fd != fd) {
+        do {
+            count = read(fd, c, 1);
+        } while (count < 0 && errno == EINTR);
+        return (count < 0 ? -1 : (int)count);
+    }
+    if (rb.start == rb.end) {
+        do {
+            count = read(fd, rb.data, rb.want);
+        } while (count < 0 && errno == EINTR);
+        if (count <= 0) {
+            return (count < 0 ? -1 : 0);
+        }
+        rb.start = 0;
+        rb.end = count;
+        rb.want = (rb.want < READ_SIZE) ? rb.want * 2 : READ_SIZE;
+    }
+    *c = rb.data[rb.start++];
+    return (1);
+}
+
+
+/**
+ * read_input - Read up to a delimiter.
+ * @sb: Receives the bytes, backslash escapes kept unless raw.
+ * @delim: The delimiter.
+ * @max: Most characters to read, or -1 for no limit.
+ * @raw: Non-zero for read -r.
+ *
+ * Without -r a backslash-newline pair is dropped and a backslash keeps the
+ * next character (the delimiter too) from being special.
+ *
+ * Return: 0 if the delimiter or the limit was reached, 1 at end of input,
+ * -1 on error.
+ */
+static int read_input(string_buffer *sb, char delim, long max, int raw)
+{
+    long count = 0;
+    char c;
+    int got;
+
+    read_begin(STDIN_FILENO);
+    while (max < 0 || count < max) {
+        got = read_byte(STDIN_FILENO, &c);
+        if (got <= 0) {
+            return (got == 0 ? 1 : -1);
+        }
+        if (c == '\\' && !raw) {
+            got = read_byte(STDIN_FILENO, &c);
+            if (got <= 0) {
+                return (got == 0 ? 1 : -1);
+            }
+            if (c == '\n' || c == '\0') {
+                continue;
+            }
+            sbuf_addc(sb, '\\');
+        } else if (c == delim) {
+            return (0);
+        } else if (c == '\0') {
+            continue;
+        }
+        if (sbuf_addc(sb, c) != 0) {
+            return (-1);
+        }
+        count++;
+    }
+    return (0);
+}
+
+
+/**
+ * read_kind - Classify a character of the line for field splitting.
+ * @rl: The line.
+ * @i: Its position.
+ * @next: Receives the position after it (and after its escape).
+ *
+ * Return: READ_SPACE for IFS whitespace, READ_DELIM for other IFS
+ * characters, READ_PLAIN for the rest and for escaped characters.
+ */
+static int read_kind(const read_line *rl, size_t i, size_t *next)
+{
+    char c = rl->text[i];
+
+    *next = i + 1;
+    if (c == '\\' && !rl->raw) {
+        *next = i + 2;
+        return (READ_PLAIN);
+    }
+    if (strchr(rl->ifs, c) == NULL) {
+        return (READ_PLAIN);
+    }
+    return ((c == ' ' || c == '\t' || c == '\n') ? READ_SPACE : READ_DELIM);
+}
+
+
+/**
+ * read_skip - Skip a field separator: IFS whitespace around at most one
+ * other IFS character.
+ * @rl: The line.
+ * @i: Where the separator starts.
+ * @delims: How many non-whitespace IFS characters to allow (0 or 1).
+ *
+ * Return: The position after it.
+ */
+static size_t read_skip(const read_line *rl, size_t i, int delims)
+{
+    size_t next;
+    int kind;
+
+    while (i < rl->len) {
+        kind = read_kind(rl, i, &next);
+        if (kind == READ_PLAIN || (kind == READ_DELIM && delims-- == 0)) {
+            break;
+        }
+        i = next;
+    }
+    return (i);
+}
+
+
+/**
+ * read_field - Find the end of a field.
+ * @rl: The line.
+ * @i: Where the field starts.
+ *
+ * Return: The position of the first separator after it.
+ */
+static size_t read_field(const read_line *rl, size_t i)
+{
+    size_t next;
+
+    while (i < rl->len && read_kind(rl, i, &next) == READ_PLAIN) {
+        i = next;
+    }
+    return (i);
+}
+
+
+/**
+ * read_set - Assign part of the line to a variable, removing escapes.
+ * @rl: The line.
+ * @name: The variable.
+ * @start: First byte.
+ * @end: End of the part.
+ *
+ * Return: 0 on success, -1 on failure.
+ */
+static int read_set(const read_line *rl, const char *name, size_t start, size_t end)
+{
+    string_buffer value;
+    int status;
+
+    sbuf_init(&value);
+    sbuf_reserve(&value, end - start);
+    for (; start < end; start++) {
+        if (rl->text[start] == '\\' && !rl->raw) {
+            start++;
+        }
+        sbuf_addc(&value, rl->text[start]);
+    }
+    status = var_set(name, value.data != NULL ? value.data : "");
+    sbuf_free(&value);
+    return (status);
+}
+
+
+/**
+ * read_assign - Split a line among variables as POSIX describes.
+ * @rl: The line.
+ * @names: The variables.
+ *
+ * Each variable but the last gets one field. The last gets the rest of the
+ * line without its surrounding IFS whitespace; if that rest is a single
+ * field followed by a separator, it gets the field alone.
+ *
+ * Return: 0 on success, -1 on failure.
+ */
+static int read_assign(const read_line *rl, char **names)
+{
+    size_t i, end, last, next;
+    int status = 0;
+
+    i = read_skip(rl, 0, 0);
+    for (; names[1] != NULL; names++) {
+        end = read_field(rl, i);
+        status |= read_set(rl, names[0], i, end);
+        i = read_skip(rl, end, 1);
+    }
+    end = read_field(rl, i);
+    if (read_skip(rl, end, 1) < rl->len) {
+        /* Up to the last character that is not IFS whitespace */
+        for (end = i, last = i; last < rl->len; last = next) {
+            if (read_kind(rl, last, &next) != READ_SPACE) {
+                end = next;
+            }
+        }
+    }
+    return (status | read_set(rl, names[0], i, end));
+}
+
+
+/**
+ * read_options - Parse the options of read.
+ * @argv: Argument vector.
+ * @raw: Set for -r.
+ * @delim: Set by -d (the first character; NUL for an empty string).
+ * @max: Set by -n.
+ *
+ * Return: Index of the first variable name, or -1 after an error.
+ */
+static int read_options(char **argv, int *raw, char *delim, long *max)
+{
+    char *p, *value, *end;
+    int i;
+
+    for (i = 1; argv[i] != NULL && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        if (strcmp(argv[i], "--") == 0) {
+            return (i + 1);
+        }
+        for (p = argv[i] + 1; *p != '\0'; p++) {
+            if (*p == 'r') {
+                *raw = 1;
+                continue;
+            }
+            if (*p != 'd' && *p != 'n') {
+                shell_error("read: -%c: invalid option", *p);
+                return (-1);
+            }
+            value = (p[1] != '\0') ? p + 1 : argv[++i];
+            if (value == NULL) {
+                shell_error("read: -%c: option requires an argument", *p);
+                return (-1);
+            }
+            if (*p == 'd') {
+                *delim = value[0];
+            } else {
+                errno = 0;
+                *max = strtol(value, &end, 10);
+                if (*value == '\0' || *end != '\0' || *max < 0 || errno == ERANGE) {
+                    shell_error("read: %s: invalid number", value);
+                    return (-1);
+                }
+            }
+            break;
+        }
+    }
+    return (i);
+}
+
+
+/**
+ * builtin_read - Read a line into variables: read [-r] [-d delim] [-n N] [var...]
+ * @argv: Argument vector.
+ *
+ * The line is split at IFS characters; with no variable it is stored
+ * whole in REPLY.
+ *
+ * Return: 0 on success, 1 at end of input, 2 on a usage error.
+ */
+int builtin_read(char **argv)
+{
+    static char *reply[] = {"REPLY", NULL};
+    string_buffer sb;
+    read_line rl;
+    char delim = '\n', **names;
+    long max = -1;
+    int raw = 0, first, status, i;
+
+    first = read_options(argv, &raw, &delim, &max);
+    if (first < 0) {
+        return (2);
+    }
+    names = (argv[first] != NULL) ? argv + first : reply;
+    for (i = 0; names[i] != NULL; i++) {
+        if (!is_valid_name(names[i], strlen(names[i]))) {
+            shell_error("read: %s: bad variable name", names[i]);
+            return (2);
+        }
+    }
+    /* A prompt written by echo or printf must show before the wait */
+    out_flush();
+
+    sbuf_init(&sb);
+    status = read_input(&sb, delim, max, raw);
+    rl.text = (sb.data != NULL) ? sb.data : "";
+    rl.len = sb.len;
+    rl.raw = raw;
+    rl.ifs = var_lookup("IFS");
+    if (rl.ifs == NULL) {
+        rl.ifs = " \t\n";
+    }
+    if (names == reply) {
+        i = read_set(&rl, reply[0], 0, rl.len);
+    } else {
+        i = read_assign(&rl, names);
+    }
+    sbuf_free(&sb);
+    if (status < 0) {
+        shell_error("read: %s", strerror(errno));
+    }
+    return ((status != 0 || i != 0) ? (status < 0 ? 2 : 1) : 0);
+}
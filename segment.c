@@ -0,0 +1,438 @@
+#define _GNU_SOURCE
+#include "main.h"
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <time.h>
+
+extern char **environ;
+
+/**
+ * struct segment_state - Prompt segments computed by a background thread.
+ * @lock: Guards every field below.
+ * @wake: Signalled when a request is posted.
+ * @done: Signalled when a request has been answered.
+ * @started: Non-zero once the worker runs.
+ * @pending: Directory to examine next, or empty when there is no request.
+ * @env: Copy of the environment for that request (one allocation).
+ * @dir: Directory @git describes.
+ * @git: Branch and dirty mark of the repository holding @dir, or empty.
+ * @serial: Number of requests posted.
+ * @answered: Serial number of the last request answered.
+ * @pipe: Written once per answer, so the line editor wakes up to repaint;
+ * valid once @started is set.
+ * @reap: Held by the worker while git runs, so the shell does not collect
+ * git with its waitpid(-1) for background jobs.
+ * @owner: Process the worker runs in; forked copies of the shell have no
+ * worker.
+ */
+typedef struct segment_state
+{
+pthread_mutex_t lock;
+pthread_cond_t wake;
+pthread_cond_t done;
+int started;
+char pending[PATH_MAX];
+char **env;
+char dir[PATH_MAX];
+char git[256];
+unsigned long serial;
+unsigned long answered;
+int pipe[2];
+pthread_mutex_t reap;
+pid_t owner;
+} segment_state;
+
+/* All zeros, so the buffers stay out of the data segment */
+static segment_state seg = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    0, "", NULL, "", "", 0, 0, {0, 0}, PTHREAD_MUTEX_INITIALIZER, 0
+};
+
+
+/**
+ * env_copy - Copy the environment for use by the worker.
+ *
+ * The shell changes environ as variables are exported, so the worker
+ * never reads it directly.
+ *
+ * Return: A NULL terminated array in a single allocation, or NULL.
+ */
+static char **env_copy(void)
+{
+    size_t count, size = 0, i;
+    char **copy, *text;
+
+    for (count = 0; environ[count] != NULL; count++) {
+        size += strlen(environ[count]) + 1;
+    }
+    copy = malloc((count + 1) * sizeof(char *) + size);
+    if (copy == NULL) {
+        perror("malloc");
+        return (NULL);
+    }
+    text = (char *)(copy + count + 1);
+    for (i = 0; i < count; i++) {
+        copy[i] = text;
+        strcpy(text, environ[i]);
+        text += strlen(text) + 1;
+    }
+    copy[count] = NULL;
+    return (copy);
+}
+
+
+/**
+ * env_get - Look up a variable in an environment copy.
+ * @env: The environment.
+ * @name: The variable name.
+ *
+ * Return: Its value, or NULL.
+ */
+static const char *env_get(char **env, const char *name)
+{
+    size_t len = strlen(name);
+
+    for (; env != NULL && *env != NULL; env++) {
+        if (strncmp(*env, name, len) == 0 && (*env)[len] == '=') {
+            return (*env + len + 1);
+        }
+    }
+    return (NULL);
+}
+
+
+/**
+ * git_head - Read the branch checked out in a repository.
+ * @gitdir: The .git directory or file.
+ * @top: The directory holding it.
+ * @out: Where to store the branch, or a short commit id when detached.
+ * @size: Size of @out.
+ *
+ * Return: 0 on success, -1 if HEAD cannot be read.
+ */
+static int git_head(const char *gitdir, const char *top, char *out, size_t size)
+{
+    char path[PATH_MAX], text[PATH_MAX];
+    ssize_t count;
+    size_t len;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/HEAD", gitdir);
+    fd = open(gitdir, O_RDONLY | O_CLOEXEC);
+    count = (fd >= 0) ? read(fd, text, sizeof(text) - 1) : -1;
+    if (fd >= 0) {
+        close(fd);
+    }
+    /* A worktree or submodule has a .git file pointing at the real one */
+    if (count > 8 && strncmp(text, "gitdir: ", 8) == 0) {
+        text[count] = '\0';
+        text[strcspn(text, "\n")] = '\0';
+        if (text[8] == '/') {
+            snprintf(path, sizeof(path), "%s/HEAD", text + 8);
+        } else {
+            snprintf(path, sizeof(path), "%s/%s/HEAD", top, text + 8);
+        }
+    }
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return (-1);
+    }
+    count = read(fd, text, sizeof(text) - 1);
+    close(fd);
+    if (count <= 0) {
+        return (-1);
+    }
+    text[count] = '\0';
+    len = strcspn(text, "\n");
+    text[len] = '\0';
+    if (strncmp(text, "ref: refs/heads/", 16) == 0) {
+        snprintf(out, size, "%s", text + 16);
+    } else if (strncmp(text, "ref: ", 5) == 0) {
+        snprintf(out, size, "%s", text + 5);
+    } else {
+        snprintf(out, size, "%.7s", text);
+    }
+    return (0);
+}
+
+
+/**
+ * git_dirty - Check a work tree for uncommitted changes to tracked files.
+ * @dir: A directory of the work tree.
+ * @env: Environment for git.
+ *
+ * Runs git status in its own process group, so terminal signals meant for
+ * the shell's commands do not reach it.
+ *
+ * Return: 1 if there are changes, 0 if not or if git cannot tell.
+ */
+static int git_dirty(const char *dir, char **env)
+{
+    char *argv[] = {"git", "--no-optional-locks", "-C", NULL, "status", "--porcelain",
+                    "--untracked-files=no", "--ignore-submodules=dirty", NULL};
+    const char *path = env_get(env, "PATH"), *end;
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    char git[PATH_MAX], buffer[512];
+    sigset_t none;
+    pid_t pid = -1;
+    int out[2], dirty = 0;
+    ssize_t count;
+
+    git[0] = '\0';
+    for (; path != NULL && git[0] == '\0'; path = (*end == ':') ? end + 1 : NULL) {
+        end = path + strcspn(path, ":");
+        snprintf(git, sizeof(git), "%.*s/git", (int)(end - path), path);
+        if (access(git, X_OK) != 0) {
+            git[0] = '\0';
+        }
+    }
+    if (git[0] == '\0' || pipe2(out, O_CLOEXEC) != 0) {
+        return (0);
+    }
+    argv[3] = (char *)dir;
+    sigemptyset(&none);
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK);
+    posix_spawnattr_setpgroup(&attr, 0);
+    posix_spawnattr_setsigmask(&attr, &none);
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, out[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    pthread_mutex_lock(&seg.reap);
+    if (posix_spawn(&pid, git, &actions, &attr, argv, env) != 0) {
+        pid = -1;
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    close(out[1]);
+    while ((count = read(out[0], buffer, sizeof(buffer))) > 0 || (count < 0 && errno == EINTR)) {
+        dirty |= (count > 0);
+    }
+    close(out[0]);
+    if (pid > 0) {
+        waitpid(pid, NULL, 0);
+    }
+    pthread_mutex_unlock(&seg.reap);
+    return (dirty);
+}
+
+
+/**
+ * git_segment - Describe the git repository holding a directory.
+ * @dir: The directory.
+ * @env: Environment for git.
+ * @out: Where to store "branch", "branch*" when dirty, or "" outside a
+ * repository.
+ * @size: Size of @out.
+ */
+static void git_segment(const char *dir, char **env, char *out, size_t size)
+{
+    char top[PATH_MAX], gitdir[PATH_MAX + 8], branch[256], *slash;
+    struct stat st;
+
+    out[0] = '\0';
+    snprintf(top, sizeof(top), "%s", dir);
+    for (;;) {
+        snprintf(gitdir, sizeof(gitdir), "%s/.git", top);
+        if (stat(gitdir, &st) == 0) {
+            break;
+        }
+        slash = strrchr(top, '/');
+        if (slash == NULL || slash == top) {
+            return;
+        }
+        *slash = '\0';
+    }
+    if (git_head(gitdir, top, branch, sizeof(branch)) != 0) {
+        return;
+    }
+    snprintf(out, size, "%s%s", branch, git_dirty(dir, env) ? "*" : "");
+}
+
+
+/**
+ * segment_worker - Answer prompt segment requests, newest first.
+ * @arg: Unused.
+ *
+ * Return: Never returns.
+ */
+static void *segment_worker(void *arg)
+{
+    char dir[PATH_MAX], git[256];
+    unsigned long serial;
+    char **env;
+
+    (void)arg;
+    pthread_mutex_lock(&seg.lock);
+    for (;;) {
+        while (seg.pending[0] == '\0') {
+            pthread_cond_wait(&seg.wake, &seg.lock);
+        }
+        strcpy(dir, seg.pending);
+        env = seg.env;
+        serial = seg.serial;
+        seg.pending[0] = '\0';
+        seg.env = NULL;
+        pthread_mutex_unlock(&seg.lock);
+
+        git_segment(dir, env, git, sizeof(git));
+        free(env);
+
+        pthread_mutex_lock(&seg.lock);
+        strcpy(seg.dir, dir);
+        strcpy(seg.git, git);
+        seg.answered = serial;
+        pthread_cond_broadcast(&seg.done);
+        if (write(seg.pipe[1], "", 1) < 0) {
+            /* The pipe is full: a wakeup is already pending */
+        }
+    }
+    return (NULL);
+}
+
+
+/**
+ * segment_start - Start the worker thread.
+ *
+ * Return: 0 on success, -1 on error.
+ */
+static int segment_start(void)
+{
+    sigset_t all, saved;
+    pthread_t thread;
+    int failed;
+
+    if (pipe2(seg.pipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        return (-1);
+    }
+    /* Signals stay with the main thread */
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &saved);
+    failed = pthread_create(&thread, NULL, segment_worker, NULL);
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+    if (failed) {
+        close(seg.pipe[0]);
+        close(seg.pipe[1]);
+        return (-1);
+    }
+    pthread_detach(thread);
+    seg.owner = getpid();
+    seg.started = 1;
+    return (0);
+}
+
+
+/**
+ * segment_request - Ask for the segments of a directory to be computed.
+ * @dir: The directory.
+ *
+ * A request not yet picked up is replaced, so the worker never falls
+ * behind on directories the prompt no longer shows.
+ */
+void segment_request(const char *dir)
+{
+    char **env = env_copy();
+
+    pthread_mutex_lock(&seg.lock);
+    if (!seg.started && segment_start() != 0) {
+        pthread_mutex_unlock(&seg.lock);
+        free(env);
+        return;
+    }
+    snprintf(seg.pending, sizeof(seg.pending), "%s", dir);
+    free(seg.env);
+    seg.env = env;
+    seg.serial++;
+    pthread_cond_signal(&seg.wake);
+    pthread_mutex_unlock(&seg.lock);
+}
+
+
+/**
+ * segment_wait - Wait a bounded time for the latest request to be answered.
+ * @ms: The deadline, in milliseconds.
+ *
+ * Return: 1 if it was answered, 0 if the deadline passed first.
+ */
+int segment_wait(int ms)
+{
+    struct timespec deadline;
+    int answered;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += (long)ms * 1000000L;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+    deadline.tv_nsec %= 1000000000L;
+    pthread_mutex_lock(&seg.lock);
+    while (seg.started && seg.answered != seg.serial
+           && pthread_cond_timedwait(&seg.done, &seg.lock, &deadline) == 0) {
+    }
+    answered = seg.started && seg.answered == seg.serial;
+    pthread_mutex_unlock(&seg.lock);
+    return (answered);
+}
+
+
+/**
+ * segment_git - Get the latest git segment known for a directory.
+ * @dir: The directory.
+ * @out: Where to store it; empty if nothing is known for @dir yet.
+ * @size: Size of @out.
+ */
+void segment_git(const char *dir, char *out, size_t size)
+{
+    pthread_mutex_lock(&seg.lock);
+    snprintf(out, size, "%s", strcmp(seg.dir, dir) == 0 ? seg.git : "");
+    pthread_mutex_unlock(&seg.lock);
+}
+
+
+/**
+ * segment_fd - Descriptor that becomes readable when a segment changes.
+ *
+ * Return: The descriptor, or -1 before the worker is started.
+ */
+int segment_fd(void)
+{
+    return (seg.started ? seg.pipe[0] : -1);
+}
+
+
+/**
+ * segment_reap - Collect finished background jobs.
+ *
+ * While the worker has git running, collecting is left for the next call:
+ * waitpid(-1) could take git, and the worker's own waitpid would then be
+ * for a pid the system may already have given to another child.
+ */
+void segment_reap(void)
+{
+    int worker = seg.started && seg.owner == getpid();
+
+    if (worker && pthread_mutex_trylock(&seg.reap) != 0) {
+        return;
+    }
+    while (waitpid(-1, NULL, WNOHANG) > 0) {
+    }
+    if (worker) {
+        pthread_mutex_unlock(&seg.reap);
+    }
+}
+
+
+/**
+ * segment_drain - Consume the pending wakeups of segment_fd.
+ */
+void segment_drain(void)
+{
+    char buffer[64];
+
+    if (seg.started) {
+        while (read(seg.pipe[0], buffer, sizeof(buffer)) > 0) {
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include "main.h"
+#include <time.h>
 
 /**
  * is_interactive_mode - Check if the shell is running in interactive mode.
@@ -31,88 +32,209 @@ char *getUserName(void) {
 
 
 
+/* Prompt pieces are looked up once and the rendered prompt is reused */
+#define PROMPT_MAX 4608
+static char prompt_user[256];
+static char prompt_host[256];
+static char prompt_cwd[PROMPT_MAX - 600];
+static char prompt_line[PROMPT_MAX];
+static int prompt_length = -1;
+/* Segments shown in prompt_line: git branch and the last command's duration */
+static char prompt_git[256];
+static char prompt_took[32];
+static struct timespec prompt_started;
+
+/* How long the prompt waits for the git segment before showing it stale */
+#define PROMPT_DEADLINE_MS 20
+/* Commands running at least this long get their duration shown */
+#define PROMPT_SLOW_MS 2000
+
+
 /**
- * displayHostName - Display the hostname and working directory
+ * prompt_init - Look up the user and host names shown in the prompt.
+ *
+ * Done once, on the first prompt: getpwuid can be slow on NSS/LDAP hosts.
  */
-void displayHostName(void) {
-    /* Define the prompt string */
-    char hostname[1024]; /* Buffer to store the hostname */
-    char *pwd = get_environment("PWD"); /* Get the working directory */
-    int total_length;
-    char *output = NULL;
-    int color_code1, color_code2, color_code3;
-    /* Calculate the total length of the concatenated string */
-    int color_escape_length = 38; /* Length of ANSI escape codes for color */
-
-    /* Check if the shell is running in interactive mode */
-    if (isInteractiveMode()) {
-        if (gethostname(hostname, sizeof(hostname)) != 0) {
-            perror("gethostname");
-            exit(EXIT_FAILURE);
-        }
+static void prompt_init(void)
+{
+    struct passwd *pw = getpwuid(getuid());
+    const char *cwd = dir_logical();
 
-        total_length = stringlen(getUserName()) + stringlen(hostname) + stringlen(pwd) + color_escape_length;
-        /* ^^ 5 for other characters and null terminator */
-
-        /* Allocate memory for output */
-       output = (char *)malloc(total_length * sizeof(char));
-
-        if (output != NULL) {
-            color_code1 = rand() % 8 + 30; /* Generates a random color code between 30 and 37 */
-            color_code2 = rand() % 8 + 30; /* Generates a random color code between 30 and 37 */
-            color_code3 = rand() % 8 + 30; /* Generates a random color code between 30 and 37 */
-            /* Format and concatenate the strings with color escape sequences */
-            snprintf(output, total_length, "\033[1;%dm%s@%s\033[0m\033[1;%dm:\033[0m\033[1;%dm%s\033[0m$ ", color_code1, getUserName(), hostname, color_code2, color_code3, pwd);
-        } else {
-            /* Handle memory allocation failure */
-            perror("malloc");
-            exit(EXIT_FAILURE);
-        }
+    snprintf(prompt_user, sizeof(prompt_user), "%s",
+             pw != NULL ? pw->pw_name : (getenv("USER") ? getenv("USER") : "?"));
+    if (gethostname(prompt_host, sizeof(prompt_host)) != 0) {
+        strcpy(prompt_host, "localhost");
     }
+    prompt_host[sizeof(prompt_host) - 1] = '\0';
+    prompt_chdir(cwd != NULL ? cwd : "?");
+}
 
-    /* Write the concatenated string to stdout if in interactive mode */
-    if (output != NULL) {
-        write(STDOUT_FILENO, output, stringlen(output));
 
-        /* Free the allocated memory */
-        free(output);
-        free(pwd);
+/**
+ * prompt_chdir - Record the shell's new working directory for the prompt.
+ * @cwd: The directory.
+ */
+void prompt_chdir(const char *cwd)
+{
+    snprintf(prompt_cwd, sizeof(prompt_cwd), "%s", cwd);
+    prompt_length = -1;
+}
+
+
+/**
+ * prompt_command_start - Note that a command line was accepted, for the
+ * duration segment of the next prompt.
+ */
+void prompt_command_start(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &prompt_started);
+}
+
+
+/**
+ * prompt_duration - Format the time since the last command line was
+ * accepted, if it was long enough to be worth showing.
+ * @out: Where to store it, e.g. "3.2s" or "1m05s"; empty otherwise.
+ * @size: Size of @out.
+ */
+static void prompt_duration(char *out, size_t size)
+{
+    struct timespec now;
+    long ms;
+
+    out[0] = '\0';
+    if (prompt_started.tv_sec == 0 && prompt_started.tv_nsec == 0) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ms = (now.tv_sec - prompt_started.tv_sec) * 1000
+         + (now.tv_nsec - prompt_started.tv_nsec) / 1000000;
+    prompt_started.tv_sec = 0;
+    prompt_started.tv_nsec = 0;
+    if (ms < PROMPT_SLOW_MS) {
+        return;
+    }
+    if (ms < 60000) {
+        snprintf(out, size, "%ld.%lds", ms / 1000, ms % 1000 / 100);
+    } else {
+        snprintf(out, size, "%ldm%02lds", ms / 60000, ms % 60000 / 1000);
     }
 }
 
 
+/**
+ * prompt_format - Render prompt_line from its pieces.
+ */
+static void prompt_format(void)
+{
+    char git[sizeof(prompt_git) + 32], took[sizeof(prompt_took) + 32];
+
+    git[0] = '\0';
+    took[0] = '\0';
+    if (prompt_git[0] != '\0') {
+        sprintf(git, " \033[1;35m(%s)\033[0m", prompt_git);
+    }
+    if (prompt_took[0] != '\0') {
+        sprintf(took, " \033[33m%s\033[0m", prompt_took);
+    }
+    prompt_length = snprintf(prompt_line, sizeof(prompt_line),
+                             "\033[1;32m%s@%s\033[0m:\033[1;34m%s\033[0m%s%s$ ",
+                             prompt_user, prompt_host, prompt_cwd, git, took);
+    if (prompt_length >= (int)sizeof(prompt_line)) {
+        prompt_length = sizeof(prompt_line) - 1;
+    }
+}
 
 
 /**
- * Read input from stdin using getline.
- * @return The input string or NULL if nothing was read.
+ * prompt_render - Build the main prompt.
+ * @len: Where to store its length.
+ *
+ * The git segment is computed by a background worker. The prompt waits
+ * for it at most PROMPT_DEADLINE_MS and otherwise shows the last value
+ * known for this directory; prompt_update brings the late answer in.
+ * The prompt is rendered again only when one of its pieces changed.
+ *
+ * Return: The prompt, in a static buffer.
+ */
+const char *prompt_render(size_t *len)
+{
+    char git[sizeof(prompt_git)], took[sizeof(prompt_took)];
+
+    if (prompt_user[0] == '\0') {
+        prompt_init();
+    }
+    prompt_duration(took, sizeof(took));
+    segment_request(prompt_cwd);
+    segment_wait(PROMPT_DEADLINE_MS);
+    segment_git(prompt_cwd, git, sizeof(git));
+    if (prompt_length < 0 || strcmp(git, prompt_git) != 0 || strcmp(took, prompt_took) != 0) {
+        strcpy(prompt_git, git);
+        strcpy(prompt_took, took);
+        prompt_format();
+    }
+    *len = prompt_length;
+    return (prompt_line);
+}
+
+
+/**
+ * prompt_update - Take in segments that arrived after the prompt was shown.
+ * @len: Where to store the new prompt's length.
+ *
+ * Return: The prompt (the buffer prompt_render returns) if it changed,
+ * NULL otherwise.
+ */
+const char *prompt_update(size_t *len)
+{
+    char git[sizeof(prompt_git)];
+
+    segment_drain();
+    segment_git(prompt_cwd, git, sizeof(git));
+    if (prompt_length < 0 || strcmp(git, prompt_git) == 0) {
+        return (NULL);
+    }
+    strcpy(prompt_git, git);
+    prompt_format();
+    *len = prompt_length;
+    return (prompt_line);
+}
+
+
+/**
+ * displayHostName - Display the hostname and working directory
+ *
+ * The prompt comes from prompt_render, so this is a single write.
+ */
+void displayHostName(void) {
+    const char *prompt;
+    size_t len;
+
+    prompt = prompt_render(&len);
+    write(STDOUT_FILENO, prompt, len);
+}
+
+
+/**
+ * read_line_raw - Read one line from stdin, without any processing.
+ *
+ * Return: The line without its trailing newline, or NULL at end of input.
  */
-char *read_command() {
+char *read_line_raw(void) {
     char *input = NULL;
-    size_t len = 0, i;
+    size_t len = 0;
     ssize_t read;
-    /* write(STDOUT_FILENO, "Enter a command: ", 17); */
+
     read = getline(&input, &len, stdin);
     if (read == -1) {
         free(input);
-        if (isInteractiveMode()) {
-            handle_errno("EOF");
-        }
-        return(NULL);
+        return (NULL);
     }
 
     /* Removal of trailing newline character */
     if (read > 0 && input[read - 1] == '\n') {
         input[read - 1] = '\0';
     }
-
-    /* Remove comments */
-    for (i = 0; i < strlen(input); i++) {
-        if (input[i] == '#') {
-            input[i] = '\0'; /* Replace the '#' with null character to truncate the string */
-            break; /* Break from the loop since the comment symbol has been found */
-        }
-    }
     return (input);
 }
 
@@ -0,0 +1,190 @@
+#define _GNU_SOURCE
+#include "main.h"
+#include <time.h>
+
+/**
+ * startup_spawn - Run this shell once and time it until it exits.
+ * @argv: Arguments for the shell (argv[0] included).
+ * @tty: Non-zero to run it on a new pseudo-terminal, as an interactive
+ * shell, with "exit" already typed.
+ *
+ * Return: The elapsed time in milliseconds, or -1 on error.
+ */
+static double startup_spawn(char **argv, int tty)
+{
+    struct timespec start, end;
+    char buffer[4096];
+    int master = -1, slave, status;
+    pid_t pid;
+
+    if (tty) {
+        master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+        if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+            perror("posix_openpt");
+            return (-1);
+        }
+        write_all(master, "exit\n", 5);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pid = fork();
+    if (pid == 0) {
+        if (tty) {
+            setsid();
+            slave = open(ptsname(master), O_RDWR);
+            if (slave < 0) {
+                _exit(127);
+            }
+            dup2(slave, STDIN_FILENO);
+            dup2(slave, STDOUT_FILENO);
+            dup2(slave, STDERR_FILENO);
+        }
+        execv("/proc/self/exe", argv);
+        _exit(127);
+    }
+    if (pid == -1) {
+        perror("fork");
+        return (-1);
+    }
+    /* Keep the terminal drained so the shell never blocks on output */
+    while (tty && read(master, buffer, sizeof(buffer)) > 0) {
+    }
+    waitpid(pid, &status, 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (master >= 0) {
+        close(master);
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) == 127) {
+        return (-1);
+    }
+    return ((end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+}
+
+
+/**
+ * startup_compare - qsort comparison of two timings.
+ * @a: The first.
+ * @b: The second.
+ *
+ * Return: Negative, zero or positive.
+ */
+static int startup_compare(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return ((x > y) - (x < y));
+}
+
+
+/**
+ * startup_clear - Remove the files of a directory.
+ * @dir: The directory; it is kept, empty.
+ */
+static void startup_clear(const char *dir)
+{
+    struct dirent *de;
+    DIR *d = opendir(dir);
+
+    if (d == NULL) {
+        return;
+    }
+    while ((de = readdir(d)) != NULL) {
+        unlinkat(dirfd(d), de->d_name, 0);
+    }
+    closedir(d);
+}
+
+
+/**
+ * startup_mode - Time one way of starting the shell and print the result.
+ * @label: Name of the mode.
+ * @argv: Arguments for the shell.
+ * @tty: Non-zero for an interactive shell.
+ * @cold: Directory to empty before each run, or NULL.
+ * @times: Scratch space for @rounds timings.
+ * @rounds: Number of runs.
+ *
+ * Return: 0 on success, 1 if a run failed.
+ */
+static int startup_mode(const char *label, char **argv, int tty, const char *cold,
+                        double *times, int rounds)
+{
+    double total = 0;
+    int i;
+
+    for (i = 0; i < rounds; i++) {
+        if (cold != NULL) {
+            startup_clear(cold);
+        }
+        times[i] = startup_spawn(argv, tty);
+        if (times[i] < 0) {
+            shell_error("--startup-bench: %s run failed", label);
+            return (1);
+        }
+        total += times[i];
+    }
+    qsort(times, rounds, sizeof(double), startup_compare);
+    printf("%-12s %d runs, min %.3f ms, median %.3f ms, mean %.3f ms\n", label, rounds,
+           times[0], times[rounds / 2], total / rounds);
+    return (0);
+}
+
+
+/**
+ * startup_bench - Measure how long the shell takes from exec to running
+ * its first command: hsh --startup-bench [rounds]
+ * @rounds: Number of runs of each mode.
+ *
+ * Each run starts a fresh shell whose first command is exit, so the time
+ * to its exit is the startup latency plus process teardown. Modes: -c, a
+ * script file with an empty and with a filled compiled-script cache, and
+ * an interactive shell on a pseudo-terminal, which includes drawing the
+ * first prompt. The script, its cache and the history the interactive
+ * runs write (their "exit") live in a temporary directory that is
+ * removed at the end.
+ *
+ * Return: 0 on success, 1 on error.
+ */
+int startup_bench(int rounds)
+{
+    char dir[] = "/tmp/hsh-startup-XXXXXX", script[64], cache[64], history[64];
+    char *argv_c[] = {"hsh", "-c", "exit 0", NULL};
+    char *argv_script[] = {"hsh", NULL, NULL};
+    char *argv_tty[] = {"hsh", NULL};
+    double *times;
+    int fd = -1, failed;
+
+    if (rounds < 1) {
+        rounds = 1;
+    }
+    times = malloc(rounds * sizeof(double));
+    if (times != NULL && mkdtemp(dir) != NULL) {
+        sprintf(script, "%s/script", dir);
+        sprintf(cache, "%s/hsh", dir);
+        sprintf(history, "%s/history", dir);
+        fd = open(script, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    }
+    if (fd < 0) {
+        perror("--startup-bench");
+        free(times);
+        return (1);
+    }
+    write_all(fd, "exit 0\n", 7);
+    argv_script[1] = script;
+    close(fd);
+    /* Keep the runs' cache files and history out of the user's */
+    setenv("XDG_CACHE_HOME", dir, 1);
+    setenv("HISTFILE", history, 1);
+    fflush(stdout);
+
+    failed = startup_mode("-c", argv_c, 0, NULL, times, rounds)
+             || startup_mode("script cold", argv_script, 0, cache, times, rounds)
+             || startup_mode("script warm", argv_script, 0, NULL, times, rounds)
+             || startup_mode("interactive", argv_tty, 1, NULL, times, rounds);
+    startup_clear(cache);
+    rmdir(cache);
+    unlink(history);
+    unlink(script);
+    rmdir(dir);
+    free(times);
+    return (failed);
+}
@@ -0,0 +1,532 @@
+#include "main.h"
+#include <inttypes.h>
+
+/* Files whose status a chain of tests may look at together */
+#define TEST_CACHE 8
+
+/**
+ * struct test_stat - The cached status of one file.
+ * @path: The file name (malloc'd).
+ * @link: Non-zero for lstat, zero for stat.
+ * @error: 0, or the errno of the failed call.
+ * @st: The status.
+ * @asked: Access modes (R_OK, W_OK, X_OK) already checked.
+ * @granted: Those of @asked that were granted.
+ */
+typedef struct test_stat
+{
+char *path;
+int link;
+int error;
+struct stat st;
+int asked;
+int granted;
+} test_stat;
+
+/*
+ * Entries live until test_forget, which the interpreter calls before
+ * anything but another test of the same && / || list runs, so
+ * [ -f x ] && [ -r x ] stats x once and never sees a stale answer.
+ */
+static test_stat test_cache[TEST_CACHE];
+static int test_cached, test_next;
+
+/**
+ * struct test_state - A test expression being evaluated.
+ * @name: "test" or "[", for messages.
+ * @argv: The next argument.
+ * @end: One past the last argument.
+ * @error: Set when the expression is malformed.
+ */
+typedef struct test_state
+{
+const char *name;
+char **argv;
+char **end;
+int error;
+} test_state;
+
+static int test_or(test_state *ts);
+
+
+/**
+ * test_forget - Drop every cached file status.
+ */
+void test_forget(void)
+{
+    while (test_cached > 0) {
+        free(test_cache[--test_cached].path);
+    }
+    test_next = 0;
+}
+
+
+/**
+ * test_lookup - Get the status of a file, from the cache if possible.
+ * @path: The file.
+ * @link: Non-zero to not follow a final symbolic link.
+ *
+ * Return: The entry; its error field tells whether the file exists.
+ */
+static test_stat *test_lookup(const char *path, int link)
+{
+    static test_stat uncached;
+    test_stat *entry;
+    int i;
+
+    for (i = 0; i < test_cached; i++) {
+        if (test_cache[i].link == link && strcmp(test_cache[i].path, path) == 0) {
+            return (&test_cache[i]);
+        }
+    }
+    if (test_cached < TEST_CACHE) {
+        entry = &test_cache[test_cached++];
+    } else {
+        entry = &test_cache[test_next];
+        test_next = (test_next + 1) % TEST_CACHE;
+        free(entry->path);
+    }
+    entry->path = strdup(path);
+    if (entry->path == NULL) {
+        /* Answer without caching */
+        test_cached--;
+        entry = &uncached;
+    }
+    entry->link = link;
+    entry->asked = 0;
+    entry->granted = 0;
+    entry->error = ((link ? lstat(path, &entry->st) : stat(path, &entry->st)) == 0) ? 0 : errno;
+    return (entry);
+}
+
+
+/**
+ * test_access - Check whether the shell may read, write or run a file.
+ * @path: The file.
+ * @mode: R_OK, W_OK or X_OK.
+ *
+ * A file the cache knows to be missing costs no system call. Otherwise
+ * access is asked with the effective IDs, which honours ACLs and
+ * read-only mounts, and the answer is cached too.
+ *
+ * Return: 1 if allowed, 0 otherwise.
+ */
+static int test_access(const char *path, int mode)
+{
+    test_stat *entry = test_lookup(path, 0);
+
+    if (entry->error != 0) {
+        return (0);
+    }
+    if (!(entry->asked & mode)) {
+        entry->asked |= mode;
+        if (faccessat(AT_FDCWD, path, mode, AT_EACCESS) == 0) {
+            entry->granted |= mode;
+        }
+    }
+    return ((entry->granted & mode) != 0);
+}
+
+
+/**
+ * test_number - Convert an integer operand.
+ * @ts: The expression, flagged on error.
+ * @text: The operand.
+ *
+ * Return: Its value (0 if invalid).
+ */
+static intmax_t test_number(test_state *ts, const char *text)
+{
+    const char *p = text;
+    char *end;
+    intmax_t value;
+
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    errno = 0;
+    value = strtoimax(p, &end, 10);
+    while (end != p && (*end == ' ' || *end == '\t')) {
+        end++;
+    }
+    if (end == p || *end != '\0' || errno == ERANGE) {
+        if (!ts->error) {
+            shell_error("%s: Illegal number: %s", ts->name, text);
+        }
+        ts->error = 1;
+        return (0);
+    }
+    return (value);
+}
+
+
+/**
+ * test_is_unary - Check for a unary operator such as -f or -z.
+ * @arg: The argument.
+ *
+ * Return: 1 if it is one.
+ */
+static int test_is_unary(const char *arg)
+{
+    return (arg[0] == '-' && arg[1] != '\0' && arg[2] == '\0'
+            && strchr("bcdefghknprsStuwxzGLO", arg[1]) != NULL);
+}
+
+
+/**
+ * test_is_binary - Check for a binary operator such as = or -lt.
+ * @arg: The argument.
+ *
+ * Return: 1 if it is one.
+ */
+static int test_is_binary(const char *arg)
+{
+    static const char *const ops[] = {
+        "=", "==", "!=", "<", ">", "-eq", "-ne", "-lt", "-le", "-gt", "-ge",
+        "-nt", "-ot", "-ef", NULL
+    };
+    int i;
+
+    for (i = 0; ops[i] != NULL; i++) {
+        if (strcmp(arg, ops[i]) == 0) {
+            return (1);
+        }
+    }
+    return (0);
+}
+
+
+/**
+ * test_unary - Evaluate a unary operator.
+ * @ts: The expression.
+ * @op: The operator.
+ * @arg: Its operand.
+ *
+ * Return: 1 if true, 0 if false.
+ */
+static int test_unary(test_state *ts, const char *op, const char *arg)
+{
+    test_stat *entry;
+    mode_t mode;
+
+    switch (op[1]) {
+    case 'n':
+        return (arg[0] != '\0');
+    case 'z':
+        return (arg[0] == '\0');
+    case 't':
+        return (isatty((int)test_number(ts, arg)));
+    case 'r':
+        return (test_access(arg, R_OK));
+    case 'w':
+        return (test_access(arg, W_OK));
+    case 'x':
+        return (test_access(arg, X_OK));
+    }
+    entry = test_lookup(arg, op[1] == 'h' || op[1] == 'L');
+    if (entry->error != 0) {
+        return (0);
+    }
+    mode = entry->st.st_mode;
+    switch (op[1]) {
+    case 'b':
+        return (S_ISBLK(mode));
+    case 'c':
+        return (S_ISCHR(mode));
+    case 'd':
+        return (S_ISDIR(mode));
+    case 'f':
+        return (S_ISREG(mode));
+    case 'g':
+        return ((mode & S_ISGID) != 0);
+    case 'h':
+    case 'L':
+        return (S_ISLNK(mode));
+    case 'k':
+        return ((mode & S_ISVTX) != 0);
+    case 'p':
+        return (S_ISFIFO(mode));
+    case 's':
+        return (entry->st.st_size > 0);
+    case 'S':
+        return (S_ISSOCK(mode));
+    case 'u':
+        return ((mode & S_ISUID) != 0);
+    case 'G':
+        return (entry->st.st_gid == getegid());
+    case 'O':
+        return (entry->st.st_uid == geteuid());
+    }
+    /* -e */
+    return (1);
+}
+
+
+/**
+ * test_newer - Compare the modification times of two files (-nt).
+ * @a: The first file.
+ * @b: The second file.
+ *
+ * Return: 1 if @a exists and @b does not or is older, 0 otherwise.
+ */
+static int test_newer(const char *a, const char *b)
+{
+    test_stat *first = test_lookup(a, 0), *second = test_lookup(b, 0);
+
+    if (first->error != 0) {
+        return (0);
+    }
+    if (second->error != 0) {
+        return (1);
+    }
+    if (first->st.st_mtim.tv_sec != second->st.st_mtim.tv_sec) {
+        return (first->st.st_mtim.tv_sec > second->st.st_mtim.tv_sec);
+    }
+    return (first->st.st_mtim.tv_nsec > second->st.st_mtim.tv_nsec);
+}
+
+
+/**
+ * test_binary - Evaluate a binary operator.
+ * @ts: The expression.
+ * @left: The left operand.
+ * @op: The operator.
+ * @right: The right operand.
+ *
+ * Return: 1 if true, 0 if false.
+ */
+static int test_binary(test_state *ts, const char *left, const char *op, const char *right)
+{
+    test_stat *a, *b;
+    intmax_t x, y;
+
+    if (op[0] != '-') {
+        if (op[0] == '<' || op[0] == '>') {
+            return ((strcmp(left, right) < 0) == (op[0] == '<') && strcmp(left, right) != 0);
+        }
+        return ((strcmp(left, right) == 0) == (op[0] != '!'));
+    }
+    if (strcmp(op, "-nt") == 0) {
+        return (test_newer(left, right));
+    }
+    if (strcmp(op, "-ot") == 0) {
+        return (test_newer(right, left));
+    }
+    if (strcmp(op, "-ef") == 0) {
+        a = test_lookup(left, 0);
+        b = test_lookup(right, 0);
+        return (a->error == 0 && b->error == 0 && a->st.st_dev == b->st.st_dev
+                && a->st.st_ino == b->st.st_ino);
+    }
+    x = test_number(ts, left);
+    y = test_number(ts, right);
+    switch (op[1] * 256 + op[2]) {
+    case 'e' * 256 + 'q':
+        return (x == y);
+    case 'n' * 256 + 'e':
+        return (x != y);
+    case 'l' * 256 + 't':
+        return (x < y);
+    case 'l' * 256 + 'e':
+        return (x <= y);
+    case 'g' * 256 + 't':
+        return (x > y);
+    }
+    return (x >= y);
+}
+
+
+/**
+ * test_syntax - Report a malformed expression.
+ * @ts: The expression.
+ * @arg: The offending argument, or NULL if one is missing.
+ *
+ * Return: 0.
+ */
+static int test_syntax(test_state *ts, const char *arg)
+{
+    if (!ts->error) {
+        if (arg != NULL) {
+            shell_error("%s: %s: unexpected operator", ts->name, arg);
+        } else {
+            shell_error("%s: argument expected", ts->name);
+        }
+    }
+    ts->error = 1;
+    return (0);
+}
+
+
+/**
+ * test_primary - Evaluate a parenthesised expression or a single test.
+ * @ts: The expression.
+ *
+ * Return: 1 if true, 0 if false.
+ */
+static int test_primary(test_state *ts)
+{
+    char **argv = ts->argv;
+    int left = ts->end - argv, result;
+
+    if (left <= 0) {
+        return (test_syntax(ts, NULL));
+    }
+    if (strcmp(argv[0], "(") == 0 && left >= 2) {
+        ts->argv++;
+        result = test_or(ts);
+        if (ts->argv >= ts->end || strcmp(ts->argv[0], ")") != 0) {
+            return (test_syntax(ts, ts->argv < ts->end ? ts->argv[0] : NULL));
+        }
+        ts->argv++;
+        return (result);
+    }
+    if (left >= 3 && test_is_binary(argv[1])) {
+        ts->argv += 3;
+        return (test_binary(ts, argv[0], argv[1], argv[2]));
+    }
+    if (left >= 2 && test_is_unary(argv[0])) {
+        ts->argv += 2;
+        return (test_unary(ts, argv[0], argv[1]));
+    }
+    ts->argv++;
+    return (argv[0][0] != '\0');
+}
+
+
+/**
+ * test_not - Evaluate an expression with any leading ! operators.
+ * @ts: The expression.
+ *
+ * Return: 1 if true, 0 if false.
+ */
+static int test_not(test_state *ts)
+{
+    if (ts->argv < ts->end && ts->end - ts->argv > 1 && strcmp(ts->argv[0], "!") == 0) {
+        ts->argv++;
+        return (!test_not(ts));
+    }
+    return (test_primary(ts));
+}
+
+
+/**
+ * test_and - Evaluate expressions joined by -a.
+ * @ts: The expression.
+ *
+ * Return: 1 if true, 0 if false.
+ */
+static int test_and(test_state *ts)
+{
+    int result = test_not(ts);
+
+    while (ts->argv < ts->end && strcmp(ts->argv[0], "-a") == 0) {
+        ts->argv++;
+        result = test_not(ts) && result;
+    }
+    return (result);
+}
+
+
+/**
+ * test_or - Evaluate expressions joined by -o.
+ * @ts: The expression.
+ *
+ * Return: 1 if true, 0 if false.
+ */
+static int test_or(test_state *ts)
+{
+    int result = test_and(ts);
+
+    while (ts->argv < ts->end && strcmp(ts->argv[0], "-o") == 0) {
+        ts->argv++;
+        result = test_and(ts) || result;
+    }
+    return (result);
+}
+
+
+/**
+ * test_posix - Evaluate an expression of up to four arguments by the
+ * POSIX rules, which settle cases like [ "$a" = -f ] by argument count.
+ * @ts: The expression.
+ * @count: Number of arguments.
+ *
+ * Return: 1 if true, 0 if false.
+ */
+static int test_posix(test_state *ts, int count)
+{
+    char **argv = ts->argv;
+
+    ts->argv = ts->end;
+    switch (count) {
+    case 0:
+        return (0);
+    case 1:
+        return (argv[0][0] != '\0');
+    case 2:
+        if (strcmp(argv[0], "!") == 0) {
+            return (argv[1][0] == '\0');
+        }
+        if (test_is_unary(argv[0])) {
+            return (test_unary(ts, argv[0], argv[1]));
+        }
+        return (test_syntax(ts, argv[0]));
+    case 3:
+        if (test_is_binary(argv[1])) {
+            return (test_binary(ts, argv[0], argv[1], argv[2]));
+        }
+        if (strcmp(argv[0], "!") == 0) {
+            ts->argv = argv + 1;
+            return (!test_posix(ts, 2));
+        }
+        if (strcmp(argv[0], "(") == 0 && strcmp(argv[2], ")") == 0) {
+            return (argv[1][0] != '\0');
+        }
+        break;
+    case 4:
+        if (strcmp(argv[0], "!") == 0) {
+            ts->argv = argv + 1;
+            return (!test_posix(ts, 3));
+        }
+        if (strcmp(argv[0], "(") == 0 && strcmp(argv[3], ")") == 0) {
+            ts->argv = argv + 1;
+            ts->end = argv + 3;
+            return (test_posix(ts, 2));
+        }
+        break;
+    }
+    ts->argv = argv;
+    return (test_or(ts));
+}
+
+
+/**
+ * builtin_test - Evaluate a condition: test expr, or [ expr ]
+ * @argv: Argument vector.
+ *
+ * Return: 0 if the expression is true, 1 if false, 2 on error.
+ */
+int builtin_test(char **argv)
+{
+    test_state ts;
+    int count, result;
+
+    for (count = 0; argv[count + 1] != NULL; count++) {
+    }
+    ts.name = argv[0];
+    ts.argv = argv + 1;
+    ts.error = 0;
+    if (strcmp(argv[0], "[") == 0) {
+        if (count == 0 || strcmp(argv[count], "]") != 0) {
+            shell_error("[: missing ]");
+            return (2);
+        }
+        count--;
+    }
+    ts.end = ts.argv + count;
+    result = test_posix(&ts, count);
+    if (!ts.error && ts.argv < ts.end) {
+        test_syntax(&ts, ts.argv[0]);
+    }
+    return (ts.error ? 2 : !result);
+}
@@ -0,0 +1,230 @@
+/*
+ * builtin_hash - Regenerate the perfect hash of the builtin table.
+ *
+ * Usage (from the top of the tree, after editing builtin_table):
+ *
+ *     gcc -Wall -Wextra -pedantic -std=gnu89 tools/builtin_hash.c -o builtin_hash
+ *     ./builtin_hash builtin.c && rm builtin_hash
+ *
+ * The names are read from the builtin_table initializer of builtin.c, one
+ * {"name", handler, special} entry per line. A seed is searched for that
+ * sends every name to its own slot, and the code between the "Generated
+ * by tools/builtin_hash.c" and "End of generated code" comments of
+ * builtin.c is replaced with the seed, the slot table and a hash of the
+ * names in table order, which the shell checks against its table.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_NAMES 250
+#define MAX_BITS 10
+#define MAX_SEEDS 1000000
+
+#define BEGIN_MARK "/* Generated by tools/builtin_hash.c"
+#define END_MARK "/* End of generated code */"
+
+
+/**
+ * hash - The hash of builtin.c (builtin_hash); the two must agree.
+ * @name: The command name.
+ * @seed: Starting value.
+ * @bits: log2 of the number of slots.
+ *
+ * Return: The slot.
+ */
+static unsigned int hash(const char *name, unsigned int seed, int bits)
+{
+    unsigned int h = seed;
+
+    while (*name != '\0') {
+        h = (h ^ (unsigned char)*name++) * 16777619u;
+    }
+    return ((h ^ (h >> 15)) & ((1u << bits) - 1));
+}
+
+
+/**
+ * names_hash - Hash the names in table order, as builtin_names_hash of
+ * builtin.c does; the two must agree.
+ * @names: The names.
+ * @count: Their number.
+ *
+ * Return: FNV-1a of the names, each with its terminating NUL.
+ */
+static unsigned int names_hash(char **names, int count)
+{
+    unsigned int h = 2166136261u;
+    const char *p;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        p = names[i];
+        do {
+            h = (h ^ (unsigned char)*p) * 16777619u;
+        } while (*p++ != '\0');
+    }
+    return (h);
+}
+
+
+/**
+ * read_file - Read a whole file.
+ * @path: The file.
+ *
+ * Return: Its contents, NUL terminated (malloc'd), or NULL.
+ */
+static char *read_file(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    char *text;
+    long size;
+
+    if (file == NULL || fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0) {
+        perror(path);
+        return (NULL);
+    }
+    rewind(file);
+    text = malloc(size + 1);
+    if (text == NULL || fread(text, 1, size, file) != (size_t)size) {
+        perror(path);
+        free(text);
+        fclose(file);
+        return (NULL);
+    }
+    text[size] = '\0';
+    fclose(file);
+    return (text);
+}
+
+
+/**
+ * table_names - Collect the names of builtin_table.
+ * @text: The source of builtin.c; the names are NUL terminated in place.
+ * @names: Receives them.
+ *
+ * Return: Their number, or -1 if the table was not found.
+ */
+static int table_names(char *text, char **names)
+{
+    char *line = strstr(text, "builtin_table[] = {"), *end;
+    int count = 0;
+
+    if (line == NULL) {
+        return (-1);
+    }
+    while ((line = strchr(line, '\n')) != NULL) {
+        line += strspn(line, "\n \t");
+        if (strncmp(line, "{NULL", 5) == 0 || strncmp(line, "{\"", 2) != 0) {
+            break;
+        }
+        end = strchr(line + 2, '"');
+        if (end == NULL || count == MAX_NAMES) {
+            return (-1);
+        }
+        *end = '\0';
+        names[count++] = line + 2;
+        line = end + 1;
+    }
+    return (count);
+}
+
+
+/**
+ * find_seed - Search for a seed without collisions.
+ * @names: The names.
+ * @count: Their number.
+ * @bits: log2 of the number of slots.
+ * @slots: Receives, per slot, the table index + 1 of its name (0: empty).
+ *
+ * Return: The seed, or 0 if none was found.
+ */
+static unsigned int find_seed(char **names, int count, int bits, unsigned char *slots)
+{
+    unsigned int seed, slot;
+    int i;
+
+    for (seed = 2166136261u; seed != 2166136261u + MAX_SEEDS; seed++) {
+        memset(slots, 0, 1u << bits);
+        for (i = 0; i < count; i++) {
+            slot = hash(names[i], seed, bits);
+            if (slots[slot] != 0) {
+                break;
+            }
+            slots[slot] = (unsigned char)(i + 1);
+        }
+        if (i == count) {
+            return (seed);
+        }
+    }
+    return (0);
+}
+
+
+/**
+ * main - Rewrite the generated part of builtin.c.
+ * @argc: Argument count.
+ * @argv: argv[1] is the path of builtin.c.
+ *
+ * Return: 0 on success, 1 on error.
+ */
+int main(int argc, char **argv)
+{
+    char *text, *copy, *names[MAX_NAMES], *begin, *end;
+    unsigned char slots[1 << MAX_BITS];
+    unsigned int seed = 0, i;
+    int count, bits;
+    FILE *out;
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s builtin.c\n", argv[0]);
+        return (1);
+    }
+    text = read_file(argv[1]);
+    copy = (text != NULL) ? malloc(strlen(text) + 1) : NULL;
+    if (copy == NULL) {
+        return (1);
+    }
+    strcpy(copy, text);
+    count = table_names(copy, names);
+    begin = strstr(text, BEGIN_MARK);
+    end = (begin != NULL) ? strstr(begin, END_MARK) : NULL;
+    if (count <= 0 || end == NULL) {
+        fprintf(stderr, "%s: builtin_table or the generated block not found\n", argv[1]);
+        return (1);
+    }
+
+    /* At least twice as many slots as names keeps the search short */
+    for (bits = 1; (1 << bits) < 2 * count; bits++) {
+    }
+    for (; bits <= MAX_BITS && (seed = find_seed(names, count, bits, slots)) == 0; bits++) {
+    }
+    if (seed == 0) {
+        fprintf(stderr, "no perfect hash found for %d names\n", count);
+        return (1);
+    }
+
+    out = fopen(argv[1], "wb");
+    if (out == NULL) {
+        perror(argv[1]);
+        return (1);
+    }
+    fwrite(text, 1, begin - text, out);
+    fprintf(out, "%s from builtin_table; do not edit */\n", BEGIN_MARK);
+    fprintf(out, "#define BUILTIN_COUNT %d\n", count);
+    fprintf(out, "#define BUILTIN_HASH_SEED %uu\n", seed);
+    fprintf(out, "#define BUILTIN_HASH_BITS %d\n", bits);
+    fprintf(out, "#define BUILTIN_NAMES_HASH %uu\n", names_hash(names, count));
+    fprintf(out, "static const unsigned char builtin_slots[%d] = {", 1 << bits);
+    for (i = 0; i < (1u << bits); i++) {
+        fprintf(out, "%s%d%s", (i % 16 == 0) ? "\n    " : " ", slots[i],
+                (i + 1 < (1u << bits)) ? "," : "\n");
+    }
+    fprintf(out, "};\n%s", end);
+    if (fclose(out) != 0) {
+        perror(argv[1]);
+        return (1);
+    }
+    printf("%d builtins, %d slots, seed %u\n", count, 1 << bits, seed);
+    return (0);
+}
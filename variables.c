@@ -0,0 +1,394 @@
+#include "main.h"
+
+#define VAR_BUCKETS 128
+
+/* Shell variables that are not (yet) part of the environment */
+static shell_var *var_table[VAR_BUCKETS];
+
+/* Exit status of the most recently executed command, exposed as $? */
+int last_exit_status = 0;
+
+/* Positional parameters $1, $2, ... of the running script or function */
+char **positional_params = NULL;
+int positional_count = 0;
+
+/**
+ * struct saved_var - Value a local variable hides until its function returns.
+ * @name: The variable name.
+ * @value: The hidden value, or NULL if the variable was unset.
+ * @exported: Non-zero if the hidden value lived in the environment.
+ * @next: Next saved variable of the same scope.
+ */
+typedef struct saved_var
+{
+char *name;
+char *value;
+int exported;
+struct saved_var *next;
+} saved_var;
+
+/**
+ * struct var_scope - Variables made local by one function invocation.
+ * @saved: Hidden outer values, restored when the scope is popped.
+ * @parent: Scope of the calling function.
+ */
+typedef struct var_scope
+{
+saved_var *saved;
+struct var_scope *parent;
+} var_scope;
+
+/* Innermost function scope, NULL outside functions */
+static var_scope *current_scope;
+
+
+/**
+ * var_hash - Hash a variable name (FNV-1a).
+ * @name: The name to hash.
+ * @len: Number of bytes of @name to use.
+ *
+ * Return: The bucket index for @name.
+ */
+static unsigned int var_hash(const char *name, size_t len)
+{
+    unsigned int hash = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return (hash % VAR_BUCKETS);
+}
+
+
+/**
+ * is_valid_name - Check that a string is a valid shell variable name.
+ * @name: The candidate name.
+ * @len: Length of the candidate name.
+ *
+ * Return: 1 if @name is [A-Za-z_][A-Za-z0-9_]*, 0 otherwise.
+ */
+int is_valid_name(const char *name, size_t len)
+{
+    size_t i;
+
+    if (name == NULL || len == 0 || isdigit((unsigned char)name[0])) {
+        return (0);
+    }
+    for (i = 0; i < len; i++) {
+        if (!isalnum((unsigned char)name[i]) && name[i] != '_') {
+            return (0);
+        }
+    }
+    return (1);
+}
+
+
+/**
+ * var_find - Find a shell variable in the store.
+ * @name: The variable name.
+ * @len: Length of the name.
+ *
+ * Return: The variable, or NULL if it is not in the store.
+ */
+static shell_var *var_find(const char *name, size_t len)
+{
+    shell_var *var;
+
+    for (var = var_table[var_hash(name, len)]; var != NULL; var = var->next) {
+        if (strncmp(var->name, name, len) == 0 && var->name[len] == '\0') {
+            return (var);
+        }
+    }
+    return (NULL);
+}
+
+
+/**
+ * var_lookup_n - Look up a variable by a name that is not NUL terminated.
+ * @name: Start of the name.
+ * @len: Length of the name.
+ *
+ * The shell store is consulted first, then the environment.
+ *
+ * Return: The value (owned by the store/environment), or NULL if unset.
+ */
+char *var_lookup_n(const char *name, size_t len)
+{
+    shell_var *var = var_find(name, len);
+    size_t i;
+
+    if (var != NULL) {
+        return (var->value);
+    }
+    for (i = 0; environ[i] != NULL; i++) {
+        if (strncmp(environ[i], name, len) == 0 && environ[i][len] == '=') {
+            return (environ[i] + len + 1);
+        }
+    }
+    return (NULL);
+}
+
+
+/**
+ * var_lookup - Look up the value of a shell or environment variable.
+ * @name: The variable name.
+ *
+ * Return: The value (not to be freed), or NULL if the variable is unset.
+ */
+char *var_lookup(const char *name)
+{
+    return (var_lookup_n(name, strlen(name)));
+}
+
+
+/**
+ * var_set - Assign a value to a variable.
+ * @name: The variable name.
+ * @value: The new value.
+ *
+ * Variables that already live in the environment stay exported and are
+ * updated in place; anything else is kept in the shell's own store so it
+ * is not passed on to child processes.
+ *
+ * Return: 0 on success, -1 on an invalid name or allocation failure.
+ */
+int var_set(const char *name, const char *value)
+{
+    size_t len = strlen(name);
+    unsigned int bucket;
+    shell_var *var;
+    char *copy;
+
+    if (!is_valid_name(name, len)) {
+        return (-1);
+    }
+    if (value == NULL) {
+        value = "";
+    }
+
+    var = var_find(name, len);
+    if (var == NULL && getenv(name) != NULL) {
+        return (setenv(name, value, 1));
+    }
+
+    copy = stringdup(value);
+    if (copy == NULL) {
+        perror("malloc");
+        return (-1);
+    }
+    if (var != NULL) {
+        free(var->value);
+        var->value = copy;
+        return (0);
+    }
+
+    var = malloc(sizeof(*var));
+    if (var == NULL || (var->name = stringdup(name)) == NULL) {
+        perror("malloc");
+        free(var);
+        free(copy);
+        return (-1);
+    }
+    var->value = copy;
+    var->flags = 0;
+    bucket = var_hash(name, len);
+    var->next = var_table[bucket];
+    var_table[bucket] = var;
+    return (0);
+}
+
+
+/**
+ * var_set_number - Assign an integer value to a variable.
+ * @name: The variable name.
+ * @number: The value to store.
+ *
+ * Return: 0 on success, -1 on failure.
+ */
+int var_set_number(const char *name, long number)
+{
+    char digits[32];
+
+    snprintf(digits, sizeof(digits), "%ld", number);
+    return (var_set(name, digits));
+}
+
+
+/**
+ * var_remove - Remove a variable from the shell's own store.
+ * @name: The variable name.
+ */
+static void var_remove(const char *name)
+{
+    size_t len = strlen(name);
+    shell_var **link = &var_table[var_hash(name, len)];
+    shell_var *var;
+
+    while ((var = *link) != NULL) {
+        if (stringcmp(var->name, name) == 0) {
+            *link = var->next;
+            free(var->name);
+            free(var->value);
+            free(var);
+            break;
+        }
+        link = &var->next;
+    }
+}
+
+
+/**
+ * var_unset - Remove a variable from the store and the environment.
+ * @name: The variable name.
+ */
+void var_unset(const char *name)
+{
+    var_remove(name);
+    unsetenv(name);
+}
+
+
+/**
+ * var_export - Move a variable into the environment of child processes.
+ * @name: The variable name.
+ * @value: New value, or NULL to export the current one.
+ *
+ * Return: 0 on success, -1 on an invalid name or failure.
+ */
+int var_export(const char *name, const char *value)
+{
+    if (!is_valid_name(name, strlen(name))) {
+        return (-1);
+    }
+    if (value == NULL) {
+        value = var_lookup(name);
+        if (value == NULL) {
+            return (0);
+        }
+    }
+    if (setenv(name, value, 1) != 0) {
+        return (-1);
+    }
+    var_remove(name);
+    return (0);
+}
+
+
+/**
+ * is_assignment - Check whether a word has the form NAME=value.
+ * @word: The word to check.
+ *
+ * Return: 1 if @word is an assignment, 0 otherwise.
+ */
+int is_assignment(const char *word)
+{
+    const char *equal = strchr(word, '=');
+
+    return (equal != NULL && is_valid_name(word, equal - word));
+}
+
+
+/**
+ * var_assign - Perform a NAME=value assignment.
+ * @word: The assignment word.
+ *
+ * Return: 0 on success, -1 on failure.
+ */
+int var_assign(const char *word)
+{
+    const char *equal = strchr(word, '=');
+    char name[256];
+    size_t len;
+
+    if (equal == NULL || (len = equal - word) >= sizeof(name)) {
+        return (-1);
+    }
+    memcpy(name, word, len);
+    name[len] = '\0';
+    return (var_set(name, equal + 1));
+}
+
+
+/**
+ * var_scope_push - Open the variable scope of a function invocation.
+ */
+void var_scope_push(void)
+{
+    var_scope *scope = malloc(sizeof(*scope));
+
+    if (scope == NULL) {
+        perror("malloc");
+        exit(2);
+    }
+    scope->saved = NULL;
+    scope->parent = current_scope;
+    current_scope = scope;
+}
+
+
+/**
+ * var_scope_pop - Close the innermost scope, restoring hidden variables.
+ */
+void var_scope_pop(void)
+{
+    var_scope *scope = current_scope;
+    saved_var *var, *next;
+
+    if (scope == NULL) {
+        return;
+    }
+    for (var = scope->saved; var != NULL; var = next) {
+        next = var->next;
+        var_unset(var->name);
+        if (var->value != NULL && var->exported) {
+            setenv(var->name, var->value, 1);
+        } else if (var->value != NULL) {
+            var_set(var->name, var->value);
+        }
+        free(var->name);
+        free(var->value);
+        free(var);
+    }
+    current_scope = scope->parent;
+    free(scope);
+}
+
+
+/**
+ * var_make_local - Make a variable local to the running function.
+ * @name: The variable name.
+ *
+ * Variables are copied on write: the outer value is saved the first time
+ * the name is declared local in a scope, and the variable itself keeps
+ * living in the ordinary store until the scope is popped.
+ *
+ * Return: 0 on success, -1 outside a function or on an invalid name.
+ */
+int var_make_local(const char *name)
+{
+    saved_var *var;
+    const char *value;
+
+    if (current_scope == NULL || !is_valid_name(name, strlen(name))) {
+        return (-1);
+    }
+    for (var = current_scope->saved; var != NULL; var = var->next) {
+        if (stringcmp(var->name, name) == 0) {
+            return (0);
+        }
+    }
+    var = malloc(sizeof(*var));
+    if (var == NULL || (var->name = stringdup(name)) == NULL) {
+        perror("malloc");
+        free(var);
+        return (-1);
+    }
+    value = var_lookup(name);
+    var->value = (value != NULL) ? stringdup(value) : NULL;
+    var->exported = (var_find(name, strlen(name)) == NULL && getenv(name) != NULL);
+    var->next = current_scope->saved;
+    current_scope->saved = var;
+    return (0);
+}